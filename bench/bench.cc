@@ -0,0 +1,555 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of gpsim.
+
+gpsim is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2, or (at your option)
+any later version.
+
+gpsim is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with gpsim; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+// gpsim_bench - micro and macro benchmarks for libgpsim.
+//
+// Microbenchmarks time single operations on the hot paths:
+// instruction dispatch per core family, cycle counter breaks, trace
+// buffer writes, program memory rewrites, node updates and COD
+// parsing. Macrobenchmarks run small firmware images for a fixed
+// number of cycles.
+//
+// Results are written as JSON, with the time per operation and, for
+// anything that executes instructions, the simulated MIPS (millions
+// of instructions executed per second). Macrobenchmarks also report
+// the simulated cycles per second as "mcps", which exceeds the MIPS
+// where the processor sleeps or idle loops are fast-forwarded.
+//
+//   gpsim_bench [--cod FILE] [--output FILE] [--filter SUBSTRING]
+//               [--min-time SECONDS] [--cycles N]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/cosim.h"
+#include "../src/gpsim_time.h"
+#include "../src/interface.h"
+#include "../src/processor.h"
+#include "../src/sim_context.h"
+#include "../src/stimuli.h"
+#include "../src/trace.h"
+#include "../src/util/cod.h"
+#include "../src/util/metrics.h"
+#include "../src/util/program.h"
+
+namespace {
+
+struct Options {
+  std::string cod_file;
+  std::string output;
+  std::string filter;
+  double min_time = 0.5;
+  uint64_t cycles = 2000000;
+};
+
+struct Result {
+  std::string name;
+  std::string kind;
+  uint64_t ops;
+  double seconds;
+  uint64_t instructions;  // Executed, or zero to report no MIPS.
+};
+
+Options opts;
+std::vector<Result> results;
+
+bool selected(const std::string &name)
+{
+  return opts.filter.empty() || name.find(opts.filter) != std::string::npos;
+}
+
+// Calls fn(n) with growing n until it takes at least min_time, and
+// records n operations. fn returns the number of operations done,
+// which may differ from n.
+void run_micro(const std::string &name, bool has_mips, const std::function<uint64_t(uint64_t)> &fn)
+{
+  if (!selected(name))
+    return;
+
+  uint64_t n = 1;
+  while (true) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t ops = fn(n);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (elapsed.count() >= opts.min_time || n >= (uint64_t(1) << 40)) {
+      results.push_back({name, "micro", ops, elapsed.count(), has_mips ? ops : 0});
+      return;
+    }
+
+    n *= elapsed.count() > opts.min_time / 100 ? 2 : 10;
+  }
+}
+
+//------------------------------------------------------------
+// Processors and firmware
+
+struct Firmware {
+  const char *processor;
+  std::vector<unsigned int> code;  // One instruction word per program memory index.
+  std::vector<std::pair<unsigned int, unsigned int>> config = {};  // Address, value.
+};
+
+// Config words with the watchdog disabled.
+const std::vector<std::pair<unsigned int, unsigned int>> no_wdt_12bit = {{0xFFF, 0xFFB}};
+const std::vector<std::pair<unsigned int, unsigned int>> no_wdt_14bit = {{0x2007, 0x3FF7}};
+const std::vector<std::pair<unsigned int, unsigned int>> no_wdt_16bit = {{0x300003, 0x0E}};
+
+// Tight ALU loop: movlw, movwf, incf, addwf, xorlw, btfss, nop, goto.
+const Firmware dispatch_12bit = {"p10f200", {
+    0xC55, 0x030, 0x2B0, 0x1D0, 0xFFF, 0x610, 0x000, 0xA02,
+  }, no_wdt_12bit};
+
+const Firmware dispatch_14bit = {"p16f887", {
+    0x3055, 0x00A0, 0x0AA0, 0x0720, 0x3AFF, 0x1C20, 0x0000, 0x2802,
+  }, no_wdt_14bit};
+
+const Firmware dispatch_16bit = {"p18f452", {
+    0x0E55, 0x6E20, 0x2A20, 0x2420, 0x0AFF, 0xA020, 0x0000, 0xEF02, 0xF000,
+  }, no_wdt_16bit};
+
+// TMR0 overflow interrupt every 512 cycles, main loop counting.
+const Firmware timer_isr = {"p16f887", {
+    0x2805,                                  // goto start
+    0x0000, 0x0000, 0x0000,
+    0x2810,                                  // goto isr
+    0x1683, 0x3000, 0x0081, 0x1283,          // start: OPTION_REG = 0
+    0x30A0, 0x008B,                          // INTCON = GIE | T0IE
+    0x0AA0, 0x280B,                          // loop: incf 0x20; goto loop
+    0x0000, 0x0000, 0x0000,
+    0x0AA1, 0x110B, 0x0009,                  // isr: incf 0x21; bcf T0IF; retfie
+  }, no_wdt_14bit};
+
+// Polls for TMR0 overflow at 1:256 prescale, counting them.
+const Firmware poll_tmr0 = {"p16f887", {
+    0x1683, 0x3007, 0x0081, 0x1283,          // OPTION_REG = PS2:0
+    0x1D0B, 0x2804,                          // loop: wait for T0IF
+    0x110B, 0x0AA0, 0x2804,                  // clear T0IF; incf 0x20; goto loop
+  }, no_wdt_14bit};
+
+// Sends a byte on the USART, waits for it to come back on RX, and
+// sends the next. The bench ties TX and RX together.
+const Firmware uart_echo = {"p16f887", {
+    0x1683, 0x3024, 0x0098, 0x3000, 0x0099,  // TXSTA = TXEN | BRGH; SPBRG = 0
+    0x1283, 0x3090, 0x0098,                  // RCSTA = SPEN | CREN
+    0x0820, 0x0099,                          // loop: TXREG = 0x20
+    0x1E8C, 0x280A,                          // wait for RCIF
+    0x081A, 0x00A0, 0x0AA0, 0x2808,          // 0x20 = RCREG + 1; goto loop
+  }, no_wdt_14bit};
+
+// MSSP SPI master at Fosc/4, streaming bytes.
+const Firmware spi_stream = {"p16f887", {
+    0x1683, 0x30D7, 0x0087, 0x1283,          // TRISC = 0xD7 (SCK, SDO out)
+    0x3020, 0x0094,                          // SSPCON = SSPEN
+    0x0AA0, 0x0820, 0x0093,                  // loop: SSPBUF = ++0x20
+    0x1D8C, 0x2809, 0x118C, 0x2806,          // wait for SSPIF; clear; goto loop
+  }, no_wdt_14bit};
+
+// Sleeps until the WDT wakes it up, over and over.
+const Firmware sleep_wdt = {"p16f887", {
+    0x1703, 0x3001, 0x0085, 0x1303,          // WDTCON = SWDTEN
+    0x0063, 0x0AA0, 0x2804,                  // loop: sleep; incf 0x20; goto loop
+  }, no_wdt_14bit};
+
+// Writes the firmware and its configuration, then resets.
+void flash(Processor *cpu, const Firmware &fw)
+{
+  for (unsigned int i = 0; i < fw.code.size(); ++i)
+    cpu->init_program_memory_at_index(i, fw.code[i]);
+
+  for (const auto &cfg : fw.config)
+    cpu->set_config_word(cfg.first, cfg.second);
+
+  cpu->reset(POR_RESET);
+}
+
+// Processors are created once per type and reused, since a
+// processor is reset by loading new firmware anyway.
+Processor *load(const Firmware &fw)
+{
+  static CSimulationContext ctx;
+  static std::map<std::string, Processor*> cpus;
+  static std::map<Processor*, std::size_t> loaded;
+
+  Processor *&cpu = cpus[fw.processor];
+  if (!cpu) {
+    std::string name = std::string("bench_") + fw.processor;
+    cpu = ctx.add_processor(fw.processor, name.c_str());
+
+    if (!cpu) {
+      std::cerr << "gpsim_bench: cannot create processor " << fw.processor << std::endl;
+      std::exit(1);
+    }
+  }
+
+  // Blank out what is left of the previous image.
+  std::size_t size = fw.code.size();
+  for (std::size_t i = size; i < loaded[cpu]; ++i)
+    cpu->init_program_memory_at_index(i, 0);
+  loaded[cpu] = size;
+
+  flash(cpu, fw);
+
+  return cpu;
+}
+
+// Runs the processor for the given number of cycles.
+uint64_t run_cycles(Processor *cpu, uint64_t cycles)
+{
+  uint64_t start = get_cycles().get();
+
+  cpu->step_cycles(cycles);
+
+  return get_cycles().get() - start;
+}
+
+//------------------------------------------------------------
+// Microbenchmarks
+
+void bench_dispatch()
+{
+  const std::pair<const char*, const Firmware*> families[] = {
+    {"dispatch/12bit", &dispatch_12bit},
+    {"dispatch/14bit", &dispatch_14bit},
+    {"dispatch/16bit", &dispatch_16bit},
+  };
+
+  for (const auto &f : families) {
+    if (!selected(f.first))
+      continue;
+
+    Processor *cpu = load(*f.second);
+    run_micro(f.first, true, [cpu](uint64_t n) { return run_cycles(cpu, n); });
+  }
+
+  if (selected("dispatch/16bit_translated")) {
+    Processor *cpu = load(dispatch_16bit);
+
+    cpu->enable_translation(true);
+    run_micro("dispatch/16bit_translated", true, [cpu](uint64_t n) { return run_cycles(cpu, n); });
+    cpu->enable_translation(false);
+  }
+}
+
+class NopTrigger : public TriggerObject
+{
+public:
+  void callback() override {}
+};
+
+void bench_cycle_counter()
+{
+  for (unsigned int pending : {0U, 16U, 256U}) {
+    std::vector<NopTrigger> others(pending);
+    NopTrigger t;
+    Cycle_Counter &cycles = get_cycles();
+    uint64_t far = cycles.get() + 1000000000;
+
+    for (unsigned int i = 0; i < pending; ++i)
+      cycles.set_break(far + 2 * i, &others[i]);
+
+    // Lands in the middle of the pending breaks.
+    uint64_t at = far + pending + 1;
+
+    run_micro("cycle_counter/set_clear/" + std::to_string(pending), false, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) {
+        cycles.set_break(at, &t);
+        cycles.clear_break(&t);
+      }
+      return n;
+    });
+
+    cycles.set_break(at, &t);
+    run_micro("cycle_counter/reassign/" + std::to_string(pending), false, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) {
+        cycles.reassign_break(at, at + 2, &t);
+        cycles.reassign_break(at + 2, at, &t);
+      }
+      return 2 * n;
+    });
+    cycles.clear_break(&t);
+
+    for (auto &o : others)
+      cycles.clear_break(&o);
+  }
+}
+
+void bench_trace()
+{
+  trace::TraceBuffer buffer(1 << 16);
+
+  run_micro("trace/emplace", false, [&](uint64_t n) {
+    for (uint64_t i = 0; i < n; ++i)
+      buffer.emplace<trace::WriteRegisterEntry>(i & 0xFFF, i & 0xFF);
+    return n;
+  });
+}
+
+// Rewrites a 32 word row of program memory, alternating between two
+// images, as a bootloader would. Each op is one word.
+void bench_program_memory()
+{
+  if (!selected("program_memory/row_write"))
+    return;
+
+  Processor *cpu = load(dispatch_16bit);
+  unsigned int rows[2][32];
+
+  for (unsigned int i = 0; i < 32; ++i) {
+    rows[0][i] = 0x2400 | i;
+    rows[1][i] = 0x2600 | i;
+  }
+
+  run_micro("program_memory/row_write", false, [cpu, &rows](uint64_t n) {
+    for (uint64_t i = 0; i < n / 32; ++i)
+      cpu->write_program_memory_row(0x100, rows[i & 1], 32);
+    return n / 32 * 32;
+  });
+}
+
+void bench_node_update()
+{
+  for (int fanout : {2, 8, 32}) {
+    std::string name = "stimulus_node/update/" + std::to_string(fanout);
+    if (!selected(name))
+      continue;
+
+    Stimulus_Node node(("bench_node" + std::to_string(fanout)).c_str());
+    std::vector<stimulus*> stims;
+
+    for (int i = 0; i < fanout; ++i) {
+      stims.push_back(new stimulus(nullptr, 0.0, 1e3 * (i + 1)));
+      node.attach_stimulus(stims.back());
+    }
+
+    run_micro(name, false, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) {
+        stims[0]->set_Vth((i & 1) ? 5.0 : 0.0);
+        node.update();
+      }
+      return n;
+    });
+
+    for (auto *s : stims) {
+      node.detach_stimulus(s);
+      delete s;
+    }
+  }
+}
+
+void bench_cod()
+{
+  if (!selected("cod/read_program"))
+    return;
+
+  if (opts.cod_file.empty()) {
+    std::cerr << "gpsim_bench: no --cod file, skipping cod/read_program" << std::endl;
+    return;
+  }
+
+  std::ifstream f(opts.cod_file, std::ios::binary);
+  std::stringstream contents;
+  contents << f.rdbuf();
+  std::string data = contents.str();
+
+  run_micro("cod/read_program", false, [&](uint64_t n) {
+    for (uint64_t i = 0; i < n; ++i) {
+      util::Program prog;
+      std::istringstream is(data);
+
+      if (util::CODFileReader::read_program(&prog, &is) || prog.build_indices()) {
+        std::cerr << "gpsim_bench: failed to read " << opts.cod_file << std::endl;
+        std::exit(1);
+      }
+    }
+    return n;
+  });
+}
+
+//------------------------------------------------------------
+// Macrobenchmarks
+
+void run_macro(const std::string &name, const Firmware &fw,
+               const std::function<void(Processor*)> &setup = {},
+               const std::function<void()> &teardown = {})
+{
+  if (!selected(name))
+    return;
+
+  // A reset leaves peripheral state outside registers, like pending
+  // cycle breaks, so each firmware gets a new processor on its own
+  // cycle counter.
+  CoSimulation sim(1);
+  Processor *cpu = sim.add_processor(fw.processor, "bench_macro");
+  if (!cpu) {
+    std::cerr << "gpsim_bench: cannot create processor " << fw.processor << std::endl;
+    std::exit(1);
+  }
+
+  CoSimulation::Scope scope(&sim, cpu);
+  flash(cpu, fw);
+  if (setup)
+    setup(cpu);
+
+  using util::metrics::IDLE_INSTRUCTIONS;
+
+  // Fast-forwarded instructions count as executed, but did not run.
+  auto executed = [cpu]() {
+    return cpu->instructions_executed.get() - util::metrics::collect().counters[IDLE_INSTRUCTIONS];
+  };
+
+  uint64_t instructions = executed();
+  auto start = std::chrono::steady_clock::now();
+  uint64_t cycles = run_cycles(cpu, opts.cycles);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  instructions = executed() - instructions;
+
+  results.push_back({name, "macro", cycles, elapsed.count(), instructions});
+
+  if (teardown)
+    teardown();
+}
+
+void bench_macro()
+{
+  run_macro("firmware/timer_isr", timer_isr);
+  run_macro("firmware/poll_tmr0", poll_tmr0);
+
+  // RC6 (TX) looped back to RC7 (RX).
+  Stimulus_Node *uart_node = nullptr;
+  stimulus *uart_pins[2] = {};
+
+  run_macro("firmware/uart_echo", uart_echo, [&](Processor *cpu) {
+    uart_pins[0] = dynamic_cast<stimulus*>(cpu->findSymbol("portc6"));
+    uart_pins[1] = dynamic_cast<stimulus*>(cpu->findSymbol("portc7"));
+    if (uart_pins[0] && uart_pins[1]) {
+      uart_node = new Stimulus_Node("bench_uart");
+      uart_node->attach_stimulus(uart_pins[0]);
+      uart_node->attach_stimulus(uart_pins[1]);
+    }
+  }, [&]() {
+    if (uart_node) {
+      uart_node->detach_stimulus(uart_pins[0]);
+      uart_node->detach_stimulus(uart_pins[1]);
+      delete uart_node;
+    }
+  });
+
+  run_macro("firmware/spi_stream", spi_stream);
+  run_macro("firmware/sleep_wdt", sleep_wdt);
+}
+
+//------------------------------------------------------------
+
+void write_json(std::ostream &os)
+{
+#ifdef __EMSCRIPTEN__
+  const char *host = "wasm";
+#else
+  const char *host = "native";
+#endif
+
+  os << "{\n  \"host\": \"" << host << "\",\n  \"benchmarks\": [";
+
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const auto &r = results[i];
+    char line[512];
+
+    snprintf(line, sizeof(line),
+             "%s\n    {\"name\": \"%s\", \"kind\": \"%s\", \"ops\": %llu, \"seconds\": %.6f, \"ns_per_op\": %.3f",
+             i ? "," : "", r.name.c_str(), r.kind.c_str(), (unsigned long long) r.ops, r.seconds,
+             r.ops ? r.seconds * 1e9 / r.ops : 0.0);
+    os << line;
+
+    if (r.instructions) {
+      snprintf(line, sizeof(line), ", \"mips\": %.3f", r.seconds > 0 ? r.instructions / r.seconds / 1e6 : 0.0);
+      os << line;
+    }
+
+    if (r.kind == "macro") {
+      snprintf(line, sizeof(line), ", \"mcps\": %.3f", r.seconds > 0 ? r.ops / r.seconds / 1e6 : 0.0);
+      os << line;
+    }
+
+    os << '}';
+  }
+
+  os << "\n  ]\n}\n";
+}
+
+void usage()
+{
+  std::cerr << "usage: gpsim_bench [--cod FILE] [--output FILE] [--filter SUBSTRING]\n"
+               "                   [--min-time SECONDS] [--cycles N]\n";
+  std::exit(2);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+
+    if (i + 1 >= argc)
+      usage();
+
+    if (arg == "--cod")
+      opts.cod_file = argv[++i];
+    else if (arg == "--output")
+      opts.output = argv[++i];
+    else if (arg == "--filter")
+      opts.filter = argv[++i];
+    else if (arg == "--min-time")
+      opts.min_time = std::atof(argv[++i]);
+    else if (arg == "--cycles")
+      opts.cycles = std::strtoull(argv[++i], nullptr, 0);
+    else
+      usage();
+  }
+
+  initialize_gpsim_core();
+
+  bench_dispatch();
+  bench_cycle_counter();
+  bench_trace();
+  bench_program_memory();
+  bench_node_update();
+  bench_cod();
+  bench_macro();
+
+  if (opts.output.empty()) {
+    write_json(std::cout);
+  } else {
+    std::ofstream f(opts.output);
+    write_json(f);
+  }
+
+  return 0;
+}
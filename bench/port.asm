@@ -0,0 +1,12 @@
+	list	p=16f887
+	include	<p16f887.inc>
+	movlw	0xFE		; RA0 is the only input.
+	banksel	TRISA
+	movwf	TRISA
+
+	banksel	PORTB
+	movf	PORTB, W	; Copy PORTB to PORTA once, then stop.
+	banksel	PORTA
+	movwf	PORTA
+	sleep
+	end
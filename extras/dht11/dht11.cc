@@ -133,6 +133,12 @@ class dht11Module::Pin : public IO_open_collector
       }
     }
 
+    virtual bool add_thresholds(std::vector<double> &thresholds)
+    {
+      thresholds.push_back(1.5);
+      return IO_open_collector::add_thresholds(thresholds);
+    }
+
     void setDrivingState(bool new_state) {
       Dprintf(("new_state=%d\n",new_state));
       bDrivingState = new_state;
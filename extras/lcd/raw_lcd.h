@@ -43,6 +43,7 @@ public:
   LCD_7Segments *_lcd_7seg;
 
   virtual void set_nodeVoltage(double v);
+  virtual bool add_thresholds(std::vector<double> &) { return false; }
   virtual void callback();
   guint64 future_cycle;
 };
@@ -35,13 +35,16 @@ Boston, MA 02111-1307, USA.  */
 #include <cstring>
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <list>
 #include <map>
 #include <memory>
 #include <string>
+#include <thread>
 #include <typeinfo>
 #include <utility>
+#include <vector>
 
 #include "../src/errors.h"
 #include "../src/gpsim_object.h"
@@ -87,19 +90,26 @@ static void treeselect_module(GuiModule *p);
 #define YSIZE LAYOUTSIZE_Y/ROUTE_RES
 
 
-/* If HMASK is set in board_matrix, then this position
- is unavailable for horizontal track */
-#define HMASK 1
-#define VMASK 2
 /*
- board matrix contains information about how a track can be routed.
+ board contains information about how a track can be routed. It only
+ holds module packages and pins; traces are added to copies of it.
  */
-static unsigned char *board_matrix;
-// mask_matrix is used by trace_two_poins to know where is has been, and
-// how quickly it came here. (depth is stored here if lower)
-static unsigned short *mask_matrix;
-static unsigned int xsize;
-static unsigned int ysize;
+static BoardRouter board;
+
+// Traced nets, drawn by layout_expose.
+static std::vector<BoardRouter::Net> routed_nets;
+// Traced nets hidden while a module is dragged, so only the nets it
+// disturbed are traced again.
+static std::vector<BoardRouter::Net> dragged_nets;
+
+// Nets are traced on a thread, and the result is dropped if the board
+// has changed since, which bumps route_generation.
+static std::atomic<unsigned int> route_generation(0);
+
+// The window the traced nets are shown in. Jobs only carry their
+// generation, and the window's destructor bumps it, so a finished job
+// only reaches the window through here while it is still alive.
+static Breadboard_Window *routing_window = nullptr;
 
 
 //========================================================================
@@ -132,330 +142,15 @@ BB_ModuleLabel::~BB_ModuleLabel()
 }
 
 
-static inline unsigned char *board_matrix_pt(unsigned int x, unsigned int y)
-{
-  if (x < xsize && y < ysize) {
-    return board_matrix + y * xsize + x;
-  }
-  return nullptr;
-}
-
-
-static inline unsigned short *mask_matrix_pt(unsigned int x, unsigned int y)
-{
-  if (x < xsize && y < ysize) {
-    return mask_matrix + (y * xsize + x);
-  }
-  return nullptr;
-}
-
-
-/* Check the flags in board_matrix to see if we are allowed to
-   route horizontally here */
-static inline bool allow_horiz(const point &p)
-{
-  unsigned char *pt = board_matrix_pt(p.x, p.y);
-
-  if (pt && !(*pt & HMASK)) {
-    return true;
-  }
-
-  return false;
-}
-
-
-/* Check the flags in board_matrix to see if we are allowed to
-   route vertically here */
-static inline bool allow_vert(const point &p)
-{
-  unsigned char *pt = board_matrix_pt(p.x, p.y);
-
-  if (pt && !(*pt & VMASK)) {
-    return true;
-  }
-
-  return false;
-}
-
-
-// Find the direction to go to get from s to e if there are no obstacles.
-static inline route_direction calculate_route_direction(point s, point e)
-{
-  if (abs(s.x - e.x) > abs(s.y - e.y)) {
-    // Left or right
-    if (s.x < e.x) {
-      return R_RIGHT;
-    }
-
-    return R_LEFT;
-  }
-
-  if (s.y < e.y) {
-    return R_UP;
-  }
-
-  return R_DOWN;
-}
-
-
-// Put point p as first point in pat
-static void prepend_point_to_path(std::list<path> &pat, point p)
-{
-  route_direction dir = R_NONE;
-  path new_point;
-  new_point.p = p;
-
-  if (!pat.empty()) {
-    dir = calculate_route_direction(p, pat.front().p);
-
-    if (pat.front().dir == R_NONE) {
-      pat.front().dir = dir;
-    }
-  }
-
-  new_point.dir = dir;
-  pat.push_front(new_point);
-}
-
-// maxdepth is shortest path from start to end
-static unsigned short maxdepth;
-
-
-// Penalty for making a turn in a trace
-
-static int turnq(route_direction a, route_direction b)
-{
-  return (a != b) * 10;
-}
-
-
-/*
-This is an recursive routine that tries to find a path between p and end.
-*/
-static bool trace_two_points(std::list<path> &pat,   // Pointer to resulting path
-                             point p,  // Where we are now
-                             point end,    // Where we want to go
-                             int depth,
-                             route_direction lastdir)    // How deep in we are
-{
-  point up, left, right, down;
-
-  if (depth == 0) {
-    // Initialize mask_matrix and maxdepth on first call
-    //maxdepth=500;
-    for (int x = 0; x < (int)xsize; x++) {
-      for (int y = 0; y < (int)ysize; y++) {
-        *mask_matrix_pt(x, y) = maxdepth;
-      }
-    }
-
-    pat.clear();
-  }
-
-  ////////////////////////////////////////
-  // Recusion termination
-  ////////////////////////////////////////
-  if (depth > maxdepth) {
-    return false;
-  }
-
-  if (depth > *mask_matrix_pt(p.x, p.y)) {
-    return false;
-  }
-
-  if (abs(p.x - end.x) + abs(p.y - end.y) + depth > maxdepth) {
-    return false;
-  }
-
-  if (p.x == end.x && p.y == end.y) {
-    // We are at end point
-    if (depth < maxdepth) {
-      // We found a new shortest path.
-      //printf("Found path with length %d\n",depth);
-      maxdepth = depth;
-      pat.clear();
-      prepend_point_to_path(pat, p);
-      return true;
-    }
-
-    return false;
-  }
-
-  // Store new (closer) depth in mask_matrix.
-  *mask_matrix_pt(p.x, p.y) = depth;
-  // Find the general direction we want to go
-  route_direction dir = calculate_route_direction(p, end);
-  // Recursion return value
-  bool retval = false;
-  // Convenience
-  up = p;
-  up.y++;
-  down = p;
-  down.y--;
-  left = p;
-  left.x--;
-  right = p;
-  right.x++;
-
-  /* Depending on where we wish to go, do recursion so that we likely
-     will quickly find at least some kind of path to end.
-
-     If we don't do that maxdepth will stay large, and the traceing will
-     likely take a long time.
-
-     We use allow_vert and allow_horiz to determine if the movement is
-     allowed, of if there is something in our way.
-
-  */
-
-  switch (dir) {
-  case R_UP:
-    if (allow_vert(up)) {
-      retval |= trace_two_points(pat, up, end, depth + 1 + turnq(lastdir, R_UP), R_UP);
-    }
-
-    if (p.x < end.x) {
-      if (allow_horiz(right)) {
-        retval |= trace_two_points(pat, right, end, depth + 1 + turnq(lastdir, R_RIGHT), R_RIGHT);
-      }
-
-      if (allow_horiz(left)) {
-        retval |= trace_two_points(pat, left, end, depth + 1 + turnq(lastdir, R_LEFT), R_LEFT);
-      }
-
-    } else {
-      if (allow_horiz(left)) {
-        retval |= trace_two_points(pat, left, end, depth + 1 + turnq(lastdir, R_LEFT), R_LEFT);
-      }
-
-      if (allow_horiz(right)) {
-        retval |= trace_two_points(pat, right, end, depth + 1 + turnq(lastdir, R_RIGHT), R_RIGHT);
-      }
-    }
-
-    if (allow_vert(down)) {
-      retval |= trace_two_points(pat, down, end, depth + 1 + turnq(lastdir, R_DOWN), R_DOWN);
-    }
-
-    break;
-
-  case R_DOWN:
-    if (allow_vert(down)) {
-      retval |= trace_two_points(pat, down, end, depth + 1 + turnq(lastdir, R_DOWN), R_DOWN);
-    }
-
-    if (p.x < end.x) {
-      if (allow_horiz(right)) {
-        retval |= trace_two_points(pat, right, end, depth + 1 + turnq(lastdir, R_RIGHT), R_RIGHT);
-      }
-
-      if (allow_horiz(left)) {
-        retval |= trace_two_points(pat, left, end, depth + 1 + turnq(lastdir, R_LEFT), R_LEFT);
-      }
-
-    } else {
-      if (allow_horiz(left)) {
-        retval |= trace_two_points(pat, left, end, depth + 1 + turnq(lastdir, R_LEFT), R_LEFT);
-      }
-
-      if (allow_horiz(right)) {
-        retval |= trace_two_points(pat, right, end, depth + 1 + turnq(lastdir, R_RIGHT), R_RIGHT);
-      }
-    }
-
-    if (allow_vert(up)) {
-      retval |= trace_two_points(pat, up, end, depth + 1 + turnq(lastdir, R_UP), R_UP);
-    }
-
-    break;
-
-  case R_LEFT:
-    if (allow_horiz(left)) {
-      retval |= trace_two_points(pat, left, end, depth + 1 + turnq(lastdir, R_LEFT), R_LEFT);
-    }
-
-    if (p.y < end.y) {
-      if (allow_vert(up)) {
-        retval |= trace_two_points(pat, up, end, depth + 1 + turnq(lastdir, R_UP), R_UP);
-      }
-
-      if (allow_vert(down)) {
-        retval |= trace_two_points(pat, down, end, depth + 1 + turnq(lastdir, R_DOWN), R_DOWN);
-      }
-
-    } else {
-      if (allow_vert(down)) {
-        retval |= trace_two_points(pat, down, end, depth + 1 + turnq(lastdir, R_DOWN), R_DOWN);
-      }
-
-      if (allow_vert(up)) {
-        retval |= trace_two_points(pat, up, end, depth + 1 + turnq(lastdir, R_UP), R_UP);
-      }
-    }
-
-    if (allow_horiz(right)) {
-      retval |= trace_two_points(pat, right, end, depth + 1 + turnq(lastdir, R_RIGHT), R_RIGHT);
-    }
-
-    break;
-
-  case R_RIGHT:
-    if (allow_horiz(right)) {
-      retval |= trace_two_points(pat, right, end, depth + 1 + turnq(lastdir, R_RIGHT), R_RIGHT);
-    }
-
-    if (p.y < end.y) {
-      if (allow_vert(up)) {
-        retval |= trace_two_points(pat, up, end, depth + 1 + turnq(lastdir, R_UP), R_UP);
-      }
-
-      if (allow_vert(down)) {
-        retval |= trace_two_points(pat, down, end, depth + 1 + turnq(lastdir, R_DOWN), R_DOWN);
-      }
-
-    } else {
-      if (allow_vert(down)) {
-        retval |= trace_two_points(pat, down, end, depth + 1 + turnq(lastdir, R_DOWN), R_DOWN);
-      }
-
-      if (allow_vert(up)) {
-        retval |= trace_two_points(pat, up, end, depth + 1 + turnq(lastdir, R_UP), R_UP);
-      }
-    }
-
-    if (allow_horiz(left)) {
-      retval |= trace_two_points(pat, left, end, depth + 1 + turnq(lastdir, R_LEFT), R_LEFT);
-    }
-
-    break;
-
-  case R_NONE:
-    break;
-  }
-
-  // Check if some of the recursive traces went well.
-  if (retval) {
-    // We found a path to end. Add point p to path.
-    // This is first or second point.
-    prepend_point_to_path(pat, p);
-    return true;
-  }
-
-  return false;
-}
-
-
-static std::vector<std::list<path>> nodepath_list;
-
-
-// Clear nodes in nodepath_list
+// Clear traced nets, and drop those still being traced.
 void Breadboard_Window::clear_nodes()
 {
-  nodepath_list.clear();
+  ++route_generation;
+  routed_nets.clear();
 }
 
 
-// Draw node in nodepath_list
+// Draw traced nets
 void Breadboard_Window::draw_nodes()
 {
   gtk_widget_queue_draw(layout);
@@ -469,15 +164,18 @@ gboolean Breadboard_Window::layout_expose(GtkWidget *,
   cairo_set_source_rgba(cr, 0.0, 0.0, 0.0, 1.0);
   cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
   cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
-  auto iter = nodepath_list.begin();
 
-  for (; iter != nodepath_list.end(); ++iter) {
-    std::list<path>::const_iterator current_path = (*iter).begin();
+  for (const auto &net : routed_nets) {
+    if (net.route.empty()) {
+      continue;
+    }
+
+    auto current_path = net.route.begin();
     int last_x = current_path->p.x * ROUTE_RES;
     int last_y = current_path->p.y * ROUTE_RES;
     cairo_move_to(cr, last_x, last_y);
 
-    for (++current_path; current_path != (*iter).end(); ++current_path) {
+    for (++current_path; current_path != net.route.end(); ++current_path) {
       int x = current_path->p.x * ROUTE_RES;
       int y = current_path->p.y * ROUTE_RES;
       cairo_line_to(cr, x, y);
@@ -490,38 +188,17 @@ gboolean Breadboard_Window::layout_expose(GtkWidget *,
 }
 
 
-// Here we fill board_matrix with module packages, so that trace_two_points
-// know not to trace over them.
+// Here we fill board with module packages, so that the router
+// knows not to trace over them.
 void Breadboard_Window::update_board_matrix()
 {
   int x, y, width, height;
   int i;
   gtk_window_get_size(GTK_WINDOW(window), &width, &height);
 
-  if (width / ROUTE_RES > (int)xsize || height / ROUTE_RES > (int)ysize) {
-    xsize = width / ROUTE_RES;
-    ysize = height / ROUTE_RES;
-    delete [] board_matrix;
-    delete [] mask_matrix;
-    board_matrix = new unsigned char[xsize * ysize];
-    mask_matrix = new unsigned short[xsize * ysize];
-  }
-
-  // Clear first.
-  std::fill_n(board_matrix, xsize * ysize, '\0');
-
-  // Mark board outline, so we limit traces here
-  for (x = 0; x < (int)xsize; x++) {
-    *board_matrix_pt(x, 0) = (HMASK | VMASK);
-    *board_matrix_pt(x, ysize - 1) = (HMASK | VMASK);
-  }
-
-  for (y = 0; y < (int)ysize; y++) {
-    *board_matrix_pt(0, y) = (HMASK | VMASK);
-    *board_matrix_pt(xsize - 1, y) = (HMASK | VMASK);
-  }
+  board.resize(width / ROUTE_RES, height / ROUTE_RES);
 
-  // Loop all modules, and put its package and pins to board_matrix
+  // Loop all modules, and put its package and pins to board
   auto mi = modules.begin();
 
   for (; mi != modules.end(); ++mi) {
@@ -532,15 +209,15 @@ void Breadboard_Window::update_board_matrix()
       height = p->height();
 
       for (y = p->y() - ROUTE_RES;
-           y < p->y() + height + ROUTE_RES && y / ROUTE_RES < (int)ysize;
+           y < p->y() + height + ROUTE_RES && y / ROUTE_RES < (int)board.ysize();
            y += ROUTE_RES) {
         for (x = p->x();
-             x < p->x() + width && x / ROUTE_RES < (int)xsize;
+             x < p->x() + width && x / ROUTE_RES < (int)board.xsize();
              x += ROUTE_RES) {
-          unsigned char *pt = board_matrix_pt(x / ROUTE_RES, y / ROUTE_RES);
+          unsigned char *pt = board.at(x / ROUTE_RES, y / ROUTE_RES);
 
           if (pt) {
-            *pt = (HMASK | VMASK);
+            *pt = (BoardRouter::HMASK | BoardRouter::VMASK);
           }
         }
       }
@@ -558,10 +235,10 @@ void Breadboard_Window::update_board_matrix()
           for (x = gp->x() -  PINLENGTH;
                x < gp->x() + gp->width();
                x += ROUTE_RES) {
-            unsigned char *pt = board_matrix_pt(x / ROUTE_RES, y / ROUTE_RES);
+            unsigned char *pt = board.at(x / ROUTE_RES, y / ROUTE_RES);
 
             if (pt) {
-              *pt = (HMASK | VMASK);
+              *pt = (BoardRouter::HMASK | BoardRouter::VMASK);
             }
           }
 
@@ -570,10 +247,10 @@ void Breadboard_Window::update_board_matrix()
           for (x = gp->x() -  PINLENGTH;
                x < gp->x() + gp->width();
                x += ROUTE_RES) {
-            unsigned char *pt = board_matrix_pt(x / ROUTE_RES, y / ROUTE_RES);
+            unsigned char *pt = board.at(x / ROUTE_RES, y / ROUTE_RES);
 
             if (pt) {
-              *pt = (HMASK | VMASK);
+              *pt = (BoardRouter::HMASK | BoardRouter::VMASK);
             }
           }
 
@@ -585,10 +262,10 @@ void Breadboard_Window::update_board_matrix()
           for (x = gp->x() - PINLENGTH;
                x < gp->x() + gp->width();
                x += ROUTE_RES) {
-            unsigned char *pt = board_matrix_pt(x / ROUTE_RES, y / ROUTE_RES);
+            unsigned char *pt = board.at(x / ROUTE_RES, y / ROUTE_RES);
 
             if (pt) {
-              *pt = (HMASK | VMASK);
+              *pt = (BoardRouter::HMASK | BoardRouter::VMASK);
             }
           }
 
@@ -597,10 +274,10 @@ void Breadboard_Window::update_board_matrix()
           for (x = gp->x() - PINLENGTH;
                x < gp->x() + gp->width();
                x += ROUTE_RES) {
-            unsigned char *pt = board_matrix_pt(x / ROUTE_RES, y / ROUTE_RES);
+            unsigned char *pt = board.at(x / ROUTE_RES, y / ROUTE_RES);
 
             if (pt) {
-              *pt = (HMASK | VMASK);
+              *pt = (BoardRouter::HMASK | BoardRouter::VMASK);
             }
           }
 
@@ -618,209 +295,127 @@ void Breadboard_Window::update_board_matrix()
 }
 
 
-// Add path to board_matrix. This will make trace_two_point to not trace
-// at its place. It can trace over it when in straight angle.
-static void add_path_to_matrix(const std::list<path> &pat)
-{
-  int x = -1;
-  int y = -1;
-  auto iter = pat.begin();
-
-  if (iter != pat.end()) {
-    x = iter->p.x;
-    y = iter->p.y;
-    ++iter;
-  }
-
-  for (; iter != pat.end(); ++iter) {
-    unsigned char *pt = board_matrix_pt(x, y);
-
-    if (pt && (iter->dir == R_LEFT || iter->dir == R_RIGHT)) {
-      *pt |= HMASK;
-    }
-
-    if (pt && (iter->dir == R_DOWN || iter->dir == R_UP)) {
-      *pt |= VMASK;
-    }
-
-    while (x != iter->p.x || y != iter->p.y) {
-      if (x < iter->p.x) {
-        x++;
-      }
-
-      if (x > iter->p.x) {
-        x--;
-      }
+static GuiPin *find_gui_pin(Breadboard_Window *bbw, stimulus *pin);
 
-      if (y < iter->p.y) {
-        y++;
-      }
 
-      if (y > iter->p.y) {
-        y--;
-      }
-
-      pt = board_matrix_pt(x, y);
+// The grid positions of the pins of a node.
+static BoardRouter::Net net_of(gui_node *gn)
+{
+  BoardRouter::Net net;
+  net.key = gn;
 
-      if (pt && (iter->dir == R_LEFT || iter->dir == R_RIGHT)) {
-        *pt |= HMASK;
-      }
+  for (stimulus *s = gn->node->stimuli; s; s = s->next) {
+    GuiPin *p = find_gui_pin(gn->bbw, s);
 
-      if (pt && (iter->dir == R_DOWN || iter->dir == R_UP)) {
-        *pt |= VMASK;
-      }
+    if (p) {
+      point pos = { p->x() / ROUTE_RES, p->y() / ROUTE_RES };
+      net.pins.push_back(pos);
     }
   }
-}
 
+  return net;
+}
 
-static GuiPin *find_gui_pin(Breadboard_Window *bbw, stimulus *pin);
 
-static int pathlen[100][100];
+//
+// Trace a node, and add result to routed_nets
+// return true if OK, false if it could not find a route
+//
 
-static void reverse_path_if_endpoint(point startpoint, std::list<path> &pat)
+static bool trace_node(gui_node *gn)
 {
-  point pat_start = pat.front().p;
-  point pat_end = pat.back().p;
-  int dist_start = abs(pat_start.x - startpoint.x) + abs(pat_start.y - startpoint.y);
-  int dist_end = abs(pat_end.x - startpoint.x) + abs(pat_end.y - startpoint.y);
+  BoardRouter traced = board;
+  BoardRouter::Net net = net_of(gn);
 
-  if (dist_start > dist_end && dist_end < 5) {
-    // Reverse the list pat
-    pat.reverse();
+  for (const auto &n : routed_nets) {
+    if (n.key != gn) {
+      traced.add_path(n.route);
+    }
   }
-}
-
-
-static void reverse_path_if_startpoint(point startpoint, std::list<path> &pat)
-{
-  point pat_start = pat.front().p;
-  point pat_end = pat.back().p;
-  int dist_start = abs(pat_start.x - startpoint.x) + abs(pat_start.y - startpoint.y);
-  int dist_end = abs(pat_end.x - startpoint.x) + abs(pat_end.y - startpoint.y);
 
-  if (dist_start < dist_end && dist_start < 5) {
-    // Reverse the list pat
-    pat.reverse();
+  if (!traced.route_net(net)) {
+    return false;
   }
-}
 
+  auto iter = std::find_if(routed_nets.begin(), routed_nets.end(),
+                           [gn](const BoardRouter::Net &n) { return n.key == gn; });
 
-static void path_copy_and_cat(std::list<path> &pat, std::list<path> &source)
-{
-  if (!pat.empty()) {
-    reverse_path_if_startpoint(source.front().p, pat);
-    reverse_path_if_endpoint(pat.back().p, source);
+  if (iter != routed_nets.end()) {
+    *iter = std::move(net);
+  } else {
+    routed_nets.push_back(std::move(net));
   }
 
-  pat.insert(pat.end(), source.begin(), source.end());
+  return true;
 }
 
 
-//
-// Trace a node, and add result to nodepath_list
-// return true if OK, false if it could not find a route
-//
-
-static bool trace_node(gui_node *gn)
-{
-  Breadboard_Window *bbw = gn->bbw;;
-  point start = {-1, -1}, end;
-  stimulus *stimulus = gn->node->stimuli;
-  std::vector<GuiPin *> pinlist;
+// A batch of nets traced on a thread, avoiding the kept ones.
+struct RouteJob {
+  unsigned int generation;
+  BoardRouter board;
+  std::vector<BoardRouter::Net> kept;
+  std::vector<BoardRouter::Net> nets;
+  bool ok;
+};
 
-  // Make a glist of all gui_pins in the node
-  while (stimulus) {
-    GuiPin *p = find_gui_pin(bbw, stimulus);
 
-    if (p) {
-      pinlist.push_back(p);
-    }
+// Shows the traced nets. Runs on the UI thread once the job is done.
+static gboolean apply_routes(gpointer data)
+{
+  std::unique_ptr<RouteJob> job(static_cast<RouteJob *>(data));
 
-    stimulus = stimulus->next;
-  }
-
-  // Allocate an array of shortest_paths, indexed with 2x glist position.
-  std::map<std::pair<int, int>, std::list<path>> shortest_path;
-
-  // Trace between all stimulus, and store the distances in the array.
-  for (int i = 0; i < (int)pinlist.size(); i++) {
-    GuiPin *pi = pinlist[i];
-
-    for (int j = i + 1; j < (int)pinlist.size(); j++) {
-      GuiPin *pj = pinlist[j];
-      start.x = pi->x() / ROUTE_RES;
-      start.y = pi->y() / ROUTE_RES;
-      end.x = pj->x() / ROUTE_RES;
-      end.y = pj->y() / ROUTE_RES;
-      //    printf("Tracing from %d,%d to %d,%d\n",start.x,start.y,end.x,end.y);
-      maxdepth = abs(start.x - end.x) + abs(start.y - end.y);
-      maxdepth = maxdepth * 2 + 100; // Twice the distance, and 5 turns
-      //    printf("Trying maxdepth %d\n",maxdepth);
-      const std::pair<int, int> coord = std::make_pair(i, j);
-      const std::pair<int, int> coord2 = std::make_pair(j, i);
-      trace_two_points(shortest_path[coord], start, end, 0, R_UP);
-
-      if (shortest_path[coord].empty()) {
-        //printf("\n### Couldn't trace from pin %s to pin %s!\n",
-        //  pi->getIOpin()->name().c_str(),
-        //  pj->getIOpin()->name().c_str());
-        return false;
-      }
+  Breadboard_Window *bbw = routing_window;
 
-      pathlen[i][j] = maxdepth;
-      pathlen[j][i] = maxdepth;
-      shortest_path[coord2] = shortest_path[coord];
-    }
+  if (job->generation != route_generation || !bbw) {
+    return FALSE;
   }
 
-  int *permutations = new int[pinlist.size()];
-  int *shortest_permutation = new int[pinlist.size()];
+  routed_nets = std::move(job->kept);
 
-  for (int i = 0; i < (int)pinlist.size(); i++) {
-    permutations[i] = i;
+  for (auto &net : job->nets) {
+    if (!net.route.empty()) {
+      routed_nets.push_back(std::move(net));
+    }
   }
 
-  // Find the combination that produces the shortest node.
-  int minlen = 100000;
-
-  do {
-    int sum = 0;
+  bbw->draw_nodes();
 
-    for (int i = 0; i < (int)pinlist.size() - 1; i++) {
-      sum += pathlen[permutations[i]][permutations[i + 1]];
-    }
+  gtk_label_set_text(GTK_LABEL(bbw->status_line), job->ok ? "" : "Cannot trace all nodes");
 
-    if (sum < minlen) {
-      minlen = sum;
-      std::copy(permutations, permutations + pinlist.size(), shortest_permutation);
-    }
+  if (verbose) {
+    puts("Trace all is done.");
+  }
 
-    // Fixme, I'd rather use next_combination().
-  } while (std::next_permutation(permutations, permutations + pinlist.size()));
+  return FALSE;
+}
 
-  std::list<path> nodepath;
 
-  for (int i = 0; i < (int)pinlist.size() - 1; i++) {
-    const std::pair<int, int> coord = std::make_pair(
-                                        shortest_permutation[i],
-                                        shortest_permutation[i + 1]);
-    auto iter = shortest_path.find(coord);
+static void trace_in_background(Breadboard_Window *bbw,
+                                std::vector<BoardRouter::Net> kept,
+                                std::vector<BoardRouter::Net> nets)
+{
+  auto job = new RouteJob;
+  routing_window = bbw;
+  job->generation = ++route_generation;
+  job->board = board;
 
-    if (iter != shortest_path.end()) {
-      path_copy_and_cat(nodepath, iter->second);
-    }
+  for (const auto &net : kept) {
+    job->board.add_path(net.route);
   }
 
-  delete[] permutations;
-  delete[] shortest_permutation;
+  job->kept = std::move(kept);
+  job->nets = std::move(nets);
+  job->ok = false;
 
-  if (!nodepath.empty()) {
-    add_path_to_matrix(nodepath);
-    nodepath_list.push_back(nodepath);
-  }
+  // An older job notices the new generation and stops early.
+  std::thread([job]() {
+    unsigned int threads = std::max(1U, std::thread::hardware_concurrency());
 
-  return true;
+    job->ok = job->board.route_nets(job->nets, threads,
+                                    [job]() { return job->generation != route_generation; });
+    g_idle_add(apply_routes, job);
+  }).detach();
 }
 
 
@@ -1262,6 +857,7 @@ void grab_module(GuiModule *p)
                    GDK_CURRENT_TIME);
   treeselect_module(dragged_module);
   dragging = 1;
+  dragged_nets = std::move(routed_nets);
   p->bbw()->clear_nodes();
   p->bbw()->draw_nodes();
   gtk_widget_set_app_paintable(p->bbw()->layout, FALSE);
@@ -1269,6 +865,7 @@ void grab_module(GuiModule *p)
 
 
 static void trace_all(GtkWidget *button, Breadboard_Window *bbw);
+static void retrace_moved(Breadboard_Window *bbw);
 
 
 void Breadboard_Window::pointer_cb(GtkWidget *w,
@@ -1308,6 +905,7 @@ void Breadboard_Window::pointer_cb(GtkWidget *w,
                          GDK_CURRENT_TIME);
         treeselect_module(dragged_module);
         dragging = 1;
+        dragged_nets = std::move(routed_nets);
         bbw->clear_nodes();
         bbw->draw_nodes();
         gtk_widget_set_app_paintable(bbw->layout, FALSE);
@@ -1327,7 +925,7 @@ void Breadboard_Window::pointer_cb(GtkWidget *w,
       gtk_widget_set_app_paintable(bbw->layout, TRUE);
 
       if (all_trace) {
-        trace_all(w, bbw);
+        retrace_moved(bbw);
       }
 
       UpdateModuleFrame(dragged_module, bbw);
@@ -1945,43 +1543,74 @@ static void clear_traces(GtkWidget *, Breadboard_Window *bbw)
 }
 
 
-static void trace_all(GtkWidget *, Breadboard_Window *bbw)
+// The nodes listed in the tree.
+static std::vector<gui_node *> tree_nodes(Breadboard_Window *bbw)
 {
-  gui_node *gn;
+  std::vector<gui_node *> nodes;
   GtkTreeModel *model;
   GtkTreeIter p_iter, c_iter;
-  bool did_work = true;
-  bbw->update_board_matrix();
 
   if ((model = gtk_tree_view_get_model((GtkTreeView*) bbw->tree)) == nullptr) {
-    return;
+    return nodes;
   }
 
   if (!gtk_tree_model_get_iter_first(model, &p_iter)) {
-    return;
+    return nodes;
   }
 
   if (!gtk_tree_model_iter_children(model, &c_iter, &p_iter)) {
-    return;
+    return nodes;
   }
 
   do {
+    gui_node *gn;
     gtk_tree_model_get(model, &c_iter, 1, &gn, -1);
-
-    if (!trace_node(gn)) {
-      did_work = false;
-    }
+    nodes.push_back(gn);
   } while (gtk_tree_model_iter_next(model, &c_iter));
 
-  bbw->draw_nodes();
+  return nodes;
+}
+
 
-  gtk_label_set_text(GTK_LABEL(bbw->status_line), did_work ? "" : "Cannot trace all nodes");
+static void trace_all(GtkWidget *, Breadboard_Window *bbw)
+{
+  std::vector<BoardRouter::Net> nets;
+  bbw->update_board_matrix();
+
+  for (gui_node *gn : tree_nodes(bbw)) {
+    nets.push_back(net_of(gn));
+  }
+
+  trace_in_background(bbw, std::vector<BoardRouter::Net>(), std::move(nets));
 
   all_trace = 1;
+}
 
-  if (verbose) {
-    puts("Trace all is done.");
+
+// Traces again after a module was moved. Nets whose pins stayed put,
+// and whose traces are still clear of the module, are kept.
+static void retrace_moved(Breadboard_Window *bbw)
+{
+  std::vector<BoardRouter::Net> old = std::move(dragged_nets);
+  std::vector<BoardRouter::Net> kept, nets;
+  BoardRouter traced = board;
+
+  dragged_nets.clear();
+
+  for (gui_node *gn : tree_nodes(bbw)) {
+    BoardRouter::Net net = net_of(gn);
+    auto iter = std::find_if(old.begin(), old.end(),
+                             [gn](const BoardRouter::Net &n) { return n.key == gn; });
+
+    if (iter != old.end() && iter->pins == net.pins && traced.is_free(iter->route)) {
+      traced.add_path(iter->route);
+      kept.push_back(std::move(*iter));
+    } else {
+      nets.push_back(std::move(net));
+    }
   }
+
+  trace_in_background(bbw, std::move(kept), std::move(nets));
 }
 
 
@@ -3012,10 +2641,8 @@ void Breadboard_Window::Build()
   gtk_widget_show(layout);
   unsigned int rrx, rry;
   gtk_layout_get_size(GTK_LAYOUT(layout), &rrx, &rry);
-  xsize = ((width < LAYOUTSIZE_X) ? LAYOUTSIZE_X : width) / ROUTE_RES;
-  ysize = ((height < LAYOUTSIZE_Y) ? LAYOUTSIZE_Y : height) / ROUTE_RES;
-  board_matrix = new unsigned char[xsize * ysize];
-  mask_matrix = new unsigned short[xsize * ysize];
+  board.resize(((width < LAYOUTSIZE_X) ? LAYOUTSIZE_X : width) / ROUTE_RES,
+               ((height < LAYOUTSIZE_Y) ? LAYOUTSIZE_Y : height) / ROUTE_RES);
   gtk_widget_realize(window);
   pinstatefont = pango_font_description_from_string("Courier Bold 8");
   pinnamefont = pango_font_description_from_string("Courier Bold 8");
@@ -3064,10 +2691,11 @@ void Breadboard_Window::Build()
 
 Breadboard_Window::~Breadboard_Window()
 {
-  delete [] mask_matrix;
-  delete [] board_matrix;
-  mask_matrix = nullptr;
-  board_matrix = nullptr;
+  clear_nodes();
+
+  if (routing_window == this) {
+    routing_window = nullptr;
+  }
 }
 
 
@@ -3079,8 +2707,6 @@ Breadboard_Window::Breadboard_Window(GUI_Processor *_gp)
     selected_pin(nullptr), selected_node(nullptr), selected_module(nullptr)
 {
   menu = "/menu/Windows/Breadboard";
-  mask_matrix = nullptr;
-  board_matrix = nullptr;
   gp = _gp;
 
   if (enabled) {
@@ -30,6 +30,7 @@ Boston, MA 02111-1307, USA.  */
 #include "../src/packages.h"
 #include "../src/stimuli.h"
 #include "gui_object.h"
+#include "gui_router.h"
 
 #include <string>
 #include <vector>
@@ -48,23 +49,6 @@ enum eOrientation {LEFT, UP, RIGHT, DOWN};
 enum eDirection {PIN_INPUT, PIN_OUTPUT};
 typedef enum {PIN_DIGITAL, PIN_ANALOG, PIN_OTHER} pintype;
 
-// Routing types
-typedef enum {R_NONE, R_LEFT, R_RIGHT, R_UP, R_DOWN} route_direction;
-
-class point {
-public:
-  int x;
-  int y;
-};
-
-
-class path {
-public:
-  point p;
-  route_direction dir;
-};
-// End routing types
-
 
 class GuiModule;
 //========================================================================
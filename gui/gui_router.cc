@@ -0,0 +1,488 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of gpsim.
+
+gpsim is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2, or (at your option)
+any later version.
+
+gpsim is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with gpsim; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#include "gui_router.h"
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <utility>
+
+namespace {
+
+// Penalty for making a turn in a trace
+const int TURN_COST = 10;
+
+// Nets with up to this many pins are connected in the best order of
+// all; larger ones greedily.
+const std::size_t MAX_EXHAUSTIVE_PINS = 8;
+
+// Grid steps, indexed by route_direction - 1.
+const int step_x[4] = { -1, 1, 0, 0 };
+const int step_y[4] = { 0, 0, 1, -1 };
+
+
+// Find the direction to go to get from s to e if there are no obstacles.
+inline route_direction calculate_route_direction(point s, point e)
+{
+  if (abs(s.x - e.x) > abs(s.y - e.y)) {
+    // Left or right
+    if (s.x < e.x) {
+      return R_RIGHT;
+    }
+
+    return R_LEFT;
+  }
+
+  if (s.y < e.y) {
+    return R_UP;
+  }
+
+  return R_DOWN;
+}
+
+
+// Put point p as first point in pat
+void prepend_point_to_path(std::list<path> &pat, point p)
+{
+  route_direction dir = R_NONE;
+  path new_point;
+  new_point.p = p;
+
+  if (!pat.empty()) {
+    dir = calculate_route_direction(p, pat.front().p);
+
+    if (pat.front().dir == R_NONE) {
+      pat.front().dir = dir;
+    }
+  }
+
+  new_point.dir = dir;
+  pat.push_front(new_point);
+}
+
+
+// A lower bound of the cost from p to end.
+inline int estimate(point p, point end)
+{
+  int dx = abs(p.x - end.x);
+  int dy = abs(p.y - end.y);
+
+  return dx + dy + ((dx && dy) ? TURN_COST : 0);
+}
+
+
+// The pin order with the smallest sum of costs between neighbours.
+std::vector<std::size_t> best_order(const std::vector<int> &cost, std::size_t n)
+{
+  std::vector<std::size_t> order(n), best;
+  int min_cost = INT_MAX;
+
+  for (std::size_t i = 0; i < n; i++) {
+    order[i] = i;
+  }
+
+  auto sum = [&cost, n](const std::vector<std::size_t> &o) {
+    int s = 0;
+
+    for (std::size_t i = 0; i + 1 < n; i++) {
+      s += cost[o[i] * n + o[i + 1]];
+    }
+
+    return s;
+  };
+
+  if (n <= MAX_EXHAUSTIVE_PINS) {
+    do {
+      int s = sum(order);
+
+      if (s < min_cost) {
+        min_cost = s;
+        best = order;
+      }
+    } while (std::next_permutation(order.begin(), order.end()));
+
+    return best;
+  }
+
+  // Nearest neighbour, from every pin.
+  for (std::size_t first = 0; first < n; first++) {
+    std::vector<bool> used(n, false);
+
+    order[0] = first;
+    used[first] = true;
+
+    for (std::size_t i = 1; i < n; i++) {
+      std::size_t next = n;
+
+      for (std::size_t j = 0; j < n; j++) {
+        if (!used[j] && (next == n || cost[order[i - 1] * n + j] < cost[order[i - 1] * n + next])) {
+          next = j;
+        }
+      }
+
+      order[i] = next;
+      used[next] = true;
+    }
+
+    int s = sum(order);
+
+    if (s < min_cost) {
+      min_cost = s;
+      best = order;
+    }
+  }
+
+  return best;
+}
+
+}  // namespace
+
+
+void BoardRouter::resize(unsigned int xsize, unsigned int ysize)
+{
+  if (xsize > m_xsize || ysize > m_ysize) {
+    m_xsize = std::max(xsize, m_xsize);
+    m_ysize = std::max(ysize, m_ysize);
+    m_matrix.resize(m_xsize * m_ysize);
+  }
+
+  clear();
+}
+
+
+void BoardRouter::clear()
+{
+  std::fill(m_matrix.begin(), m_matrix.end(), 0);
+
+  // Mark board outline, so we limit traces here
+  for (int x = 0; x < (int)m_xsize; x++) {
+    *at(x, 0) = (HMASK | VMASK);
+    *at(x, m_ysize - 1) = (HMASK | VMASK);
+  }
+
+  for (int y = 0; y < (int)m_ysize; y++) {
+    *at(0, y) = (HMASK | VMASK);
+    *at(m_xsize - 1, y) = (HMASK | VMASK);
+  }
+}
+
+
+unsigned char *BoardRouter::at(int x, int y)
+{
+  if ((unsigned int)x < m_xsize && (unsigned int)y < m_ysize) {
+    return &m_matrix[y * m_xsize + x];
+  }
+
+  return nullptr;
+}
+
+
+const unsigned char *BoardRouter::at(int x, int y) const
+{
+  return const_cast<BoardRouter *>(this)->at(x, y);
+}
+
+
+int BoardRouter::route_two_points(std::list<path> &pat, point start, point end) const
+{
+  pat.clear();
+
+  if (!at(start.x, start.y) || !at(end.x, end.y)) {
+    return -1;
+  }
+
+  // A state is a position, and the direction we came in, so turns can
+  // be priced.
+  auto state = [this](point p, int dir) { return (int)((p.y * m_xsize + p.x) * 4 + dir); };
+  auto position = [this](int s) { return point{ (int)(s / 4 % m_xsize), (int)(s / 4 / m_xsize) }; };
+
+  // Scratch space, reused between searches on the same thread. Only
+  // entries stamped with this search are valid.
+  thread_local std::vector<int> cost, from;
+  thread_local std::vector<unsigned int> stamp;
+  thread_local unsigned int search = 0;
+  std::size_t states = (std::size_t)m_xsize * m_ysize * 4;
+
+  if (stamp.size() < states) {
+    cost.resize(states);
+    from.resize(states);
+    stamp.assign(states, 0);
+  }
+
+  if (++search == 0) {
+    std::fill(stamp.begin(), stamp.end(), 0);
+    search = 1;
+  }
+
+  auto cost_of = [](int s) { return stamp[s] == search ? cost[s] : INT_MAX; };
+
+  // Ordered by estimated total cost, then by state for repeatability.
+  typedef std::pair<int, int> Entry;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+
+  // The old tracer started out going up.
+  int s = state(start, R_UP - 1);
+  stamp[s] = search;
+  cost[s] = 0;
+  from[s] = -1;
+  open.push(Entry(estimate(start, end), s));
+
+  while (!open.empty()) {
+    Entry e = open.top();
+    open.pop();
+
+    s = e.second;
+    point p = position(s);
+    int c = cost[s];
+
+    // A cheaper way here was found after this was queued.
+    if (e.first != c + estimate(p, end)) {
+      continue;
+    }
+
+    if (p == end) {
+      for (; s != -1; s = from[s]) {
+        prepend_point_to_path(pat, position(s));
+      }
+
+      return c;
+    }
+
+    for (int dir = 0; dir < 4; dir++) {
+      point q = { p.x + step_x[dir], p.y + step_y[dir] };
+      const unsigned char *m = at(q.x, q.y);
+
+      if (!m || (*m & (step_x[dir] ? HMASK : VMASK))) {
+        continue;
+      }
+
+      int qc = c + 1 + (dir != s % 4) * TURN_COST;
+      int qs = state(q, dir);
+
+      if (qc < cost_of(qs)) {
+        stamp[qs] = search;
+        cost[qs] = qc;
+        from[qs] = s;
+        open.push(Entry(qc + estimate(q, end), qs));
+      }
+    }
+  }
+
+  return -1;
+}
+
+
+bool BoardRouter::route_net(Net &net) const
+{
+  const std::size_t n = net.pins.size();
+
+  net.route.clear();
+
+  if (n < 2) {
+    return true;
+  }
+
+  // Trace between all pins, and keep the costs.
+  std::vector<std::list<path>> routes(n * n);
+  std::vector<int> cost(n * n, 0);
+
+  for (std::size_t i = 0; i < n; i++) {
+    for (std::size_t j = i + 1; j < n; j++) {
+      int c = route_two_points(routes[i * n + j], net.pins[i], net.pins[j]);
+
+      if (c < 0) {
+        return false;
+      }
+
+      cost[i * n + j] = c;
+      cost[j * n + i] = c;
+    }
+  }
+
+  std::vector<std::size_t> order = best_order(cost, n);
+
+  for (std::size_t k = 0; k + 1 < n; k++) {
+    std::size_t i = order[k], j = order[k + 1];
+    std::list<path> piece;
+
+    if (i < j) {
+      piece = routes[i * n + j];
+    } else {
+      for (const path &p : routes[j * n + i]) {
+        prepend_point_to_path(piece, p.p);
+      }
+    }
+
+    // The piece starts where the last one ended.
+    if (!net.route.empty()) {
+      piece.pop_front();
+    }
+
+    net.route.splice(net.route.end(), piece);
+  }
+
+  return true;
+}
+
+
+bool BoardRouter::is_free(const std::list<path> &pat) const
+{
+  if (pat.empty()) {
+    return true;
+  }
+
+  auto prev = pat.begin();
+
+  for (auto iter = std::next(prev); iter != pat.end(); prev = iter++) {
+    int dx = iter->p.x - prev->p.x;
+    int dy = iter->p.y - prev->p.y;
+
+    if (abs(dx) + abs(dy) != 1) {
+      continue;
+    }
+
+    const unsigned char *m = at(iter->p.x, iter->p.y);
+
+    if (!m || (*m & (dx ? HMASK : VMASK))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+void BoardRouter::add_path(const std::list<path> &pat)
+{
+  int x = -1;
+  int y = -1;
+  auto iter = pat.begin();
+
+  if (iter != pat.end()) {
+    x = iter->p.x;
+    y = iter->p.y;
+    ++iter;
+  }
+
+  for (; iter != pat.end(); ++iter) {
+    unsigned char *pt = at(x, y);
+
+    if (pt && (iter->dir == R_LEFT || iter->dir == R_RIGHT)) {
+      *pt |= HMASK;
+    }
+
+    if (pt && (iter->dir == R_DOWN || iter->dir == R_UP)) {
+      *pt |= VMASK;
+    }
+
+    while (x != iter->p.x || y != iter->p.y) {
+      if (x < iter->p.x) {
+        x++;
+      }
+
+      if (x > iter->p.x) {
+        x--;
+      }
+
+      if (y < iter->p.y) {
+        y++;
+      }
+
+      if (y > iter->p.y) {
+        y--;
+      }
+
+      pt = at(x, y);
+
+      if (pt && (iter->dir == R_LEFT || iter->dir == R_RIGHT)) {
+        *pt |= HMASK;
+      }
+
+      if (pt && (iter->dir == R_DOWN || iter->dir == R_UP)) {
+        *pt |= VMASK;
+      }
+    }
+  }
+}
+
+
+bool BoardRouter::route_nets(std::vector<Net> &nets, unsigned int threads,
+                             const std::function<bool()> &cancelled)
+{
+  enum { NOT_TRIED, ROUTED, FAILED };
+  std::vector<char> speculated(nets.size(), NOT_TRIED);
+
+  // Route every net as if it were alone on the board. Most nets don't
+  // cross each other, so most of these routes are kept below.
+  if (threads > 1 && nets.size() > 1) {
+    std::atomic<std::size_t> next(0);
+    auto work = [&]() {
+      for (std::size_t i; (i = next++) < nets.size();) {
+        if (cancelled && cancelled()) {
+          return;
+        }
+
+        speculated[i] = route_net(nets[i]) ? ROUTED : FAILED;
+      }
+    };
+    std::vector<std::thread> pool;
+
+    for (unsigned int t = 1; t < threads && t < nets.size(); t++) {
+      pool.emplace_back(work);
+    }
+
+    work();
+
+    for (auto &t : pool) {
+      t.join();
+    }
+  }
+
+  bool ok = true;
+
+  for (std::size_t i = 0; i < nets.size(); i++) {
+    if (cancelled && cancelled()) {
+      return false;
+    }
+
+    Net &net = nets[i];
+
+    // A net that can't be routed alone can't be routed with others.
+    if (speculated[i] == FAILED) {
+      net.route.clear();
+      ok = false;
+      continue;
+    }
+
+    if ((speculated[i] != ROUTED || !is_free(net.route)) && !route_net(net)) {
+      ok = false;
+      continue;
+    }
+
+    add_path(net.route);
+  }
+
+  return ok;
+}
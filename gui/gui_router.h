@@ -0,0 +1,111 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of gpsim.
+
+gpsim is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2, or (at your option)
+any later version.
+
+gpsim is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with gpsim; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#ifndef GUI_GUI_ROUTER_H_
+#define GUI_GUI_ROUTER_H_
+
+#include <functional>
+#include <list>
+#include <vector>
+
+// Routing types
+typedef enum {R_NONE, R_LEFT, R_RIGHT, R_UP, R_DOWN} route_direction;
+
+class point {
+public:
+  int x;
+  int y;
+
+  bool operator ==(const point &o) const { return x == o.x && y == o.y; }
+};
+
+
+class path {
+public:
+  point p;
+  route_direction dir;
+};
+// End routing types
+
+
+//
+// BoardRouter - routes the traces of the breadboard window on a grid.
+//
+// Each grid position says whether a trace may pass horizontally or
+// vertically. Traces between two points are found with A* over
+// position and direction, so turns cost extra, like the old recursive
+// search but without its depth limit. It does not use GTK, so nets can
+// be routed off the UI thread on a copy of the board.
+//
+class BoardRouter {
+public:
+  // If HMASK is set for a position, it is unavailable for horizontal
+  // tracks.
+  enum { HMASK = 1, VMASK = 2 };
+
+  // The pins of a node, and the route found for them.
+  struct Net {
+    const void *key = nullptr;
+    std::vector<point> pins;
+    std::list<path> route;
+  };
+
+  // Makes the board at least this large, and clears it.
+  void resize(unsigned int xsize, unsigned int ysize);
+  // Clears the board and blocks its outline.
+  void clear();
+
+  unsigned int xsize() const { return m_xsize; }
+  unsigned int ysize() const { return m_ysize; }
+
+  // Returns nullptr outside the board.
+  unsigned char *at(int x, int y);
+  const unsigned char *at(int x, int y) const;
+
+  // Finds the cheapest path from start to end. Returns its cost, or -1
+  // if there is none.
+  int route_two_points(std::list<path> &pat, point start, point end) const;
+
+  // Routes all pins of the net, connecting them in the cheapest order.
+  bool route_net(Net &net) const;
+
+  // Returns true if the path does not cross anything on the board.
+  bool is_free(const std::list<path> &pat) const;
+
+  // Blocks the board along the path. Other traces can still cross it
+  // at a straight angle.
+  void add_path(const std::list<path> &pat);
+
+  // Routes the nets in order, each avoiding the ones before it, and
+  // adds them to the board. Nets are first routed speculatively on
+  // threads, and only routed again if they cross an earlier net.
+  // Returns false if a net could not be routed, or if cancelled()
+  // returned true.
+  bool route_nets(std::vector<Net> &nets, unsigned int threads,
+                  const std::function<bool()> &cancelled = nullptr);
+
+private:
+  unsigned int m_xsize = 0;
+  unsigned int m_ysize = 0;
+  std::vector<unsigned char> m_matrix;
+};
+
+
+#endif // GUI_GUI_ROUTER_H_
@@ -666,6 +666,7 @@ public:
   Recorder_Input(const char *n, FileRecorder *pParent);
   virtual void setDrivenState(bool);
   virtual void set_nodeVoltage(double);
+  virtual bool add_thresholds(std::vector<double> &);
 
 private:
   bool is_digital();
@@ -704,6 +705,13 @@ void Recorder_Input::set_nodeVoltage(double v)
 }
 
 
+// Analog recordings need every settling step.
+bool Recorder_Input::add_thresholds(std::vector<double> &thresholds)
+{
+  return is_digital() && IOPIN::add_thresholds(thresholds);
+}
+
+
 bool Recorder_Input::is_digital()
 {
   return m_digitalattribute->get();
@@ -352,7 +352,8 @@ RETFIE::RETFIE (Processor *new_cpu, unsigned int new_opcode, unsigned int addres
 
 void RETFIE::execute(void)
 {
-  cpu14->pc->new_address(cpu14->stack->pop());
+  unsigned int return_address = cpu14->stack->pop();
+
   // test for pending intterrupts
   cpu14->intcon->set_gie();
   if(cpu_pic->base_isa() == _14BIT_E_PROCESSOR_)
@@ -366,6 +367,9 @@ void RETFIE::execute(void)
 	cpu14e->ind1.fsrl.put(cpu14e->fsr1l_shad.get());
 	cpu14e->ind1.fsrh.put(cpu14e->fsr1h_shad.get());
   }
+
+  // Set the PC last, so the trace entry ends the instruction.
+  cpu14->pc->new_address(return_address);
 }
 
 //--------------------------------------------------
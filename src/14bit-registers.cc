@@ -2108,6 +2108,7 @@ bool Stack::push(unsigned int address)
 bool Stack::stack_overflow()
 {
     Dprintf(("stack_warnings_flag=%d break_on_overflow=%d\n", stack_warnings_flag, break_on_overflow));
+    ++overflows;
 
     if (stack_warnings_flag || break_on_overflow)
     {
@@ -2318,6 +2319,7 @@ unsigned int  Stack14E::pop()
 
 bool Stack14E::stack_overflow()
 {
+    ++overflows;
     cpu_14e()->pcon.put(cpu_14e()->pcon.get() | PCON::STKOVF);
 
     if (STVREN)
@@ -361,6 +361,7 @@ public:
     bool stack_warnings_flag = false;  // Should over/under flow warnings be printed?
     bool break_on_overflow = false;    // Should over flow cause a break?
     bool break_on_underflow = false;   // Should under flow cause a break?
+    unsigned int overflows = 0;        // Number of overflows, e.g. for fuzzing oracles.
 
     explicit Stack(Processor *);
     virtual ~Stack() {}
@@ -1193,6 +1194,7 @@ public:
     CPSCON0 *m_cpscon0;
 
     void set_nodeVoltage(double v) override;
+    bool add_thresholds(std::vector<double> &) override { return false; }
 };
 
 
@@ -2000,13 +2000,26 @@ private:
 class TMR1_Freq_Attribute : public Float
 {
 public:
-    TMR1_Freq_Attribute(double freq, const char *name = "tmr1_freq");
+    TMR1_Freq_Attribute(Processor *pCpu, double freq, const char *name = "tmr1_freq");
+
+    // All timers share the secondary oscillator.
+    void set(double v) override;
+
+private:
+    Processor *cpu;
 };
 
 
-TMR1_Freq_Attribute::TMR1_Freq_Attribute(double freq, const char *name)
-    : Float(name, freq, " Tmr oscillator frequency.")
+TMR1_Freq_Attribute::TMR1_Freq_Attribute(Processor *pCpu, double freq, const char *name)
+    : Float(name, freq, " Tmr oscillator frequency."), cpu(pCpu)
+{
+}
+
+
+void TMR1_Freq_Attribute::set(double v)
 {
+    Float::set(v);
+    cpu->sosc_clock.set_frequency((uint64_t)v);
 }
 
 
@@ -2023,7 +2036,7 @@ T1CON::T1CON(Processor *pCpu, const char *pName, const char *pDesc)
         freq_name[3] = *(pName + 1);
     }
 
-    cpu->addSymbol(freq_attribute = new TMR1_Freq_Attribute(32768.0, freq_name));
+    cpu->addSymbol(freq_attribute = new TMR1_Freq_Attribute(cpu, 32768.0, freq_name));
 }
 
 
@@ -2482,7 +2495,7 @@ void TMRH::put(unsigned int new_value)
     tmrl->set_ext_scale();
     value.put(new_value & 0xff);
     tmrl->synchronized_cycle = get_cycles().get();
-    tmrl->last_cycle = tmrl->synchronized_cycle
+    tmrl->last_cycle = tmrl->clock_now()
                        - (int64_t)((tmrl->value.get() + (value.get() << 8)
                                    * tmrl->prescale * tmrl->ext_scale) + 0.5);
 
@@ -2595,9 +2608,9 @@ TMRL::~TMRL()
 
 
 /*
- * If we are similating an external RTC crystal for timer1,
- * compute scale factor between crsytal speed and processor
- * instruction cycle rate
+ * If we are similating an external RTC crystal for timer1, or
+ * LFINTOSC, the timer counts in ticks of that clock domain, which
+ * stays exact when the instruction clock changes.
  *
  * If tmr1cs = 1 Fosc is 4 x normal speed so reduce ticks by 1/4
  */
@@ -2606,12 +2619,11 @@ void TMRL::set_ext_scale()
     current_value();
 
     ext_scale = 1.0;
+    clock_domain = nullptr;
 
     if (t1con->get_t1oscen()  && (t1con->get_tmr1cs() == 2))   // external clock
     {
-        ext_scale = get_cycles().instruction_cps() /
-                    t1con->freq_attribute->get();
-
+        clock_domain = &((Processor *)get_module())->sosc_clock;
     }
     else if (t1con->get_tmr1cs() == 1)     // Fosc
     {
@@ -2620,17 +2632,70 @@ void TMRL::set_ext_scale()
     }
     else if ((t1con->get_tmr1cs() == 3) && have_lfintosc)
     {
-	ext_scale = get_cycles().instruction_cps() / 31000.;
+        clock_domain = &((Processor *)get_module())->lfintosc_clock;
     }
 
     if (future_cycle)
     {
-        last_cycle = get_cycles().get()
+        last_cycle = clock_now()
                      - (int64_t)(value_16bit * (prescale * ext_scale) + 0.5);
     }
 }
 
 
+uint64_t TMRL::clock_now() const
+{
+    return clock_domain ? clock_domain->ticks() : get_cycles().get();
+}
+
+
+// Arms, or moves, the break for the timer to reach a value. when is
+// in the units of clock_now().
+void TMRL::set_break(uint64_t when)
+{
+    if (future_cycle && !clock_domain && !m_break_domain)
+    {
+        get_cycles().reassign_break(future_cycle, when, this);
+    }
+    else
+    {
+        clear_break();
+
+        if (clock_domain)
+        {
+            clock_domain->set_break(when, this);
+        }
+        else
+        {
+            get_cycles().set_break(when, this);
+        }
+    }
+
+    future_cycle = when;
+    m_break_domain = clock_domain;
+}
+
+
+void TMRL::clear_break()
+{
+    if (!future_cycle)
+    {
+        return;
+    }
+
+    if (m_break_domain)
+    {
+        m_break_domain->clear_break(this);
+    }
+    else
+    {
+        get_cycles().clear_break(this);
+    }
+
+    future_cycle = 0;
+}
+
+
 void TMRL::release()
 {
 }
@@ -2855,7 +2920,7 @@ void TMRL::on_or_off(int new_state)
         // Effective last cycle
         // Compute the "effective last cycle", i.e. the cycle
         // at which TMR1 was last 0 had it always been counting.
-        last_cycle = (int64_t)(get_cycles().get() -
+        last_cycle = (int64_t)(clock_now() -
                               (value.get() + (tmrh->value.get() << 8)) * prescale * ext_scale + 0.5);
         update();
     }
@@ -2867,8 +2932,7 @@ void TMRL::on_or_off(int new_state)
 
         if (future_cycle)
         {
-            get_cycles().clear_break(this);
-            future_cycle = 0;
+            clear_break();
         }
     }
 }
@@ -2964,7 +3028,7 @@ void TMRL::update()
 
         //  synchronized_cycle = cycles.get() + 2;
         synchronized_cycle = get_cycles().get();
-        last_cycle = synchronized_cycle
+        last_cycle = clock_now()
                      - (int64_t)(value_16bit * (prescale * ext_scale) + 0.5);
         break_value = 0x10000;  // Assume that a rollover will happen first.
 
@@ -2988,20 +3052,8 @@ void TMRL::update()
             std::cout << name() << " TMR1 now at " << value_16bit << ", next event at " << break_value << '\n';
         }
 
-        uint64_t fc = get_cycles().get()
-                     + (uint64_t)((break_value - value_16bit) * prescale * ext_scale);
-
-        if (future_cycle)
-        {
-            get_cycles().reassign_break(future_cycle, fc, this);
-
-        }
-        else
-        {
-            get_cycles().set_break(fc, this);
-        }
-
-        future_cycle = fc;
+        set_break(clock_now()
+                  + (uint64_t)((break_value - value_16bit) * prescale * ext_scale));
 
         // Setup to update for GUI breaks
         if (tmr1_interface == nullptr)
@@ -3017,8 +3069,7 @@ void TMRL::update()
         if (future_cycle)
         {
             current_value();
-            get_cycles().clear_break(this);
-            future_cycle = 0;
+            clear_break();
         }
     }
 }
@@ -3036,7 +3087,7 @@ void TMRL::put(unsigned int new_value)
     }
 
     synchronized_cycle = get_cycles().get();
-    last_cycle = synchronized_cycle - (int64_t)((value.get()
+    last_cycle = clock_now() - (int64_t)((value.get()
                  + (tmrh->value.get() << 8)) * prescale * ext_scale + 0.5);
     current_value();
 
@@ -3099,7 +3150,7 @@ void TMRL::current_value()
     }
     else
     {
-        value_16bit = (uint64_t)((get_cycles().get() - last_cycle) /
+        value_16bit = (uint64_t)((clock_now() - last_cycle) /
                                 (prescale * ext_scale));
 
         if (value_16bit > 0x10000)
@@ -3177,8 +3228,7 @@ void TMRL::new_clock_source()
             {
                 // Compute value_16bit with old prescale and ext_scale
                 current_value();
-                get_cycles().clear_break(this);
-                future_cycle = 0;
+                clear_break();
             }
 
             prescale = 1 << t1con->get_prescale();
@@ -3199,8 +3249,7 @@ void TMRL::new_clock_source()
         {
             // Compute value_16bit with old prescale and ext_scale
             current_value();
-            get_cycles().clear_break(this);
-            future_cycle = 0;
+            clear_break();
         }
 
         prescale = 1 << t1con->get_prescale();
@@ -3220,7 +3269,7 @@ void TMRL::new_clock_source()
 void TMRL::clear_timer()
 {
     synchronized_cycle = get_cycles().get();
-    last_cycle = synchronized_cycle;
+    last_cycle = clock_now();
     value.put(0);
     tmrh->value.put(0);
 
@@ -3302,7 +3351,7 @@ void TMRL::callback()
 
         // Reset the timer to 0.
         synchronized_cycle = get_cycles().get();
-        last_cycle = synchronized_cycle;
+        last_cycle = clock_now();
         value.put(0);
         tmrh->value.put(0);
     }
@@ -3332,8 +3381,7 @@ void TMRL::sleep()
         if (future_cycle)
         {
             current_value();
-            get_cycles().clear_break(this);
-            future_cycle = 0;
+            clear_break();
         }
     }
 }
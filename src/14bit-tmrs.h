@@ -28,6 +28,7 @@ License along with this library; if not, see
 #include "stimuli.h"
 #include "trigger.h"
 
+class ClockDomain;
 class TMRL;
 class TMR2;
 class CCPRL;
@@ -381,7 +382,7 @@ public:
     void ccp_pwm();
     bool is_pwm() override
     {
-	return (value.get() & (PWM0 | EN)) == (PWM0 | EN);
+	return (value.get() & ((unsigned int)PWM0 | EN)) == ((unsigned int)PWM0 | EN);
     }
     unsigned int input_pin() override { return CCP_IN_PIN;}
     void compare_match() override;
@@ -688,6 +689,11 @@ public:
 
     TMR1CapComRef * compare_queue = nullptr;
 
+    // The timer counts in ticks of clock_domain, if any, or else in
+    // instruction cycles. last_cycle and future_cycle are in the same
+    // units.
+    ClockDomain *clock_domain = nullptr;
+
     uint64_t synchronized_cycle = 0;
     uint64_t future_cycle = 0;
     int64_t last_cycle = 0;
@@ -696,6 +702,7 @@ public:
     void callback_print() override;
 
     void set_ext_scale();
+    uint64_t clock_now() const;
 
     void release() override;
 
@@ -727,6 +734,11 @@ public:
     DATA_SERVER     *get_tmr135_server();
 
 private:
+    void set_break(uint64_t when);
+    void clear_break();
+
+private:
+    ClockDomain *m_break_domain = nullptr;  // The domain of future_cycle.
     char	   tmr_number=1;
     DATA_SERVER	    *tmr135_overflow_server = nullptr;
     TMR1_Interface *tmr1_interface = nullptr;
@@ -1857,7 +1857,7 @@ char * RCALL::name(char *return_str, int len)
 //--------------------------------------------------
 void RETFIE16::execute()
 {
-  cpu16->pc->new_address(cpu16->stack->pop());
+  unsigned int return_address = cpu16->stack->pop();
 
   if (fast) {
     cpu16->fast_stack.pop();
@@ -1865,6 +1865,9 @@ void RETFIE16::execute()
 
   //cout << "retfie: need to enable interrupts\n";
   cpu16->intcon.set_gie();
+
+  // Set the PC last, so the trace entry ends the instruction.
+  cpu16->pc->new_address(return_address);
 }
 
 
@@ -1884,11 +1887,13 @@ char *RETFIE16::name(char  *return_str, int len)
 //--------------------------------------------------
 void RETURN16::execute()
 {
-  cpu16->pc->new_address(cpu16->stack->pop());
+  unsigned int return_address = cpu16->stack->pop();
 
   if (fast) {
     cpu16->fast_stack.pop();
   }
+
+  cpu16->pc->new_address(return_address);
 }
 
 
@@ -35,6 +35,7 @@ License along with this library; if not, see
 #include "pic-ioports.h"
 #include "processor.h"
 #include "symbol.h"
+#include "translate.h"
 #include "ui.h"
 
 class IOPIN;
@@ -287,6 +288,29 @@ _16bit_processor::~_16bit_processor()
 }
 
 
+//-------------------------------------------------------------------
+// The translator decodes the PIC18 instruction set only.
+bool _16bit_processor::enable_translation(bool enable)
+{
+    if (base_isa() != _PIC18_PROCESSOR_)
+    {
+        return false;
+    }
+
+    if (!enable)
+    {
+        delete translator;
+        translator = nullptr;
+    }
+    else if (!translator)
+    {
+        translator = new BlockTranslator(this);
+    }
+
+    return true;
+}
+
+
 //-------------------------------------------------------------------
 pic_processor *_16bit_processor::construct()
 {
@@ -209,6 +209,7 @@ public:
     void osc_mode(unsigned int) override;
     virtual void set_extended_instruction(bool);
     virtual bool extended_instruction() { return extended_instruction_flag; }
+    bool enable_translation(bool enable) override;
 
     static pic_processor *construct();
 
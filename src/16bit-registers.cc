@@ -826,6 +826,7 @@ bool Stack16::stack_underflow()
 
 bool Stack16::stack_overflow()
 {
+  ++overflows;
   stkptr.value.put(STKPTR::STKOVF | (pointer & stack_mask));
 
   if (STVREN) {
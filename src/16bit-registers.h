@@ -567,6 +567,7 @@ public:
   ~HLVD_stimulus();
 
   void set_nodeVoltage(double v) override;
+  bool add_thresholds(std::vector<double> &) override { return false; }
 
 private:
   HLVDCON *hlvd;
@@ -137,6 +137,7 @@ public:
 
 
     void set_nodeVoltage(double v) override;
+    bool add_thresholds(std::vector<double> &) override { return false; }
 
 private:
     DAC_ATTACH *pt_base_function;
@@ -160,6 +161,7 @@ public:
 
 
     void set_nodeVoltage(double v) override;
+    bool add_thresholds(std::vector<double> &) override { return false; }
 
 private:
     FVR_ATTACH *pt_base_function;
@@ -697,6 +699,7 @@ public:
     int	   channel;
 
     void set_nodeVoltage(double v) override;
+    bool add_thresholds(std::vector<double> &) override { return false; }
 };
 
 
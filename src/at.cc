@@ -1145,8 +1145,8 @@ void ATx::send_perclk()
 {
     int state = !(at_con1.value.get() & ATxCON1::PRP);
     RRprint((stderr, "ATx::send_perclk state=%d\n", state));
-    atx_data_server->send_data(state, PERCLK | DATA_SERVER::AT1);
-    atx_data_server->send_data(!state, PERCLK | DATA_SERVER::AT1);
+    atx_data_server->send_data(state, (unsigned int)PERCLK | DATA_SERVER::AT1);
+    atx_data_server->send_data(!state, (unsigned int)PERCLK | DATA_SERVER::AT1);
 }
 // Output missedpulse to other modules
 void ATx::send_missedpulse(bool out)
@@ -1156,7 +1156,7 @@ void ATx::send_missedpulse(bool out)
     bool state = out ^ (at_con1.value.get() & ATxCON1::MPP);
     if (state == last_state) return;
     RRprint((stderr, "ATx::send_missedpulse state=%d\n", state));
-    atx_data_server->send_data(state, MISSPUL | DATA_SERVER::AT1);
+    atx_data_server->send_data(state, (unsigned int)MISSPUL | DATA_SERVER::AT1);
     if(multi_pulse(true, false, atsig, atper))
 	fprintf(stderr, "Warning ATx::send_missedpulse multi_pulse returned true\n");
     last_state = state;
@@ -1167,8 +1167,8 @@ void ATx::send_phsclk()
 {
     int state = !(at_con1.value.get() & ATxCON1::PHP);
     RRprint((stderr, "ATx::send_phsclk state=%d\n", state));
-    atx_data_server->send_data(state, PHSCLK | DATA_SERVER::AT1);
-    atx_data_server->send_data(!state, PHSCLK | DATA_SERVER::AT1);
+    atx_data_server->send_data(state, (unsigned int)PHSCLK | DATA_SERVER::AT1);
+    atx_data_server->send_data(!state, (unsigned int)PHSCLK | DATA_SERVER::AT1);
 }
 
 
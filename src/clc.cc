@@ -180,6 +180,7 @@ void CLCxPOL::put(unsigned int new_value)
         return;
     }
 
+    m_clc->compile_tables();
     m_clc->compute_gates();
 }
 
@@ -303,6 +304,8 @@ void CLCxGLS0::put(unsigned int new_value)
         return;
     }
 
+    m_clc->compile_tables();
+
     if (m_clc->CLCenabled())
     {
         m_clc->config_inputs(true);
@@ -323,6 +326,8 @@ void CLCxGLS1::put(unsigned int new_value)
         return;
     }
 
+    m_clc->compile_tables();
+
     if (m_clc->CLCenabled())
     {
         m_clc->config_inputs(true);
@@ -343,6 +348,8 @@ void CLCxGLS2::put(unsigned int new_value)
         return;
     }
 
+    m_clc->compile_tables();
+
     if (m_clc->CLCenabled())
     {
         m_clc->config_inputs(true);
@@ -363,6 +370,8 @@ void CLCxGLS3::put(unsigned int new_value)
         return;
     }
 
+    m_clc->compile_tables();
+
     if (m_clc->CLCenabled())
     {
         m_clc->config_inputs(true);
@@ -423,7 +432,6 @@ CLC_BASE::CLC_BASE(Processor * cpu, unsigned int _index, CLCDATA * _clcdata):
     {
         CMxOUT_level[i] = false;
         pwmx_level[i] = false;
-        lcxdT[i] = false;
         lcxg[i] = false;
         dxs_data_length[i] = 0;
         dxs_data[i] = nullptr;
@@ -440,6 +448,7 @@ CLC_BASE::CLC_BASE(Processor * cpu, unsigned int _index, CLCDATA * _clcdata):
     std::fill_n(p_tmr246, 3, nullptr);
     std::fill_n(attached_tmr135, 3, false);
     std::fill_n(t246_data_receiver, 3, nullptr);
+    compile_tables();
 }
 
 
@@ -487,6 +496,7 @@ void CLC_BASE::set_dxs_data(int input, int length, data_in *data)
      * the reset default of zero is still in effect.
      */
     DxS_data[input-1] = dxs_data[input-1][0];
+    compile_tables();
 }
 
 void CLC_BASE::setIOpin(PinModule *pin, int data)
@@ -537,36 +547,43 @@ void CLC_BASE::setCLCxPin(PinModule * alt_pin)
 }
 
 
-// Handle T0 overflow notification
-void CLC_BASE::t0_overflow()
+// Drive the data inputs which select source to level,
+// returns true if any of them changed
+bool CLC_BASE::route_input(data_in source, bool level)
 {
-    bool gate_change = false;
+    unsigned int mask = dxs_route[source];
+    unsigned int data = level ? (lcxd | mask) : (lcxd & ~mask);
 
-
-    for (int i = 0; i < 4; i++)
+    if (data == lcxd)
     {
-        if (DxS_data[i] == T0_OVER)
-        {
-            lcxdT[i] = true;
-            gate_change = true;
-        }
+        return false;
     }
 
-    if (gate_change)
+    lcxd = data;
+    return true;
+}
+
+
+// Pulse the data inputs in mask high and then low again
+void CLC_BASE::pulse_input(unsigned int mask)
+{
+    lcxd |= mask;
+    compute_gates();
+    lcxd &= ~mask;
+    compute_gates();
+}
+
+
+// Handle T0 overflow notification
+void CLC_BASE::t0_overflow()
+{
+    unsigned int mask = dxs_route[T0_OVER];
+
+    if (mask)
     {
         Dprintf(("CLC%u t0_overflow() enable=%d\n", index + 1,
                  CLCenabled()));
-        compute_gates();
-
-        for (int i = 0; i < 4; i++)
-        {
-            if (DxS_data[i] == T0_OVER)
-            {
-                lcxdT[i] = false;
-            }
-        }
-
-        compute_gates();
+        pulse_input(mask);
     }
 }
 
@@ -574,37 +591,27 @@ void CLC_BASE::t0_overflow()
 // Handle T1 (3, 5) overflow notification and toggle gate
 void CLC_BASE::t135_overflow(int timer_number)
 {
-    bool gate_change = false;
+    unsigned int mask = 0;
 
-    for (int i = 0; i < 4; i++)
+    switch (timer_number)
     {
-        if ( (DxS_data[i] == T1_OVER && timer_number == 1) ||
-	     (DxS_data[i] == T3_OVER && timer_number == 3) ||
-	     (DxS_data[i] == T5_OVER && timer_number == 5)
-	   )
-        {
-    RRprint((stderr, "CLC_BASE::t135_overflow DxS_data[%d]=tmr%d_over \n",i, timer_number));
-            lcxdT[i] = true;
-            gate_change = true;
-        }
-    }
+    case 1:
+        mask = dxs_route[T1_OVER];
+        break;
 
-    if (gate_change)
-    {
-        compute_gates();
+    case 3:
+        mask = dxs_route[T3_OVER];
+        break;
 
-        for (int i = 0; i < 4; i++)
-        {
-            if ( (DxS_data[i] == T1_OVER && timer_number == 1) ||
-	        (DxS_data[i] == T3_OVER && timer_number == 3) ||
-	        (DxS_data[i] == T5_OVER && timer_number == 5)
-	       )
-            {
-                lcxdT[i] = false;
-            }
-        }
+    case 5:
+        mask = dxs_route[T5_OVER];
+        break;
+    }
 
-        compute_gates();
+    if (mask)
+    {
+        RRprint((stderr, "CLC_BASE::t135_overflow mask=0x%x tmr%d_over \n", mask, timer_number));
+        pulse_input(mask);
     }
 }
 
@@ -612,33 +619,13 @@ void CLC_BASE::t135_overflow(int timer_number)
 void CLC_BASE::t1_overflow()
 {
     RRprint((stderr, "CLC_BASE::t1_overflow \n"));
-    bool gate_change = false;
-
-    for (int i = 0; i < 4; i++)
-    {
-    RRprint((stderr, "CLC_BASE::t1_overflow DxS_data[%d]=0x%x\n",i, DxS_data[i]));
-        if (DxS_data[i] == T1_OVER)
-        {
-            lcxdT[i] = true;
-            gate_change = true;
-        }
-    }
+    unsigned int mask = dxs_route[T1_OVER];
 
-    if (gate_change)
+    if (mask)
     {
         Dprintf(("CLC%u t1_overflow() enable=%d\n", index + 1,
                  CLCenabled()));
-        compute_gates();
-
-        for (int i = 0; i < 4; i++)
-        {
-            if (DxS_data[i] == T1_OVER)
-            {
-                lcxdT[i] = false;
-            }
-        }
-
-        compute_gates();
+        pulse_input(mask);
     }
 }
 
@@ -647,39 +634,27 @@ void CLC_BASE::t1_overflow()
 // If an input gate using a t[246]  match, toggle input gate
 void CLC_BASE::t246_match(char tmr_number)
 {
-    bool gate_change = false;
+    unsigned int mask = 0;
 
-    for (int i = 0; i < 4; i++)
+    switch (tmr_number)
     {
-        if (
-            (DxS_data[i] == T2_MATCH && tmr_number == 2) ||
-            (DxS_data[i] == T4_MATCH && tmr_number == 4) ||
-            (DxS_data[i] == T6_MATCH && tmr_number == 6)
-        )
-        {
-            lcxdT[i] = true;
-            gate_change = true;
-        }
+    case 2:
+        mask = dxs_route[T2_MATCH];
+        break;
+
+    case 4:
+        mask = dxs_route[T4_MATCH];
+        break;
+
+    case 6:
+        mask = dxs_route[T6_MATCH];
+        break;
     }
 
-    if (gate_change)
+    if (mask)
     {
         Dprintf(("CLC%u t2_match(%d) enable=%d\n", index + 1, tmr_number, CLCenabled()));
-        compute_gates();
-
-        for (int i = 0; i < 4; i++)
-        {
-            if (
-                (DxS_data[i] == T2_MATCH && tmr_number == 2) ||
-                (DxS_data[i] == T4_MATCH && tmr_number == 4) ||
-                (DxS_data[i] == T6_MATCH && tmr_number == 6)
-            )
-            {
-                lcxdT[i] = false;
-            }
-        }
-
-        compute_gates();
+        pulse_input(mask);
     }
 }
 
@@ -687,18 +662,7 @@ void CLC_BASE::t246_match(char tmr_number)
 // Handle updates for frc or lfintosc
 void CLC_BASE::osc_out(bool level, int kind)
 {
-    bool gate_change = false;
-
-    for (int i = 0; i < 4; i++)
-    {
-        if (DxS_data[i] == kind && lcxdT[i] != level)
-        {
-            lcxdT[i] = level;
-            gate_change = true;
-        }
-    }
-
-    if (gate_change)
+    if (route_input(static_cast<data_in>(kind), level))
     {
         Dprintf(("CLC%u osc_out() kind=%d level=%d enable=%d\n", index + 1,
                  kind, level, CLCenabled()));
@@ -712,19 +676,9 @@ void CLC_BASE::NCO_out(bool level)
 {
     if (NCO_level != level)
     {
-        bool gate_change = false;
         NCO_level = level;
 
-        for (int i = 0; i < 4; i++)
-        {
-            if (DxS_data[i] == NCOx)
-            {
-                lcxdT[i] = level;
-                gate_change = true;
-            }
-        }
-
-        if (gate_change)
+        if (route_input(NCOx, level))
         {
             Dprintf(("CLC%u NCO_out() level=%d enable=%d\n", index + 1,
                      level, CLCenabled()));
@@ -738,19 +692,9 @@ void CLC_BASE::ZCDx_out(bool level)
 {
     if (ZCD_level != level)
     {
-        bool gate_change = false;
         ZCD_level = level;
 
-        for (int i = 0; i < 4; i++)
-        {
-            if (DxS_data[i] == ZCD_OUT)
-            {
-                lcxdT[i] = level;
-                gate_change = true;
-            }
-        }
-
-        if (gate_change)
+        if (route_input(ZCD_OUT, level))
         {
             Dprintf(("CLC%u ZCD_out() level=%d enable=%d\n", index + 1,
                      level, CLCenabled()));
@@ -762,119 +706,42 @@ void CLC_BASE::ZCDx_out(bool level)
 //Handle updates from ATx
 void CLC_BASE::ATx_out(bool level, int v2)
 {
+    data_in source;
 
-    bool gate_change = false;
     switch(v2 & ATx::ATxMask)
     {
     case ATx::PERCLK:
-	for(int i = 0; i < 4; i++)
-	{
-	    if (DxS_data[i] == AT1_PERCLK)
-	    {
-		if (lcxdT[i] != level)
-		{
-		    lcxdT[i] = level;
-		    gate_change = true;
-		}
-	    }
-	}
-        if (gate_change)
-	{
-	    compute_gates();
-	}
+	source = AT1_PERCLK;
 	break;
 
     case ATx::MISSPUL:
-	for(int i = 0; i < 4; i++)
-	{
-	    if (DxS_data[i] == AT1_MISSPULSE)
-	    {
-		if (lcxdT[i] != level)
-		{
-		    lcxdT[i] = level;
-		    gate_change = true;
-		}
-	    }
-	}
-        if (gate_change)
-	{
-	    compute_gates();
-	}
+	source = AT1_MISSPULSE;
 	break;
 
     case ATx::PHSCLK:
-	for(int i = 0; i < 4; i++)
-	{
-	    if (DxS_data[i] == AT1_PHSCLK)
-	    {
-		if (lcxdT[i] != level)
-		{
-		    lcxdT[i] = level;
-		    gate_change = true;
-		}
-	    }
-	}
-        if (gate_change)
-	{
-	    compute_gates();
-	}
+	source = AT1_PHSCLK;
 	break;
 
     case ATx::CMP1:
-	for(int i = 0; i < 4; i++)
-	{
-	    if (DxS_data[i] == AT1_CMP1)
-	    {
-		if (lcxdT[i] != level)
-		{
-		    lcxdT[i] = level;
-		    gate_change = true;
-		}
-	    }
-	}
-        if (gate_change)
-	{
-	    compute_gates();
-	}
+	source = AT1_CMP1;
 	break;
 
     case ATx::CMP2:
-	for(int i = 0; i < 4; i++)
-	{
-	    if (DxS_data[i] == AT1_CMP2)
-	    {
-		if (lcxdT[i] != level)
-		{
-		    lcxdT[i] = level;
-		    gate_change = true;
-		}
-	    }
-	}
-        if (gate_change)
-	{
-	    compute_gates();
-	}
+	source = AT1_CMP2;
 	break;
 
     case ATx::CMP3:
-	for(int i = 0; i < 4; i++)
-	{
-	    if (DxS_data[i] == AT1_CMP3)
-	    {
-		if (lcxdT[i] != level)
-		{
-		    lcxdT[i] = level;
-		    gate_change = true;
-		}
-	    }
-	}
-        if (gate_change)
-	{
-	    compute_gates();
-	}
+	source = AT1_CMP3;
 	break;
 
+    default:
+	return;
     };
+
+    if (route_input(source, level))
+    {
+	compute_gates();
+    }
 }
 
 // Handle updates from comparator module
@@ -882,20 +749,14 @@ void CLC_BASE::CxOUT_sync(bool level, int cm)
 {
     if (CMxOUT_level[cm] != level)
     {
-        bool gate_change = false;
         CMxOUT_level[cm] = level;
 
-        for (int i = 0; i < 4; i++)
+        if (cm > 1)
         {
-            if ((DxS_data[i] == C1OUT && cm == 0) ||
-                (DxS_data[i] == C2OUT && cm == 1) )
-            {
-                lcxdT[i] = level;
-                gate_change = true;
-            }
+            return;
         }
 
-        if (gate_change)
+        if (route_input(cm ? C2OUT : C1OUT, level))
         {
             Dprintf(("CLC%u C%dOUT_sync() level=%d enable=%d\n", index + 1,
                      cm + 1, level, CLCenabled()));
@@ -913,22 +774,9 @@ void CLC_BASE::out_pwm(bool level, int id)
 
     if (pwmx_level[id] != level)
     {
-        bool gate_change = false;
         pwmx_level[id] = level;
 
-        for (int i = 0; i < 4; i++)
-        {
-            if ((DxS_data[i] == PWM1 && id == 0) ||
-                    (DxS_data[i] == PWM2 && id == 1) ||
-                    (DxS_data[i] == PWM3 && id == 2) ||
-                    (DxS_data[i] == PWM4 && id == 3))
-            {
-                lcxdT[i] = level;
-                gate_change = true;
-            }
-        }
-
-        if (gate_change)
+        if (route_input(static_cast<data_in>(PWM1 + id), level))
         {
             Dprintf(("CLC%u out_pwm() pwm%d level=%d enable=%d\n",
                      index + 1, id + 1, level, CLCenabled()));
@@ -945,22 +793,9 @@ void CLC_BASE::setState(char new3State, int id)
 
     if (state != INxstate[id])
     {
-        bool gate_change = false;
         INxstate[id] = state;
 
-        for (int i = 0; i < 4; i++)
-        {
-            if ( (DxS_data[i] == CLCxIN0 && id == 0) ||
-                 (DxS_data[i] == CLCxIN1 && id == 1) ||
-                 (DxS_data[i] == CLCxIN2 && id == 2) ||
-                 (DxS_data[i] == CLCxIN3 && id == 3) )
-            {
-                lcxdT[i] = state;
-                gate_change = true;
-            }
-        }
-
-        if (gate_change)
+        if (route_input(static_cast<data_in>(CLCxIN0 + id), state))
         {
             Dprintf(("CLC%u setState() IN%d level=%d enable=%d\n",
                      index + 1, id, state, CLCenabled()));
@@ -1032,7 +867,9 @@ void CLC_BASE::oeCLCx(bool on)
             {
                 CLCxsrc = new CLCSigSource(this, pinCLCx);
             }
-            CLCxsrc->setState((clcxcon.value.get() & LCxOE) ? '1' : '0');
+            // outputCLC() only drives the pin on output changes, so
+            // start from the current output
+            CLCxsrc->setState((clcxcon.value.get() & LCxOUT) ? '1' : '0');
 	    if (pinCLCx)
 	    {
             	CLCxgui = pinCLCx->getPin()->GUIname();
@@ -1063,40 +900,94 @@ void CLC_BASE::oeCLCx(bool on)
 }
 
 
-// Update the output value of each of the 4 Data Gates
-// taking into account both input and output polarity
-void CLC_BASE::compute_gates()
+// Compile the gate logic and combinational cell functions into
+// lookup tables indexed by the four data inputs, and the input
+// selection into a table from input source to data inputs.
+// Called whenever CLCxCON mode, CLCxPOL, CLCxGLSn or CLCxSELn change.
+void CLC_BASE::compile_tables()
 {
     unsigned int glsx[] =
     {
         clcxgls0.value.get(), clcxgls1.value.get(),
         clcxgls2.value.get(), clcxgls3.value.get()
     };
-    int mask = 0;
     unsigned int pol = clcxpol.value.get();
+    unsigned int mode = clcxcon.value.get() & LCxMODE;
 
-    // The gate logic feeds the four inputs and their inverted forms into
-    // eight AND gates with the Gate Logic Select register, then OR's the
-    // eight outputs together. This first loop constructs the normal and
-    // inverted signals on the bus as a byte, the second loop does the ANDs
-    // and the OR for each gate
-    for (int i = 0; i < 4; i++)
+    out_table = 0;
+
+    for (unsigned int in = 0; in < 16; in++)
     {
-        mask |= ( lcxdT[i] ? 2 : 1 ) << (2*i);
+        // The gate logic feeds the four inputs and their inverted forms into
+        // eight AND gates with the Gate Logic Select register, then OR's the
+        // eight outputs together. First construct the normal and inverted
+        // signals on the bus as a byte, then do the ANDs and the OR for
+        // each gate
+        unsigned int bus = 0;
+        bool g[4];
+
+        for (int i = 0; i < 4; i++)
+        {
+            bus |= ((in & (1 << i)) ? 2 : 1) << (2*i);
+        }
+
+        gate_table[in] = 0;
+
+        for (int j = 0; j < 4; j++)
+        {
+            g[j] = glsx[j] & bus;
+            if ( pol & (1 << j) )
+                g[j] = !g[j];
+            if (g[j])
+                gate_table[in] |= 1 << j;
+        }
+
+        bool out = false;
+
+        switch (mode)
+        {
+        case 0:			// AND-OR
+            out = (g[0] && g[1]) || (g[2] && g[3]);
+            break;
+
+        case 1:			// OR-XOR
+            out = (g[0] || g[1]) ^ (g[2] || g[3]);
+            break;
+
+        case 2:			// 4 input AND
+            out = g[0] && g[1] && g[2] && g[3];
+            break;
+        }
+
+        if (pol & LCxPOL)
+        {
+            out = !out;
+        }
+
+        if (out)
+        {
+            out_table |= 1 << in;
+        }
     }
-    for (int j = 0; j < 4; j++)
+
+    std::fill_n(dxs_route, DATA_IN_COUNT, 0);
+
+    for (int i = 0; i < 4; i++)
     {
-        bool gate_out = false;
-        if (glsx[j] & mask)
-            gate_out = true;
-        if ( pol & (1 << j) )
-            gate_out =  !gate_out;
-        lcxg[j] = gate_out;
+        dxs_route[DxS_data[i]] |= 1 << i;
     }
+}
+
 
+// Evaluate the cell for the current data inputs, lcxd. The data gate
+// outputs, with the gate polarity applied, are looked up in gate_table
+// and the combinational cell output in out_table, both built by
+// compile_tables(), so there is no per-call gate logic left here.
+void CLC_BASE::compute_gates()
+{
     if (CLCenabled())
     {
-        Dprintf(("CLC_BASE::compute_gates CLC%u lcxdT = {%d %d %d %d} lcxg={%d %d %d %d}\n", index + 1, lcxdT[0], lcxdT[1], lcxdT[2], lcxdT[3], lcxg[0], lcxg[1], lcxg[2], lcxg[3]));
+        Dprintf(("CLC_BASE::compute_gates CLC%u lcxd = 0x%x gates = 0x%x\n", index + 1, lcxd, gate_table[lcxd]));
     }
 
     cell_function();
@@ -1108,46 +999,48 @@ void CLC_BASE::cell_function()
 {
     bool out = false;
     unsigned int con = clcxcon.value.get();
-    unsigned int pol = clcxpol.value.get();
 
-    switch (con & 0x7)
+    if ((con & LCxMODE) <= 2)
     {
-    case 0:			// AND-OR
-        out = (lcxg[0] && lcxg[1]) || (lcxg[2] && lcxg[3]);
-        break;
-
-    case 1:			// OR-XOR
-        out = (lcxg[0] || lcxg[1]) ^ (lcxg[2] || lcxg[3]);
-        break;
+        // Combinational functions are fully precomputed
+        out = out_table & (1 << lcxd);
+    }
+    else
+    {
+        unsigned int gates = gate_table[lcxd];
 
-    case 2:			// 4 input AND
-        out = lcxg[0] && lcxg[1] && lcxg[2] && lcxg[3];
-        break;
+        for (int j = 0; j < 4; j++)
+        {
+            lcxg[j] = gates & (1 << j);
+        }
 
-    case 3:
-        out = cell_sr_latch();
-        break;
+        switch (con & LCxMODE)
+        {
+        case 3:
+            out = cell_sr_latch();
+            break;
 
-    case 4:
-        out = cell_1_in_flipflop();
-        break;
+        case 4:
+            out = cell_1_in_flipflop();
+            break;
 
-    case 5:
-        out = cell_2_in_flipflop();
-        break;
+        case 5:
+            out = cell_2_in_flipflop();
+            break;
 
-    case 6:
-        out = JKflipflop();
-        break;
+        case 6:
+            out = JKflipflop();
+            break;
 
-    case 7:
-        out = transparent_D_latch();
-        break;
-    }
+        case 7:
+            out = transparent_D_latch();
+            break;
+        }
 
-    if (pol & LCxPOL)
-    {
-        out = !out;
+        if (clcxpol.value.get() & LCxPOL)
+        {
+            out = !out;
+        }
     }
 
     if (CLCenabled())
@@ -1165,6 +1058,12 @@ void CLC_BASE::outputCLC(bool out)
     Dprintf(("outputCLC CLC%u out=%d old_out=%d clcdata=0x%x\n", index, out,
              old_out, clcdata->value.get()));
 
+    // Consumers only see output changes
+    if (out == old_out)
+    {
+        return;
+    }
+
     if (out)
     {
         con |= LCxOUT;
@@ -1353,22 +1252,7 @@ void CLC_BASE::releasePinSource(PinModule * pin)
 // Called from clcdata, process LCx_OUT updates where x = pos
 void CLC_BASE::clc_lcxupdate(bool bit_val, unsigned int pos)
 {
-    bool update = false;
-
-    for (int i = 0; i < 4; i++)
-    {
-        if ((lcxdT[i] != bit_val) &&
-                ((DxS_data[i] == LC1 && pos == 0) ||
-                 (DxS_data[i] == LC2 && pos == 1) ||
-                 (DxS_data[i] == LC3 && pos == 2) ||
-                 (DxS_data[i] == LC4 && pos == 3)))
-        {
-            update = true;
-            lcxdT[i] = bit_val;
-        }
-    }
-
-    if (update)
+    if (route_input(static_cast<data_in>(LC1 + pos), bit_val))
     {
         if (CLCenabled())
             Dprintf(("CLC%u lcxupdate LC%u_OUT=%d\n", index + 1, pos + 1,
@@ -1384,6 +1268,11 @@ void CLC_BASE::update_clccon(unsigned int diff)
 {
     unsigned int val = clcxcon.value.get();
 
+    if (diff & LCxMODE)
+    {
+        compile_tables();
+    }
+
     if (diff & LCxOE)
     {
         if ((val & (LCxOE | LCxEN)) == (LCxOE | LCxEN))
@@ -1516,6 +1405,8 @@ void CLC_BASE::config_inputs(bool on)
 		    clc_data_receiver[0] = new CLC_DATA_RECEIVER(this, "clc1_receiver");
 		    m_clc[0]->get_CLC_data_server()->attach_data(clc_data_receiver[0]);
 		}
+		// LC1_OUT is only sent on changes
+		route_input(LC1, m_clc[0]->clcxcon.value.get() & LCxOUT);
 		break;
 
 	    case LC2:
@@ -1524,6 +1415,8 @@ void CLC_BASE::config_inputs(bool on)
 		    clc_data_receiver[1] = new CLC_DATA_RECEIVER(this, "clc2_receiver");
 		    m_clc[1]->get_CLC_data_server()->attach_data(clc_data_receiver[1]);
 		}
+		// LC2_OUT is only sent on changes
+		route_input(LC2, m_clc[1]->clcxcon.value.get() & LCxOUT);
 		break;
 
 	    case LC3:
@@ -1532,6 +1425,8 @@ void CLC_BASE::config_inputs(bool on)
 		    clc_data_receiver[2] = new CLC_DATA_RECEIVER(this, "clc3_receiver");
 		    m_clc[2]->get_CLC_data_server()->attach_data(clc_data_receiver[2]);
 		}
+		// LC3_OUT is only sent on changes
+		route_input(LC3, m_clc[2]->clcxcon.value.get() & LCxOUT);
 		break;
 
 	    case LC4:
@@ -1540,6 +1435,8 @@ void CLC_BASE::config_inputs(bool on)
 		    clc_data_receiver[3] = new CLC_DATA_RECEIVER(this, "clc4_receiver");
 		    m_clc[3]->get_CLC_data_server()->attach_data(clc_data_receiver[3]);
 		}
+		// LC4_OUT is only sent on changes
+		route_input(LC4, m_clc[3]->clcxcon.value.get() & LCxOUT);
 		break;
 
 	     case ZCD_OUT:
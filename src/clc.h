@@ -278,8 +278,9 @@ public:
         TX,
         RX,
         SCK,
-        SDO
+        SDO,
 
+        DATA_IN_COUNT	// size of the input routing table
     };
 
     enum
@@ -300,10 +301,10 @@ public:
     void setCLCxPin(PinModule *alt_pin);
     void enableINxpin(int, bool);
     void setIOpin(PinModule *pin, int data) override;
-    virtual void D1S(int select) { DxS_data[0] = dxs_data[0][select];}
-    virtual void D2S(int select) { DxS_data[1] = dxs_data[1][select];}
-    virtual void D3S(int select) { DxS_data[2] = dxs_data[2][select];}
-    virtual void D4S(int select) { DxS_data[3] = dxs_data[3][select];}
+    virtual void D1S(int select) { DxS_data[0] = dxs_data[0][select]; compile_tables();}
+    virtual void D2S(int select) { DxS_data[1] = dxs_data[1][select]; compile_tables();}
+    virtual void D3S(int select) { DxS_data[2] = dxs_data[2][select]; compile_tables();}
+    virtual void D4S(int select) { DxS_data[3] = dxs_data[3][select]; compile_tables();}
     void t0_overflow();
     void t135_overflow(int timer_number);
     void t1_overflow();
@@ -341,6 +342,7 @@ public:
     void oeCLCx(bool on);
     void update_clccon(unsigned int diff);
     void config_inputs(bool on);
+    void compile_tables();
     void compute_gates();
     void cell_function();
     bool cell_1_in_flipflop();
@@ -354,6 +356,8 @@ public:
         m_Interrupt = _int;
     }
     void outputCLC(bool out);
+    bool route_input(data_in source, bool level);
+    void pulse_input(unsigned int mask);
     void set_tmr246(TMR2 *pt, int index) {p_tmr246[index] = pt;}
     void set_tmr135(TMRL *t1, TMRL *t2=nullptr, TMRL *t5=nullptr)
 	{ p_tmr135[0]=t1; p_tmr135[1]=t2; p_tmr135[2] = t5;}
@@ -394,8 +398,12 @@ private:
     bool	  CMxOUT_level[4];
     bool	  NCO_level = false;
     bool	  ZCD_level = false;
-    bool	  lcxdT[4];		// incoming data
+    unsigned int  lcxd = 0;		// incoming data, bit i is data input i
     bool	  lcxg[4];		// Data gate output
+    // Tables compiled from CLCxCON/POL/GLSx/SELx by compile_tables()
+    unsigned char gate_table[16];	// data inputs -> gate outputs
+    unsigned int  out_table = 0;	// data inputs -> output, modes 0-2
+    unsigned char dxs_route[DATA_IN_COUNT];	// source -> data inputs mask
     InterruptSource *m_Interrupt = nullptr;
     bool	  Doutput = false;
     bool	  Dclock = false;
@@ -0,0 +1,121 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "clock_domain.h"
+
+#include <algorithm>
+
+#include "gpsim_time.h"
+
+ClockDomain::ClockDomain(const char *name, uint64_t frequency)
+    : m_name(name), m_frequency(frequency), m_anchor_ps(get_cycles().time_ps())
+{
+}
+
+ClockDomain::~ClockDomain()
+{
+    while (!m_breaks.empty())
+        clear_break(m_breaks.back().second);
+}
+
+void ClockDomain::set_frequency(uint64_t frequency)
+{
+    if (frequency == m_frequency)
+        return;
+
+    uint64_t now = ticks();
+
+    m_anchor_ps = get_cycles().time_ps();
+    m_anchor_tick = now;
+    m_frequency = frequency;
+
+    // Breaks on ticks that have gone by have fired.
+    m_breaks.erase(std::remove_if(m_breaks.begin(), m_breaks.end(),
+                                  [now](const std::pair<uint64_t, TriggerObject *> &b) { return b.first < now; }),
+                   m_breaks.end());
+
+    for (const auto &b : m_breaks)
+    {
+        if (b.first == now)
+            continue;
+
+        get_cycles().clear_break(b.second);
+
+        if (m_frequency)
+            schedule(b.first, b.second);
+    }
+}
+
+uint64_t ClockDomain::ticks() const
+{
+    if (!m_frequency)
+        return m_anchor_tick;
+
+    uint64_t ps = get_cycles().time_ps();
+
+    if (ps < m_anchor_ps)
+        return m_anchor_tick;
+
+    return m_anchor_tick + Cycle_Counter::mul_div(ps - m_anchor_ps, m_frequency, Cycle_Counter::PS_PER_SECOND);
+}
+
+uint64_t ClockDomain::time_of_tick(uint64_t tick) const
+{
+    if (!m_frequency || tick < m_anchor_tick)
+        return m_anchor_ps;
+
+    return m_anchor_ps + Cycle_Counter::mul_div(tick - m_anchor_tick, Cycle_Counter::PS_PER_SECOND, m_frequency, true);
+}
+
+bool ClockDomain::set_break(uint64_t tick, TriggerObject *f)
+{
+    uint64_t now = ticks();
+
+    m_breaks.erase(std::remove_if(m_breaks.begin(), m_breaks.end(),
+                                  [now, f](const std::pair<uint64_t, TriggerObject *> &b) { return b.first < now || b.second == f; }),
+                   m_breaks.end());
+
+    if (m_frequency && !schedule(tick, f))
+        return false;
+
+    m_breaks.emplace_back(tick, f);
+    return true;
+}
+
+void ClockDomain::clear_break(TriggerObject *f)
+{
+    auto it = std::find_if(m_breaks.begin(), m_breaks.end(),
+                           [f](const std::pair<uint64_t, TriggerObject *> &b) { return b.second == f; });
+
+    if (it == m_breaks.end())
+        return;
+
+    // A break on a passed tick has fired, and the cycle counter has
+    // forgotten it.
+    if (m_frequency && it->first >= ticks())
+        get_cycles().clear_break(f);
+
+    m_breaks.erase(it);
+}
+
+bool ClockDomain::schedule(uint64_t tick, TriggerObject *f)
+{
+    return get_cycles().set_break_time(time_of_tick(tick), f);
+}
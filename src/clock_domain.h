@@ -0,0 +1,87 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_CLOCK_DOMAIN_H_
+#define SRC_CLOCK_DOMAIN_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class TriggerObject;
+
+/*
+  ClockDomain
+
+  An oscillator counting its own ticks against the absolute time of the
+  cycle counter. Peripherals clocked by something other than the
+  instruction clock, like Timer1 on the secondary oscillator, count and
+  schedule in ticks of their domain, and stay exact when the processor
+  switches clocks.
+
+  The tick count is anchored whenever the frequency changes. Breaks are
+  kept in ticks, and moved to the new time of their tick when the
+  frequency of the domain changes. A frequency of zero stops the
+  domain; its breaks are then held until it is started again. Like
+  Cycle_Counter::clear_break(), breaks are identified by their
+  TriggerObject, so each object should have one break at a time.
+*/
+class ClockDomain
+{
+public:
+    explicit ClockDomain(const char *name, uint64_t frequency = 0);
+    ~ClockDomain();
+
+    ClockDomain(const ClockDomain &) = delete;
+    ClockDomain &operator =(const ClockDomain &) = delete;
+
+    const std::string &name() const { return m_name; }
+
+    // Frequency in Hz.
+    uint64_t frequency() const { return m_frequency; }
+    void set_frequency(uint64_t frequency);
+
+    // Ticks counted up to the start of the current cycle.
+    uint64_t ticks() const;
+
+    // Absolute time of the tick, in picoseconds.
+    uint64_t time_of_tick(uint64_t tick) const;
+
+    // Calls f back on the first cycle at or after the tick. An earlier
+    // break of f must have fired, or been cleared.
+    bool set_break(uint64_t tick, TriggerObject *f);
+    void clear_break(TriggerObject *f);
+
+private:
+    bool schedule(uint64_t tick, TriggerObject *f);
+
+private:
+    std::string m_name;
+    uint64_t m_frequency;
+
+    // The domain was at anchor_tick at anchor_ps.
+    uint64_t m_anchor_ps;
+    uint64_t m_anchor_tick = 0;
+
+    std::vector<std::pair<uint64_t, TriggerObject *>> m_breaks;
+};
+
+#endif  // SRC_CLOCK_DOMAIN_H_
@@ -23,6 +23,10 @@ License along with this library; if not, see
 #include "gpsim_time.h"
 #include "processor.h"
 #include "trace.h"
+#include "translate.h"
+#include "util/assertions.h"
+#include "util/coverage.h"
+#include "util/metrics.h"
 
 //========================================================================
 ClockPhase::ClockPhase()
@@ -60,13 +64,108 @@ phaseExecute1Cycle::~phaseExecute1Cycle()
 /*
   phaseExecute1Cycle::advance() - advances a processor's time one clock cycle.
 
+  With a batch limit set, straight-line code runs on in this loop up to
+  the limit, instead of returning to Processor::step() for every
+  instruction. Scheduled events still fire, and peripherals read the
+  time, exactly as if the instructions were stepped one by one.
+  Anything that is not a single cycle instruction (branches, skips,
+  sleep, interrupts) sets another next phase and ends the batch. Only
+  the top-level phase batches; other phases calling advance() get a
+  single cycle.
+
+  When batching, straight-line runs of instructions that only use W and
+  plain general purpose registers execute up to the next cycle break
+  point before the cycle counter is advanced over them at once, see
+  straight_line.h. With a translator enabled, whole translated blocks
+  run the same way.
+  Idle and polling loops skip ahead to the next cycle break point.
  */
 
 ClockPhase *phaseExecute1Cycle::advance()
 {
-    setNextPhase(this);
-    m_pcpu->step_one();
-    get_cycles().increment();
+    Cycle_Counter &cycles = get_cycles();
+    uint64_t executed = 0;
+
+    do
+    {
+        setNextPhase(this);
+        if (m_pcpu->assertions)
+            m_pcpu->assertions->check(m_pcpu->pc->value);
+
+        bool batching = m_batchLimit > cycles.get() && !m_pcpu->assertions;
+        unsigned int pc = m_pcpu->pc->value;
+        unsigned int n = 0;
+
+        bool fastForward = batching && m_fastForward &&
+                           !m_pcpu->reverse && !m_pcpu->coverage;
+
+        if (fastForward)
+        {
+            // Stop short of the limit, where the loop would be
+            // interrupted at the same instruction as without skipping.
+            uint64_t skip = m_idleLoop.check(m_pcpu, cycles.get(),
+                                             m_pcpu->instructions_executed.get() + executed,
+                                             m_batchLimit - cycles.get() - 1);
+
+            if (skip)
+            {
+                uint64_t instructions = m_idleLoop.instructions(skip);
+
+                cycles.skip(skip);
+                executed += instructions;
+                util::metrics::count(util::metrics::IDLE_INSTRUCTIONS, instructions);
+                trace::global_writer().emplace<trace::CycleCounterEntry>(cycles.get());
+            }
+        }
+
+        if (batching)
+        {
+            uint64_t now = cycles.get();
+            uint64_t max = m_batchLimit - now;
+            uint64_t next_break = cycles.next_break();
+
+            // Only the increment after the last instruction may reach
+            // the next break.
+            if (next_break >= now && next_break - now + 1 < max)
+                max = next_break - now + 1;
+
+            if (m_pcpu->translator)
+                n = m_pcpu->translator->run(max);
+
+            if (!n)
+                n = m_straightLine.run(m_pcpu, max);
+        }
+
+        if (n)
+        {
+            if (m_pcpu->coverage)
+                m_pcpu->coverage->executed_range(pc, n);
+
+            cycles.skip(n - 1);
+            executed += n;
+        }
+        else
+        {
+            m_pcpu->step_one();
+
+            if (m_pcpu->coverage)
+                m_pcpu->coverage->executed(pc, m_pNextPhase != this);
+
+            if (fastForward && m_pNextPhase != this)
+                m_idleLoop.branched(m_pcpu, pc, m_pcpu->pc->value);
+
+            ++executed;
+        }
+
+        cycles.increment();
+    }
+    while (m_pNextPhase == this && cycles.get() < m_batchLimit &&
+           m_pcpu->mCurrentPhase == this &&
+           !(m_pcpu->assertions && m_pcpu->assertions->halted()));
+
+    m_pcpu->instructions_executed.add(executed);
+    util::metrics::observe(util::metrics::BATCH_INSTRUCTIONS, executed);
+
     return m_pNextPhase;
 }
 
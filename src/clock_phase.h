@@ -33,6 +33,11 @@ License along with this library; if not, see
   redirects control to the state machines inside of a processor.
 */
 
+#include <cstdint>
+
+#include "idle_loop.h"
+#include "straight_line.h"
+
 class Processor;
 
 class ClockPhase
@@ -73,6 +78,22 @@ public:
   explicit phaseExecute1Cycle(Processor *pcpu);
   virtual ~phaseExecute1Cycle();
   ClockPhase *advance() override;
+
+  // While the cycle counter is below the batch limit, advance() keeps
+  // executing instructions for as long as they complete in this
+  // phase. Zero disables batching.
+  void setBatchLimit(uint64_t stop_cycle) { m_batchLimit = stop_cycle; }
+
+  // While batching, fast-forward through idle and polling loops, see
+  // idle_loop.h. Enabled by default, but suspended while reverse
+  // stepping or coverage is enabled.
+  void setFastForward(bool enable) { m_fastForward = enable; m_idleLoop.reset(); }
+  bool getFastForward() const { return m_fastForward; }
+protected:
+  uint64_t m_batchLimit = 0;
+  bool m_fastForward = true;
+  IdleLoop m_idleLoop;
+  StraightLine m_straightLine;
 };
 
 class phaseExecute2ndHalf : public ProcessorPhase
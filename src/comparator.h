@@ -174,6 +174,7 @@ public:
     CMCON *_cmcon;
 
     void set_nodeVoltage(double v) override;
+    bool add_thresholds(std::vector<double> &) override { return false; }
 };
 
 class VREF_stimulus : public stimulus
@@ -187,6 +188,7 @@ public:
     ComparatorModule2 *comp;
 
     void set_nodeVoltage(double v) override;
+    bool add_thresholds(std::vector<double> &) override { return false; }
 };
 
 
@@ -201,6 +203,7 @@ public:
     CM2CON1_V2 *_cm2con1;
 
     void set_nodeVoltage(double v) override;
+    bool add_thresholds(std::vector<double> &) override { return false; }
 };
 
 
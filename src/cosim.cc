@@ -0,0 +1,421 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "cosim.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "processor.h"
+
+namespace {
+
+// Instructions take at most two cycles, so a processor stopped this
+// many cycles before a cycle has not executed it.
+const uint64_t MAX_INSTRUCTION_CYCLES = 2;
+
+// Polls before blocking on a condition variable, since the other
+// threads are usually done within microseconds.
+const unsigned int SPIN_COUNT = 4096;
+
+template<typename F>
+bool spin_until(F done)
+{
+    for (unsigned int i = 0; i < SPIN_COUNT; ++i)
+    {
+        if (done())
+            return true;
+
+        std::this_thread::yield();
+    }
+
+    return false;
+}
+
+}  // namespace
+
+//========================================================================
+
+CoSimChannel::CoSimChannel(IOPIN *from, Processor *receiver, IOPIN *to, uint64_t latency_ps)
+    : m_from(from), m_receiver(receiver), m_to(to), m_latency(latency_ps)
+{
+    m_from->getMonitor()->addSink(this);
+}
+
+CoSimChannel::~CoSimChannel()
+{
+    m_from->getMonitor()->removeSink(this);
+
+    if (!m_pending.empty())
+        get_cycles().clear_break(this);
+}
+
+void CoSimChannel::setSinkState(char state)
+{
+    if (state == m_state)
+        return;
+
+    m_state = state;
+    m_sent.push_back({get_cycles().time_ps() + m_latency, state});
+}
+
+void CoSimChannel::release()
+{
+}
+
+void CoSimChannel::callback()
+{
+    Event e = m_pending.front();
+
+    m_pending.pop_front();
+    m_to->forceDrivenState(e.state);
+
+    if (!m_pending.empty())
+        schedule();
+}
+
+void CoSimChannel::callback_print()
+{
+    std::cout << m_from->name() << " -> " << m_to->name() << " co-simulation channel CallBack ID " << CallBackID << '\n';
+}
+
+void CoSimChannel::deliver()
+{
+    if (m_sent.empty())
+        return;
+
+    bool idle = m_pending.empty();
+
+    m_pending.insert(m_pending.end(), m_sent.begin(), m_sent.end());
+    m_sent.clear();
+
+    if (idle)
+        schedule();
+}
+
+void CoSimChannel::schedule()
+{
+    get_cycles().set_break_time(m_pending.front().time_ps, this);
+}
+
+//========================================================================
+
+CoSimulation::Scope::Scope(CoSimulation *sim, Processor *cpu)
+    : m_saved(current_cycles)
+{
+    if (Cycle_Counter *c = sim->cycles(cpu))
+        current_cycles = c;
+}
+
+CoSimulation::Scope::~Scope()
+{
+    current_cycles = m_saved;
+}
+
+CoSimulation::CoSimulation(unsigned int threads)
+    : m_max_threads(threads)
+{
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    m_max_threads = 1;
+#endif
+}
+
+CoSimulation::~CoSimulation()
+{
+    stop_workers();
+
+    for (auto &ch : m_channels)
+    {
+        Scope scope(this, ch->m_receiver);
+        ch.reset();
+    }
+
+    for (auto &node : m_nodes)
+    {
+        Scope scope(this, node->cpu);
+        delete node->cpu;
+    }
+}
+
+Processor *CoSimulation::add_processor(const char *type, const char *name)
+{
+    ProcessorConstructor *pc = ProcessorConstructor::findByType(type);
+
+    if (!pc)
+        return nullptr;
+
+    auto node = std::make_unique<Node>();
+
+    node->cycles = std::make_unique<Cycle_Counter>();
+    node->trace = std::make_unique<trace::TraceBuffer>(1 << 16);
+
+    Cycle_Counter *saved = current_cycles;
+
+    current_cycles = node->cycles.get();
+    node->cpu = pc->ConstructProcessor(name);
+    current_cycles = saved;
+
+    if (!node->cpu)
+        return nullptr;
+
+    m_cpus.push_back(node->cpu);
+    m_nodes.push_back(std::move(node));
+
+    return m_cpus.back();
+}
+
+CoSimChannel *CoSimulation::connect(Processor *from, unsigned int from_pin,
+                                    Processor *to, unsigned int to_pin,
+                                    uint64_t latency_ps)
+{
+    IOPIN *src = from->get_pin(from_pin);
+    IOPIN *dst = to->get_pin(to_pin);
+
+    if (!src || !dst || !src->getMonitor() || !find(from) || !find(to))
+        return nullptr;
+
+    // Every window must let the processor that is furthest behind
+    // execute an instruction, whichever it is.
+    for (auto &node : m_nodes)
+    {
+        Cycle_Counter &c = *node->cycles;
+        uint64_t now = c.get();
+
+        if (c.time_ps(now + MAX_INSTRUCTION_CYCLES + 1) - c.time_ps(now) > latency_ps)
+        {
+            std::cout << "Error: co-simulation channel latency " << latency_ps
+                      << " ps is shorter than " << MAX_INSTRUCTION_CYCLES + 1
+                      << " cycles of " << node->cpu->name() << '\n';
+            return nullptr;
+        }
+    }
+
+    m_channels.push_back(std::make_unique<CoSimChannel>(src, to, dst, latency_ps));
+
+    return m_channels.back().get();
+}
+
+uint64_t CoSimulation::uart_latency(unsigned int baud)
+{
+    return Cycle_Counter::PS_PER_SECOND / baud / 16;
+}
+
+Cycle_Counter *CoSimulation::cycles(Processor *cpu)
+{
+    Node *node = find(cpu);
+
+    return node ? node->cycles.get() : nullptr;
+}
+
+trace::TraceBuffer *CoSimulation::trace_buffer(Processor *cpu)
+{
+    Node *node = find(cpu);
+
+    return node ? node->trace.get() : nullptr;
+}
+
+CoSimulation::Node *CoSimulation::find(Processor *cpu)
+{
+    for (auto &node : m_nodes)
+    {
+        if (node->cpu == cpu)
+            return node.get();
+    }
+
+    return nullptr;
+}
+
+uint64_t CoSimulation::time_ps()
+{
+    uint64_t t = Cycle_Counter::END_OF_TIME;
+
+    for (auto &node : m_nodes)
+        t = std::min(t, node->cycles->time_ps());
+
+    return t;
+}
+
+//------------------------------------------------------------------------
+// run_until
+//
+// Every window runs all processors up to a horizon that no level sent
+// in the window can arrive before, then hands the sent levels to the
+// receivers.
+
+void CoSimulation::run_until(uint64_t time_ps)
+{
+    uint64_t lookahead = Cycle_Counter::END_OF_TIME;
+
+    for (auto &ch : m_channels)
+        lookahead = std::min(lookahead, ch->latency());
+
+    start_workers();
+
+    for (;;)
+    {
+        uint64_t now = Cycle_Counter::END_OF_TIME;
+
+        for (auto &node : m_nodes)
+        {
+            Cycle_Counter &c = *node->cycles;
+
+            if (c.get() + MAX_INSTRUCTION_CYCLES < c.cycle_at_time(time_ps))
+                now = std::min(now, c.time_ps());
+        }
+
+        if (now == Cycle_Counter::END_OF_TIME)
+            break;
+
+        uint64_t horizon = time_ps;
+
+        if (lookahead < time_ps - now)
+            horizon = now + lookahead;
+
+        if (m_workers.empty())
+        {
+            run_share(0, horizon);
+        }
+        else
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+
+                m_horizon = horizon;
+                m_running = m_workers.size();
+                ++m_window;
+            }
+
+            m_start.notify_all();
+            run_share(0, horizon);
+
+            auto done = [this] { return m_running.load() == 0; };
+
+            if (!spin_until(done))
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_done.wait(lock, done);
+            }
+        }
+
+        for (auto &ch : m_channels)
+        {
+            Scope scope(this, ch->m_receiver);
+            ch->deliver();
+        }
+    }
+}
+
+void CoSimulation::run_node(Node &node, uint64_t horizon_ps)
+{
+    Cycle_Counter *saved = current_cycles;
+    trace::TraceBuffer *saved_trace = trace::set_thread_buffer(node.trace.get());
+
+    current_cycles = node.cycles.get();
+
+    uint64_t now = current_cycles->get();
+    uint64_t stop = current_cycles->cycle_at_time(horizon_ps);
+
+    // Nothing sent in this window arrives before the horizon, and
+    // stopping short of it leaves room to set breaks on that cycle. A
+    // processor already that close waits for the next window, while
+    // connect() makes sure the one furthest behind can always run.
+    if (stop > now + MAX_INSTRUCTION_CYCLES)
+        node.cpu->step_cycles(stop - MAX_INSTRUCTION_CYCLES - now);
+
+    current_cycles = saved;
+    trace::set_thread_buffer(saved_trace);
+}
+
+void CoSimulation::run_share(unsigned int thread, uint64_t horizon_ps)
+{
+    unsigned int n = m_workers.size() + 1;
+
+    for (std::size_t i = thread; i < m_nodes.size(); i += n)
+    {
+        Cycle_Counter &c = *m_nodes[i]->cycles;
+
+        if (c.time_ps() < horizon_ps)
+            run_node(*m_nodes[i], horizon_ps);
+    }
+}
+
+void CoSimulation::worker(unsigned int thread)
+{
+    uint64_t window = 0;
+
+    for (;;)
+    {
+        auto started = [this, window] { return m_stopping.load() || m_window.load() != window; };
+        uint64_t horizon;
+
+        spin_until(started);
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_start.wait(lock, started);
+
+            if (m_stopping)
+                return;
+
+            window = m_window;
+            horizon = m_horizon;
+        }
+
+        run_share(thread, horizon);
+
+        if (--m_running == 0)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done.notify_one();
+        }
+    }
+}
+
+void CoSimulation::start_workers()
+{
+    unsigned int threads = m_max_threads ? m_max_threads : std::thread::hardware_concurrency();
+
+    threads = std::max(1U, std::min<unsigned int>(threads, m_nodes.size()));
+
+    if (m_workers.size() + 1 == threads)
+        return;
+
+    stop_workers();
+
+    for (unsigned int t = 1; t < threads; ++t)
+        m_workers.emplace_back(&CoSimulation::worker, this, t);
+}
+
+void CoSimulation::stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_start.notify_all();
+
+    for (auto &t : m_workers)
+        t.join();
+
+    m_workers.clear();
+    m_stopping = false;
+}
@@ -0,0 +1,198 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_COSIM_H_
+#define SRC_COSIM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gpsim_time.h"
+#include "stimuli.h"
+#include "trace.h"
+#include "trigger.h"
+
+class IOPIN;
+class Processor;
+
+/*
+  CoSimChannel
+
+  A one-way digital net from an output pin of one processor to an input
+  pin of another. Level changes arrive latency picoseconds after they
+  were driven, which is what lets the processors run apart for that
+  long. The latency should be well below the timing the receiver cares
+  about, e.g. a small fraction of a UART bit.
+*/
+class CoSimChannel : public SignalSink, public TriggerObject
+{
+public:
+    CoSimChannel(IOPIN *from, Processor *receiver, IOPIN *to, uint64_t latency_ps);
+    ~CoSimChannel() override;
+
+    CoSimChannel(const CoSimChannel &) = delete;
+    CoSimChannel &operator =(const CoSimChannel &) = delete;
+
+    uint64_t latency() const { return m_latency; }
+
+    // Called on the sender's thread when the output changes.
+    void setSinkState(char) override;
+    void release() override;
+
+    // Called on the receiver's thread when a level arrives.
+    void callback() override;
+    void callback_print() override;
+
+private:
+    friend class CoSimulation;
+
+    struct Event
+    {
+        uint64_t time_ps;
+        char state;
+    };
+
+    // Moves the levels sent in the last window to the receiver. Runs
+    // between windows, with the receiver's cycle counter current.
+    void deliver();
+    void schedule();
+
+private:
+    IOPIN *m_from;
+    Processor *m_receiver;
+    IOPIN *m_to;
+    uint64_t m_latency;
+    char m_state = '?';
+
+    std::vector<Event> m_sent;     // Written by the sender.
+    std::deque<Event> m_pending;   // Read by the receiver.
+};
+
+/*
+  CoSimulation
+
+  Runs several processors, each with its own cycle counter and local
+  time, on a pool of threads. Processors only interact through
+  CoSimChannels, and are synchronized conservatively: in every window,
+  each runs up to the earliest local time plus the smallest channel
+  latency, since nothing sent in that window can arrive before then.
+  Levels sent are handed to the receivers between windows, and take
+  effect on an exact cycle of the receiver, so the result does not
+  depend on the number of threads or on how far apart the processors
+  ran.
+
+  The cycle counter of each processor is made current on the thread
+  running it, see get_cycles(), and trace entries go to a buffer per
+  processor. Use a Scope to touch a processor outside run_until(), e.g.
+  to load firmware or write registers, so breaks are set in the right
+  cycle counter.
+
+  Each window must let the processor furthest behind execute an
+  instruction, so connect() rejects latencies shorter than three cycles
+  of any processor; add the processors first. Peripherals sharing state
+  between processors outside of channels, like stimuli nodes or
+  breakpoints, are not safe with more than one thread.
+*/
+class CoSimulation
+{
+public:
+    // Uses up to threads threads, or one per core if zero.
+    explicit CoSimulation(unsigned int threads = 0);
+    ~CoSimulation();
+
+    CoSimulation(const CoSimulation &) = delete;
+    CoSimulation &operator =(const CoSimulation &) = delete;
+
+    // Makes the cycle counter of a processor current on this thread.
+    class Scope
+    {
+    public:
+        Scope(CoSimulation *sim, Processor *cpu);
+        ~Scope();
+
+    private:
+        Cycle_Counter *m_saved;
+    };
+
+    // Creates a processor of the type with its own cycle counter. The
+    // processor is owned by the co-simulation.
+    Processor *add_processor(const char *type, const char *name);
+
+    // Connects two pins, by pin number. Returns nullptr if either pin
+    // does not exist, or if the latency is shorter than three cycles
+    // of a processor added so far.
+    CoSimChannel *connect(Processor *from, unsigned int from_pin,
+                          Processor *to, unsigned int to_pin,
+                          uint64_t latency_ps);
+
+    // A latency of a sixteenth of a bit, the UART sampling interval.
+    static uint64_t uart_latency(unsigned int baud);
+
+    // Runs all processors until their local times reach the absolute
+    // time, in picoseconds.
+    void run_until(uint64_t time_ps);
+
+    // The earliest local time of all processors.
+    uint64_t time_ps();
+
+    Cycle_Counter *cycles(Processor *cpu);
+    trace::TraceBuffer *trace_buffer(Processor *cpu);
+    const std::vector<Processor *> &processors() const { return m_cpus; }
+
+private:
+    struct Node
+    {
+        Processor *cpu;
+        std::unique_ptr<Cycle_Counter> cycles;
+        std::unique_ptr<trace::TraceBuffer> trace;
+    };
+
+    Node *find(Processor *cpu);
+    void run_node(Node &node, uint64_t horizon_ps);
+    void run_share(unsigned int thread, uint64_t horizon_ps);
+    void worker(unsigned int thread);
+    void start_workers();
+    void stop_workers();
+
+private:
+    unsigned int m_max_threads;
+    std::vector<std::unique_ptr<Node>> m_nodes;
+    std::vector<Processor *> m_cpus;
+    std::vector<std::unique_ptr<CoSimChannel>> m_channels;
+
+    // The worker pool, woken once per window. Windows are often short,
+    // so waiters spin for a while before blocking.
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    std::atomic<uint64_t> m_window{0};
+    std::atomic<unsigned int> m_running{0};
+    std::atomic<bool> m_stopping{false};
+    uint64_t m_horizon = 0;
+};
+
+#endif  // SRC_COSIM_H_
@@ -792,6 +792,8 @@ void EEPROM_EXTND::callback()
       write_latches[index] = wr_data;
 
       if (wr_adr >= prog_wp) {
+        cpu->begin_program_memory_update();
+
         for (int i = 0; i < num_write_latches; i++) {
           if (write_latches[i] != LATCH_MT) {
             cpu->init_program_memory(cpu->map_pm_index2address(wr_adr + i), write_latches[i]);
@@ -799,6 +801,8 @@ void EEPROM_EXTND::callback()
           }
         }
 
+        cpu->end_program_memory_update();
+
       } else {
         printf("Warning: attempt to Write  protected Program memory 0x%x\n",
                wr_adr);
@@ -869,12 +873,16 @@ void EEPROM_EXTND::callback()
       wr_adr &= ~(erase_block_size - 1);
 
       if (wr_adr >= prog_wp) {
+        cpu->begin_program_memory_update();
+
         for (int i = 0; i < erase_block_size; i++)
           //cpu->erase_program_memory(cpu->map_pm_index2address(wr_adr+i));
         {
           cpu->init_program_memory(cpu->map_pm_index2address(wr_adr + i), 0);
         }
 
+        cpu->end_program_memory_update();
+
       } else {
         printf("Warning: attempt to row erase protected Program memory\n");
         write_error = true;
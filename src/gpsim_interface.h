@@ -27,6 +27,7 @@ License along with this library; if not, see
 #include "trigger.h"
 
 #include <list>
+#include <mutex>
 #include <string>
 
 class Stimulus;
@@ -152,6 +153,9 @@ public:
 private:
   CSimulationContext sim_context;
   std::list<Interface *> interfaces;
+  // Peripherals add interfaces while running, maybe on several threads
+  // in a CoSimulation.
+  std::mutex interfaces_mutex;
   Interface *socket_interface;
 
   unsigned int interface_seq_number;
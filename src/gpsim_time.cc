@@ -18,6 +18,7 @@ License along with this library; if not, see
 <http://www.gnu.org/licenses/lgpl-2.1.html>.
 */
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 
@@ -27,6 +28,7 @@ License along with this library; if not, see
 #include "trace.h"
 #include "ui.h"
 #include "value.h"
+#include "util/metrics.h"
 
 //#define __DEBUG_CYCLE_COUNTER__
 
@@ -129,6 +131,20 @@ void Cycle_Counter_breakpoint_list::invoke()
 }
 
 
+namespace {
+
+// Counts a break event by the class of its trigger object.
+inline void count_break(TriggerObject *f, util::metrics::BreakEvent e)
+{
+  if (f)
+    util::metrics::count_break(f->break_metrics, typeid(*f), e);
+  else
+    util::metrics::count_break("cycle break", e);
+}
+
+}  // namespace
+
+
 //--------------------------------------------------
 
 void Cycle_Counter::preset(uint64_t new_value)
@@ -141,12 +157,135 @@ void Cycle_Counter::preset(uint64_t new_value)
 void Cycle_Counter::set_instruction_cps(uint64_t cps)
 {
   if (cps) {
+    m_time_anchor_ps = time_ps(value);
+    m_cycle_anchor = value;
+    m_cps = cps;
     m_instruction_cps = (double)cps;
     m_seconds_per_cycle = 1.0 / m_instruction_cps;
+
+    // Moves the time breaks that are still ahead to their new cycles.
+    // A break on the current cycle is left alone, since it may not have
+    // fired yet and cannot be moved to an earlier cycle.
+    for (auto it = m_time_breaks.begin(); it != m_time_breaks.end();) {
+      uint64_t cycle = std::max(cycle_at_time(it->time_ps), value + 1);
+
+      if (it->cycle < value) {
+        it = m_time_breaks.erase(it);
+      } else if (it->cycle == value || it->cycle == cycle) {
+        ++it;
+      } else if (reassign_break(it->cycle, cycle, it->f)) {
+        it->cycle = cycle;
+        ++it;
+      } else {
+        it = m_time_breaks.erase(it);
+      }
+    }
   }
 }
 
 
+//--------------------------------------------------
+// Absolute time
+//
+// The products are computed in 128 bits, so neither long runs nor
+// high instruction rates overflow.
+
+uint64_t Cycle_Counter::mul_div(uint64_t a, uint64_t b, uint64_t d, bool round_up)
+{
+  const uint64_t HALF = 1ULL << 32;
+  const uint64_t MASK = HALF - 1;
+
+  // The product, in 32-bit halves.
+  uint64_t p0 = (a & MASK) * (b & MASK);
+  uint64_t p1 = (a & MASK) * (b >> 32);
+  uint64_t p2 = (a >> 32) * (b & MASK);
+  uint64_t mid = (p0 >> 32) + (p1 & MASK) + (p2 & MASK);
+  uint64_t lo = (mid << 32) | (p0 & MASK);
+  uint64_t hi = (a >> 32) * (b >> 32) + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+
+  if (round_up) {
+    uint64_t sum = lo + (d - 1);
+
+    hi += sum < lo;
+    lo = sum;
+  }
+
+  if (hi >= d)
+    return END_OF_TIME;
+
+  if (!hi)
+    return lo / d;
+
+  // Long division by two 32-bit digits, with the divisor normalized so
+  // each estimated digit is at most two too large (Knuth, algorithm D).
+  unsigned int shift = 0;
+  while (!(d & (1ULL << 63))) {
+    d <<= 1;
+    ++shift;
+  }
+
+  uint64_t un32 = shift ? (hi << shift) | (lo >> (64 - shift)) : hi;
+  uint64_t un10 = lo << shift;
+  uint64_t vn1 = d >> 32, vn0 = d & MASK;
+  uint64_t un1 = un10 >> 32, un0 = un10 & MASK;
+
+  uint64_t q1 = un32 / vn1, rhat = un32 % vn1;
+  while (q1 >= HALF || q1 * vn0 > ((rhat << 32) | un1)) {
+    --q1;
+    rhat += vn1;
+    if (rhat >= HALF)
+      break;
+  }
+
+  uint64_t un21 = (un32 << 32) + un1 - q1 * d;
+  uint64_t q0 = un21 / vn1;
+  rhat = un21 % vn1;
+  while (q0 >= HALF || q0 * vn0 > ((rhat << 32) | un0)) {
+    --q0;
+    rhat += vn1;
+    if (rhat >= HALF)
+      break;
+  }
+
+  return (q1 << 32) | q0;
+}
+
+
+uint64_t Cycle_Counter::time_ps(uint64_t cycle) const
+{
+  if (cycle >= m_cycle_anchor)
+    return m_time_anchor_ps + mul_div(cycle - m_cycle_anchor, PS_PER_SECOND, m_cps);
+
+  return m_time_anchor_ps - mul_div(m_cycle_anchor - cycle, PS_PER_SECOND, m_cps);
+}
+
+
+uint64_t Cycle_Counter::cycle_at_time(uint64_t ps) const
+{
+  if (ps >= m_time_anchor_ps)
+    return m_cycle_anchor + mul_div(ps - m_time_anchor_ps, m_cps, PS_PER_SECOND, true);
+
+  return m_cycle_anchor - mul_div(m_time_anchor_ps - ps, m_cps, PS_PER_SECOND);
+}
+
+
+bool Cycle_Counter::set_break_time(uint64_t ps, TriggerObject *f)
+{
+  // Forgets breaks that have fired.
+  m_time_breaks.erase(std::remove_if(m_time_breaks.begin(), m_time_breaks.end(),
+                                     [this](const TimeBreak &b) { return b.cycle < value; }),
+                      m_time_breaks.end());
+
+  uint64_t cycle = std::max(cycle_at_time(ps), value + 1);
+
+  if (!set_break(cycle, f))
+    return false;
+
+  m_time_breaks.push_back({ps, cycle, f});
+  return true;
+}
+
+
 //--------------------------------------------------
 // get(double seconds_from_now)
 //
@@ -175,7 +314,6 @@ uint64_t Cycle_Counter::get(double future_time_from_now)
 bool Cycle_Counter::set_break(uint64_t future_cycle, TriggerObject *f, unsigned int bpn)
 {
   Cycle_Counter_breakpoint_list  *l1 = &active, *l2;
-  static unsigned int CallBackID_Sequence = 1;
 #ifdef __DEBUG_CYCLE_COUNTER__
   std::cout << "Cycle_Counter::set_break  cycle = 0x" << std::hex << future_cycle;
   std::cout << " now=" << value;
@@ -240,9 +378,13 @@ bool Cycle_Counter::set_break(uint64_t future_cycle, TriggerObject *f, unsigned
     l1->next->bActive = true;
 
     if (f) {
-      f->CallBackID = ++CallBackID_Sequence;
+      f->CallBackID = ++m_callback_sequence;
     }
 
+    count_break(f, util::metrics::BREAK_SET);
+    note_break_change(f);
+    util::metrics::observe(util::metrics::BREAK_DELAY, future_cycle - value);
+
 #ifdef __DEBUG_CYCLE_COUNTER__
     std::cout << "set_break l1->next=" << std::hex << l1->next << " ";
 
@@ -278,6 +420,10 @@ void Cycle_Counter::clear_break(TriggerObject *f)
     return;
   }
 
+  m_time_breaks.erase(std::remove_if(m_time_breaks.begin(), m_time_breaks.end(),
+                                     [f](const TimeBreak &b) { return b.f == f; }),
+                      m_time_breaks.end());
+
   while ((l1->next) && !l2) {
     if (l1->next->f ==  f) {
       l2 = l1;
@@ -296,6 +442,9 @@ void Cycle_Counter::clear_break(TriggerObject *f)
 
   // at this point l2->next points to our break point
   // It needs to be removed from the 'active' list and put onto the 'inactive' list.
+  count_break(f, util::metrics::BREAK_CLEARED);
+  note_break_change(f);
+
   l1 = l2;
   l2 = l1->next;              // save a copy for a moment
   l1->next = l1->next->next;  // remove the break
@@ -376,6 +525,9 @@ void Cycle_Counter::clear_break(uint64_t at_cycle)
     l1->next->prev = l2;
   }
 
+  count_break(l2->f, util::metrics::BREAK_CLEARED);
+  note_break_change(l2->f);
+
   l2->clear();
   // Now move the break to the inactive list.
   l1 = inactive.next;
@@ -414,12 +566,15 @@ void Cycle_Counter::breakpoint()
       // this stops recursive callbacks
       if (l1->bActive) {
         l1->bActive = false;
+        count_break(lastBreak, util::metrics::BREAK_FIRED);
+        note_break_change(lastBreak);
         l1->f->callback();
       }
 
       clear_current_break(lastBreak);
 
     } else {
+      util::metrics::count_break("cycle break", util::metrics::BREAK_FIRED);
       clear_current_break();
     }
   }
@@ -507,6 +662,8 @@ bool Cycle_Counter::reassign_break(uint64_t old_cycle, uint64_t new_cycle, Trigg
 
   if (found_old) {
     bool break_set = false;
+
+    note_break_change(f);
     // Now move the break point
 #ifdef __DEBUG_CYCLE_COUNTER__
     std::cout << " found old ";
@@ -785,6 +942,7 @@ Cycle_Counter::Cycle_Counter()
   break_on_this = END_OF_TIME;
   m_instruction_cps = 5.0e6;
   m_seconds_per_cycle = 1 / m_instruction_cps;
+  m_cps = 5000000;
   active.next   = 0;
   active.prev   = 0;
   inactive.next = 0;
@@ -935,7 +1093,7 @@ StopWatch::~StopWatch()
 uint64_t StopWatch::get()
 {
   if (enable->get()) {
-    int64_t v = (cycles.get() - offset) % rollover->get();
+    int64_t v = (get_cycles().get() - offset) % rollover->get();
 
     if (!direction->get()) {
       v = rollover->get() - v;
@@ -983,7 +1141,7 @@ void StopWatch::set_direction(bool b)
 
   direction->set(b);
   offset =
-    cycles.get() -
+    get_cycles().get() -
     ((rollover->get() - value->get()) % rollover->get());
 
   if (break_cycle) {
@@ -1015,10 +1173,10 @@ void StopWatch::update()
 {
   if (enable->get()) {
     if (direction->get()) {
-      offset = cycles.get() - value->get();
+      offset = get_cycles().get() - value->get();
 
     } else {
-      offset = cycles.get() - (rollover->get() - value->get());
+      offset = get_cycles().get() - (rollover->get() - value->get());
     }
 
     if (break_cycle) {
@@ -1031,7 +1189,7 @@ void StopWatch::update()
 void StopWatch::update_break(bool b)
 {
   if (!b) {
-    cycles.clear_break(this);
+    get_cycles().clear_break(this);
     break_cycle = 0;
     return;
   }
@@ -1043,10 +1201,10 @@ void StopWatch::update_break(bool b)
   uint64_t old_break_cycle = break_cycle;
 
   if (direction->get()) {
-    break_cycle = cycles.get() + rollover->get()  - get();
+    break_cycle = get_cycles().get() + rollover->get()  - get();
 
   } else {
-    break_cycle = cycles.get() + get();
+    break_cycle = get_cycles().get() + get();
   }
 
   if (old_break_cycle == break_cycle) {
@@ -1054,18 +1212,18 @@ void StopWatch::update_break(bool b)
   }
 
   if (old_break_cycle) {
-    cycles.reassign_break(old_break_cycle, break_cycle, this);
+    get_cycles().reassign_break(old_break_cycle, break_cycle, this);
 
   } else {
-    cycles.set_break(break_cycle, this);
+    get_cycles().set_break(break_cycle, this);
   }
 }
 
 
 void StopWatch::callback()
 {
-  break_cycle = cycles.get() + rollover->get();
-  cycles.set_break(break_cycle, this);
+  break_cycle = get_cycles().get() + rollover->get();
+  get_cycles().set_break(break_cycle, this);
   std::cout << " stopwatch break\n";
 }
 
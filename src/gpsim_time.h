@@ -21,6 +21,9 @@ License along with this library; if not, see
 #ifndef SRC_GPSIM_TIME_H_
 #define SRC_GPSIM_TIME_H_
 
+#include <cstdint>
+#include <vector>
+
 #include "trace.h"
 #include "trigger.h"
 
@@ -41,6 +44,12 @@ class Integer;
 // at a specific instance in time can set a cycle counter break
 // point that will get invoked whenever the cycle counter reaches
 // that instance.
+//
+// The counter also keeps absolute time, in integer picoseconds. It is
+// re-anchored whenever the instruction rate changes, so the time of a
+// cycle is exact across clock switches. Time breaks are cycle breaks
+// that are moved to the cycle matching their time whenever the rate
+// changes, rather than keeping their cycle.
 
 
 
@@ -138,12 +147,28 @@ public:
     value++;
   }
 
+  /*
+    advance the Cycle Counter without checking for break points. The
+    caller must make sure none is pending before value + step, see
+    next_break().
+  */
+  inline void skip(uint64_t step)
+  {
+    value += step;
+  }
+
   // Return the current cycle counter value
   uint64_t get()
   {
     return value;
   }
 
+  // Return the cycle of the next break point, if it is not before get().
+  uint64_t next_break() const
+  {
+    return break_on_this;
+  }
+
   // Return the cycle counter for some time off in the future:
   uint64_t get(double future_time_from_now);
 
@@ -157,6 +182,31 @@ public:
 
   void clear_break(uint64_t at_cycle);
   void clear_break(TriggerObject *f);
+
+  // The cycle on which a break with a callback was last set, moved,
+  // cleared or fired. Peripherals keep part of their state in these
+  // breaks, so ReverseStepper does not rewind across such a change.
+  uint64_t last_break_change() const
+  {
+    return m_break_change;
+  }
+
+  // Absolute time at the start of the cycle, in picoseconds.
+  uint64_t time_ps() { return time_ps(value); }
+  uint64_t time_ps(uint64_t cycle) const;
+
+  // The first cycle starting at or after the time.
+  uint64_t cycle_at_time(uint64_t ps) const;
+
+  // a * b / d, rounded down or up, with the product in 128 bits.
+  // Quotients above 64 bits saturate.
+  static uint64_t mul_div(uint64_t a, uint64_t b, uint64_t d, bool round_up = false);
+
+  // Sets a break on the first cycle starting at or after the time,
+  // and keeps it there when the instruction rate changes. Cleared with
+  // clear_break(f).
+  bool set_break_time(uint64_t ps, TriggerObject *f);
+
   void set_instruction_cps(uint64_t cps);
   double instruction_cps()
   {
@@ -170,6 +220,7 @@ public:
   // Largest cycle counter value
 
   static const uint64_t  END_OF_TIME = 0xFFFFFFFFFFFFFFFFULL;
+  static const uint64_t  PS_PER_SECOND = 1000000000000ULL;
 
 
   bool reassigned = false;        // Set true when a break point is reassigned (or deleted)
@@ -193,6 +244,32 @@ private:
   double m_instruction_cps;
   double m_seconds_per_cycle;
 
+  // Absolute time is time_anchor_ps at cycle_anchor, advancing by
+  // PS_PER_SECOND / cps per cycle.
+  uint64_t m_cps;
+  uint64_t m_cycle_anchor = 0;
+  uint64_t m_time_anchor_ps = 0;
+
+  struct TimeBreak {
+    uint64_t time_ps;
+    uint64_t cycle;
+    TriggerObject *f;
+  };
+
+  std::vector<TimeBreak> m_time_breaks;
+
+  // Identifies breaks for clear_break(). Kept per counter, since each
+  // processor of a CoSimulation sets breaks on its own thread.
+  unsigned int m_callback_sequence = 1;
+
+  uint64_t m_break_change = 0;
+
+  void note_break_change(TriggerObject *f)
+  {
+    if (f && !f->stateless_breaks)
+      m_break_change = value;
+  }
+
   uint64_t value = 0;          // Current value of the cycle counter.
   uint64_t break_on_this;  // If there's a pending cycle break point, then it'll be this
 
@@ -215,9 +292,13 @@ LIBGPSIM_EXPORT Cycle_Counter &get_cycles();
 // even if cycles object can be accessed directly.
 extern Cycle_Counter cycles;
 
+// The cycle counter of the processor running on this thread. It is the
+// global one, unless a CoSimulation runs several processors at once.
+inline thread_local Cycle_Counter *current_cycles = &cycles;
+
 inline Cycle_Counter &get_cycles()
 {
-  return cycles;
+  return *current_cycles;
 }
 #endif
 
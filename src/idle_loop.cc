@@ -0,0 +1,167 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "idle_loop.h"
+
+#include <typeinfo>
+
+#include "12bit-instructions.h"
+#include "14bit-instructions.h"
+#include "16bit-instructions.h"
+#include "gpsim_time.h"
+#include "intcon.h"
+#include "ioports.h"
+#include "pic-ioports.h"
+#include "pir.h"
+#include "processor.h"
+#include "registers.h"
+
+namespace {
+
+// True if reading the register has no side effects, and its value
+// only changes through events or stimuli while the loop runs.
+bool is_event_driven(Register *reg)
+{
+    if (!reg)
+        return false;
+
+    if (typeid(*reg) == typeid(Register))
+        return true;
+
+    if (dynamic_cast<PIR *>(reg) || dynamic_cast<INTCON *>(reg))
+        return true;
+
+    // Reading a PSP port clears the input buffer flag.
+    return dynamic_cast<PortRegister *>(reg) &&
+           !dynamic_cast<PicPSP_PortRegister *>(reg);
+}
+
+}  // namespace
+
+//========================================================================
+
+void IdleLoop::candidate(Processor *cpu, unsigned int from, unsigned int to)
+{
+    if (to == m_head && from == m_tail)
+        return;
+
+    m_head = NONE;
+    m_armed = false;
+    m_period = 0;
+    m_registers.clear();
+
+    for (unsigned int i = to; i <= from; ++i)
+    {
+        instruction *inst = cpu->program_memory[i];
+
+        if (!inst || inst->isa() != instruction::NORMAL_INSTRUCTION)
+            return;
+
+        if (dynamic_cast<BTFSS *>(inst) || dynamic_cast<BTFSC *>(inst))
+        {
+            Register *reg = static_cast<Bit_op *>(inst)->reg;
+
+            // The register was resolved when the instruction last ran.
+            if (!is_event_driven(reg))
+                return;
+
+            m_registers.push_back(reg);
+        }
+        else if (!dynamic_cast<GOTO *>(inst) && !dynamic_cast<GOTO16 *>(inst) &&
+                 !dynamic_cast<BRA *>(inst) && !dynamic_cast<BRA16 *>(inst) &&
+                 !dynamic_cast<Branching *>(inst) && !dynamic_cast<NOP *>(inst))
+        {
+            return;
+        }
+    }
+
+    m_head = to;
+    m_tail = from;
+    m_values.resize(m_registers.size());
+}
+
+//------------------------------------------------------------------------
+// arrive
+//
+// The loop head is reached once per iteration. If nothing happened
+// since the previous time, the loop is periodic until the next break.
+
+uint64_t IdleLoop::arrive(Processor *cpu, uint64_t now, uint64_t executed, uint64_t max)
+{
+    unsigned int pc = cpu->pc->value;
+
+    if (pc != m_head)
+    {
+        if (pc < m_head || pc > m_tail)
+            m_head = NONE;
+
+        return 0;
+    }
+
+    uint64_t next_break = get_cycles().next_break();
+    bool changed = update_values();
+    uint64_t period = now - m_cycle;
+    uint64_t length = executed - m_executed;
+    bool quiet = m_armed && !changed && period == m_period &&
+                 length == m_length && next_break == m_break &&
+                 !(next_break >= m_cycle && next_break < now);
+
+    m_armed = true;
+    m_cycle = now;
+    m_period = period;
+    m_executed = executed;
+    m_length = length;
+    m_break = next_break;
+
+    if (!quiet || !period)
+        return 0;
+
+    // Cycles before the break point run as usual, so it fires with
+    // the same state as without skipping.
+    if (next_break >= now && next_break - now < max)
+        max = next_break - now;
+
+    uint64_t skip = max / period * period;
+
+    m_cycle += skip;
+    m_executed += instructions(skip);
+
+    return skip;
+}
+
+// Stores the current values of the tested registers, returning true
+// if any differs from the stored one.
+bool IdleLoop::update_values()
+{
+    bool changed = false;
+
+    for (std::size_t i = 0; i < m_registers.size(); ++i)
+    {
+        unsigned int value = m_registers[i]->get_value();
+
+        if (value != m_values[i])
+        {
+            changed = true;
+            m_values[i] = value;
+        }
+    }
+
+    return changed;
+}
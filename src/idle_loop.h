@@ -0,0 +1,116 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_IDLE_LOOP_H_
+#define SRC_IDLE_LOOP_H_
+
+#include <cstdint>
+#include <vector>
+
+class Processor;
+class Register;
+
+/*
+  IdleLoop
+
+  Detects idle and polling loops, like
+
+      goto    $
+
+  or
+
+      btfss   PIR1, TMR1IF
+      goto    $-1
+
+  and computes how far the execute phase may fast-forward through them.
+
+  A loop is a backward branch over at most MAX_LOOP_SIZE words, where
+  every instruction is a bit test, a branch or a NOP, and every
+  register tested is one that only changes through scheduled cycle
+  counter events or stimuli: general purpose registers (changed by
+  interrupt handlers), PIR, INTCON and I/O port registers. Once the
+  loop has completed two iterations of the same length with no event
+  in between and the tested registers unchanged, the following
+  iterations are identical until the next cycle break point, so the
+  cycle counter may skip whole iterations up to it.
+
+  Skipped iterations write no trace entries. A CycleCounterEntry marks
+  the skip instead. They are still counted as executed instructions. Reverse stepping, coverage and fuzzer edges are
+  built from executed instructions, so the execute phase does not
+  fast-forward while reverse stepping or coverage is enabled, and the
+  fuzzer disables it, see phaseExecute1Cycle::setFastForward().
+*/
+class IdleLoop
+{
+public:
+    IdleLoop() = default;
+
+    // Called by the execute phase before the instruction at the PC
+    // runs, with the number of instructions executed so far. Returns
+    // a number of cycles, at most max, that can be skipped without
+    // changing the outcome.
+    uint64_t check(Processor *cpu, uint64_t now, uint64_t executed, uint64_t max)
+    {
+        if (m_head == NONE)
+            return 0;
+
+        return arrive(cpu, now, executed, max);
+    }
+
+    // The instructions the skipped cycles would have executed.
+    uint64_t instructions(uint64_t skipped) const
+    {
+        return m_period ? skipped / m_period * m_length : 0;
+    }
+
+    // Called by the execute phase when the instruction at from
+    // branched to to.
+    void branched(Processor *cpu, unsigned int from, unsigned int to)
+    {
+        if (to <= from && from - to < MAX_LOOP_SIZE)
+            candidate(cpu, from, to);
+    }
+
+    void reset() { m_head = NONE; }
+
+    static const unsigned int MAX_LOOP_SIZE = 4;
+
+private:
+    static const unsigned int NONE = ~0U;
+
+    uint64_t arrive(Processor *cpu, uint64_t now, uint64_t executed, uint64_t max);
+    void candidate(Processor *cpu, unsigned int from, unsigned int to);
+    bool update_values();
+
+private:
+    unsigned int m_head = NONE;  // Loop start index.
+    unsigned int m_tail = 0;     // Index of the backward branch.
+    bool m_armed = false;        // m_cycle and m_values are valid.
+    uint64_t m_cycle = 0;        // When the head was last reached.
+    uint64_t m_period = 0;       // Cycles of the last iteration.
+    uint64_t m_executed = 0;     // Instructions executed at m_cycle.
+    uint64_t m_length = 0;       // Instructions of the last iteration.
+    uint64_t m_break = 0;        // Next break point at m_cycle.
+
+    std::vector<Register *> m_registers;
+    std::vector<unsigned int> m_values;
+};
+
+#endif  // SRC_IDLE_LOOP_H_
@@ -214,8 +214,16 @@ public:
 
     int check_peripheral_interrupt() override;
     void set_rbif(bool b) override;
-    void set_gie() override { put_value(value.get() | GIE); }
-    void clear_gie() override { put_value(value.get() & ~GIE); }
+    void set_gie() override
+    {
+        emplace_value_trace<trace::WriteRegisterEntry>();
+        put_value(value.get() | GIE);
+    }
+    void clear_gie() override
+    {
+        emplace_value_trace<trace::WriteRegisterEntry>();
+        put_value(value.get() & ~GIE);
+    }
     void aocxf_val(IOCxF *, unsigned int val) override;
     void reset(RESET_TYPE r) override;
 
@@ -202,6 +202,9 @@ gpsimInterface::gpsimInterface()
 
 void gpsimInterface::simulation_has_stopped()
 {
+  // So the interfaces see all entries of the run.
+  trace::flush_sinks();
+
   for (const auto &an_interface : interfaces) {
     an_interface->SimulationHasStopped(an_interface->objectPTR);
   }
@@ -261,6 +264,8 @@ void gpsimInterface::node_configuration_changed(Stimulus_Node *node)
 
 unsigned int gpsimInterface::add_interface(Interface *new_interface)
 {
+  std::lock_guard<std::mutex> lock(interfaces_mutex);
+
   interface_seq_number++;
 
   new_interface->set_id(interface_seq_number);
@@ -271,6 +276,8 @@ unsigned int gpsimInterface::add_interface(Interface *new_interface)
 
 unsigned int gpsimInterface::prepend_interface(Interface *new_interface)
 {
+  std::lock_guard<std::mutex> lock(interfaces_mutex);
+
   interface_seq_number++;
 
   new_interface->set_id(interface_seq_number);
@@ -289,6 +296,8 @@ unsigned int gpsimInterface::add_socket_interface(Interface *new_interface)
 
 void gpsimInterface::remove_interface(unsigned int interface_id)
 {
+  std::lock_guard<std::mutex> lock(interfaces_mutex);
+
   for (auto iter = interfaces.begin(); iter != interfaces.end(); ++iter) {
     Interface *an_interface = *iter;
     if (an_interface->get_id() == interface_id) {
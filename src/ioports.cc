@@ -34,6 +34,7 @@ License along with this library; if not, see
 #include "intcon.h"
 #include "modules.h"
 #include "ui.h"
+#include "util/metrics.h"
 
 //#define DEBUG
 #if defined(DEBUG)
@@ -249,7 +250,9 @@ void PortRegister::put_value(unsigned int new_value)
 {
     Dprintf(("PortRegister::put_value old=0x%x:new=0x%x\n", value.data, new_value));
 
-    unsigned int diff = mEnableMask & (new_value ^ value.data);
+    // value.data may hold the driven value, so also compare with what
+    // we drove last.
+    unsigned int diff = mEnableMask & ((new_value ^ value.data) | (new_value ^ drivingValue));
     drivingValue = new_value & mEnableMask;
     value.data = drivingValue;
 
@@ -262,7 +265,7 @@ void PortRegister::put_value(unsigned int new_value)
         // to its proper value. In either case, calling updatePort ensures
         // the drivenValue is updated properly
 
-        updatePort();
+        updatePort(diff);
     }
 }
 
@@ -371,11 +374,21 @@ PinModule * PortModule::getIOpins(unsigned int iPinNumber)
 
 void PortModule::updatePort()
 {
+    updatePort(~0U);
+}
+
+void PortModule::updatePort(unsigned int iPinBitMask)
+{
+    Stimulus_Node::beginUpdateBatch();
+
     for (unsigned int i = 0; i < mNumIopins; i++)
     {
-        if (iopins[i] != &AnInvalidPinModule)
+        if (iopins[i] != &AnInvalidPinModule &&
+                (((iPinBitMask >> i) & 1) || iopins[i]->isForcedUpdate()))
             iopins[i]->updatePinModule();
     }
+
+    Stimulus_Node::endUpdateBatch();
 }
 
 void PortModule::updatePin(unsigned int iPinNumber)
@@ -386,9 +399,7 @@ void PortModule::updatePin(unsigned int iPinNumber)
 
 void PortModule::updatePins(unsigned int iPinBitMask)
 {
-    for (unsigned int i = 0, j = 1; i < mNumIopins; i++, j <<= 1)
-        if (j & iPinBitMask && iopins[i])
-            iopins[i]->updatePinModule();
+    updatePort(iPinBitMask);
 }
 
 SignalSink *PortModule::addSink(SignalSink *new_sink, unsigned int iPinNumber)
@@ -521,6 +532,8 @@ void PinModule::refreshPinOnUpdate(bool bForcedUpdate)
 
 void PinModule::updatePinModule()
 {
+    util::metrics::count(util::metrics::PIN_UPDATES);
+
     if (!m_pin)
         return;
 
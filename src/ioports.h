@@ -165,6 +165,13 @@ public:
 
     virtual void updatePort();
 
+    /// updatePort -- Update the I/O pins in iPinBitMask, typically the
+    ///      bits changed by a register write. Pins that refresh on every
+    ///      update are always included. Node updates are batched so each
+    ///      node settles once.
+
+    virtual void updatePort(unsigned int iPinBitMask);
+
     /// updatePin -- Update a single I/O pin
 
     virtual void updatePin(unsigned int iPinNumber);
@@ -216,6 +223,7 @@ public:
     PinModule &operator [] (unsigned int pin_number);
 
     PinModule * getIOpins(unsigned int pin_number);
+    unsigned int getNumIopins() const { return mNumIopins; }
 
     // set/get OutputMask which controls bits returned on I/O
     // port register get() call. Used to return 0 for  analog pins
@@ -253,6 +261,9 @@ public:
     PinModule(PortModule *, unsigned int _pinNumber, IOPIN *new_pin = nullptr);
     virtual ~PinModule();
 
+    static void *operator new(std::size_t size) { return util::memory::allocate(util::memory::PINS, size); }
+    static void operator delete(void *p, std::size_t size) { util::memory::deallocate(util::memory::PINS, p, size); }
+
     /// updatePinModule -- The low level I/O pin state is resolved here
     /// by examining the direction and state of the I/O pin.
 
@@ -263,6 +274,7 @@ public:
     /// is updated. If false, then the pin is updated only if there
     /// is a detected state change.
     void refreshPinOnUpdate(bool bForcedUpdate);
+    bool isForcedUpdate() const { return m_bForcedUpdate; }
 
     void setPin(IOPIN *);
     void clrPin() { m_pin = nullptr; }
@@ -292,6 +304,9 @@ public:
     void putState(char) override;
     void setDirection() override;
 
+    // set_nodeVoltage() does nothing, the pin thresholds are enough.
+    bool add_thresholds(std::vector<double> &) override { return true; }
+
 private:
     char          m_cLastControlState;
     char          m_cLastSinkState;
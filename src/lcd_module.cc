@@ -273,6 +273,7 @@ void LCD_MODULE::sleep()
             phase = 0;
         }
         is_sleeping = true;
+        update_segments();
         // Set all LCD outputs to zero
         for (int l = 0; l <= mux_now; l++) // scan across com related output
         {
@@ -403,6 +404,7 @@ void LCD_MODULE::start_clock()
     lcdps->value.put(lcdps->value.get() | LCDPS::LCDA);
     if ((lcdps->value.get() & LCDPS::WFT) == 0)
         lcdps->value.put(lcdps->value.get() | LCDPS::WA);
+    update_segments();
     callback();
 }
 
@@ -486,13 +488,18 @@ void LCD_MODULE::stop_clock()
     lcd_set_com(false, lcdcon->value.get() & (LCDCON::LMUX0 | LCDCON::LMUX1));
 
     lcdps->value.put(lcdps->value.get() & ~LCDPS::LCDA);
+    update_segments();
 }
 
 void LCD_MODULE::callback()
 {
    Dprintf(("LCD_MODULE::callback() %" PRINTF_GINT64_MODIFIER "d phase=%d bias_now=%d\n", future_cycle, phase,  bias_now));
 
-    drive_lcd();
+    bool drive = drive_pins();
+    unsigned int ticks = 1;
+
+    if (drive)
+        drive_lcd();
 
     if (typeB() && (phase == (mux_now + 1)))
     {
@@ -506,16 +513,96 @@ void LCD_MODULE::callback()
         save_hold_data();
         if (!(lcdcon->value.get() & LCDCON::LCDEN))
             stop_clock();
+        else
+            update_segments();
         if (typeB())
             lcdps->value.put(lcdps->value.get() & ~LCDPS::WA);
     }
+    // When the pins are not driven, only the type B interrupt phase
+    // and the last phase of the frame need a callback.
+    if (!drive)
+    {
+        while (phase + 1 < num_phases && !(typeB() && phase == mux_now + 1))
+        {
+            phase++;
+            ticks++;
+        }
+    }
     if (lcdps->value.get() & LCDPS::LCDA)
     {
-        future_cycle = get_cycles().get() + clock_tick;
+        future_cycle = get_cycles().get() + (uint64_t)clock_tick * ticks;
         get_cycles().set_break(future_cycle, this);
     }
 }
 
+// Whether to drive the COM and SEG pins in this phase. Without a frame
+// sink they are always driven, else only if a node or an analog sink
+// is attached to one of them.
+bool LCD_MODULE::drive_pins()
+{
+    if (!frame_sink)
+        return true;
+
+    auto observed = [](PinModule *pm)
+    {
+        return pm && (pm->hasAnalogSinks() || pm->getPin()->snode);
+    };
+
+    for (int l = 0; l <= mux_now; l++)
+    {
+        if (observed(LCDcom[l]))
+            return true;
+    }
+    for (int k = 0; (k < 3) && lcdSEn[k]; k++)
+    {
+        unsigned int enable = lcdSEn[k]->value.get();
+
+        for (int i = 0; i < 8; i++)
+        {
+            if ((enable & (1 << i)) && observed(LCDsegn[k * 8 + i]))
+                return true;
+        }
+    }
+    return false;
+}
+
+void LCD_MODULE::set_frame_sink(LCDFrameSink *sink)
+{
+    frame_sink = sink;
+    if (frame_sink)
+        frame_sink->setFrame(mux_now + 1, segments);
+}
+
+// Computes the segment bitmap from the held data, and publishes it to
+// the frame sink if it changed. Segments are off while the LCD is
+// inactive or sleeping.
+void LCD_MODULE::update_segments()
+{
+    uint32_t frame[4] = {};
+
+    if ((lcdps->value.get() & LCDPS::LCDA) && !is_sleeping)
+    {
+        uint32_t enable = 0;
+
+        for (int k = 0; (k < 3) && lcdSEn[k]; k++)
+            enable |= lcdSEn[k]->value.get() << (8 * k);
+
+        for (int l = 0; l <= mux_now; l++)
+        {
+            for (int k = 0; k < 3; k++)
+                frame[l] |= (uint32_t)hold_data[k + 3 * l] << (8 * k);
+            frame[l] &= enable;
+        }
+    }
+
+    if (std::equal(frame, frame + 4, segments))
+        return;
+
+    std::copy(frame, frame + 4, segments);
+    if (frame_sink)
+        frame_sink->setFrame(mux_now + 1, segments);
+}
+
 void LCD_MODULE::save_hold_data()
 {
     for (int i = 0; i < 12; i++)
@@ -111,6 +111,20 @@ public:
     unsigned int n;
 };
 
+// LCDFrameSink - receives the segments of an LCD_MODULE in frame
+// output mode. Bit s of segments[c] is set if segment s is on for
+// common c.
+
+class LCDFrameSink
+{
+public:
+    virtual ~LCDFrameSink()
+    {
+    }
+
+    virtual void setFrame(unsigned int num_commons, const uint32_t *segments) = 0;
+};
+
 class LCD_MODULE: public TriggerObject
 {
 public:
@@ -136,12 +150,21 @@ public:
     void start_clock();
     void stop_clock();
     void drive_lcd();
+    bool drive_pins();
     void save_hold_data();
+    void update_segments();
     void start_typeA();
     void start_typeB();
     virtual void sleep();
     virtual void wake();
 
+    // Frame output mode. With a sink, the segment bitmap is published
+    // at the end of the frames where it changes, and the COM and SEG
+    // pins are only driven phase by phase while a node or an analog
+    // sink observes them. Otherwise the phases in between are skipped.
+    void set_frame_sink(LCDFrameSink *sink);
+    uint32_t get_segments(unsigned int com) const { return segments[com]; }
+
     Processor 		*cpu;
     InterruptSource 	*IntSrc = nullptr;
     bool		Vlcd1_on = false, Vlcd2_on = false, Vlcd3_on = false;
@@ -161,6 +184,8 @@ public:
     uint64_t		map_com[4];
     uint64_t		map_on;
     uint64_t		map_off;
+    LCDFrameSink	*frame_sink = nullptr;
+    uint32_t		segments[4] = {};
 
     LCDCON	*lcdcon;
     LCDPS	*lcdps;
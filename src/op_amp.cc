@@ -59,6 +59,8 @@ public:
         }
     }
 
+    bool add_thresholds(std::vector<double> &) override { return false; }
+
 private:
     OPA *_opa;
 };
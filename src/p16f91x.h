@@ -72,6 +72,10 @@ public:
   {
     return (EEPROM_WIDE *)eeprom;
   }
+  LCD_MODULE *get_lcd_module() override
+  {
+    return &lcd_module;
+  }
   void update_vdd() override;
   bool set_config_word(unsigned int address, unsigned int cfg_word) override;
   void enter_sleep() override;
@@ -20,7 +20,9 @@ License along with this library; if not, see
 
 #include <stdio.h>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "pic-instructions.h"
 
@@ -35,6 +37,78 @@ License along with this library; if not, see
 #include "registers.h"
 
 //------------------------------------------------------------------------
+namespace {
+
+// Free instruction slots, by size class.
+class SlotPool {
+public:
+  void *allocate(std::size_t size)
+  {
+    if (size > MAX_SLOT_SIZE)
+      return ::operator new(size);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<void*> &slots = m_free[size_class(size)];
+
+    if (slots.empty())
+      return ::operator new((size_class(size) + 1) * SLOT_ALIGN);
+
+    void *p = slots.back();
+    slots.pop_back();
+    return p;
+  }
+
+  void deallocate(void *p, std::size_t size)
+  {
+    if (size > MAX_SLOT_SIZE) {
+      ::operator delete(p);
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free[size_class(size)].push_back(p);
+  }
+
+private:
+  static const std::size_t SLOT_ALIGN = 16;
+  static const std::size_t MAX_SLOT_SIZE = 512;
+
+  static std::size_t size_class(std::size_t size)
+  {
+    return size ? (size - 1) / SLOT_ALIGN : 0;
+  }
+
+  std::mutex m_mutex;
+  std::vector<void*> m_free[MAX_SLOT_SIZE / SLOT_ALIGN];
+};
+
+// Never destroyed, as processors may be deleted during static
+// destruction.
+SlotPool &slot_pool()
+{
+  static SlotPool *pool = new SlotPool;
+  return *pool;
+}
+
+}  // namespace
+
+
+void *instruction::operator new(std::size_t size)
+{
+  void *p = slot_pool().allocate(size);
+
+  util::memory::account_allocation(util::memory::INSTRUCTIONS, size);
+  return p;
+}
+
+
+void instruction::operator delete(void *p, std::size_t size)
+{
+  util::memory::account_deallocation(util::memory::INSTRUCTIONS, size);
+  slot_pool().deallocate(p, size);
+}
+
+
 instruction::instruction(Processor *pProcessor,
                          unsigned int uOpCode,
                          unsigned int uAddrOfInstr)
@@ -22,6 +22,7 @@ License along with this library; if not, see
 #ifndef SRC_PIC_INSTRUCTIONS_H_
 #define SRC_PIC_INSTRUCTIONS_H_
 
+#include <cstddef>
 #include <string>
 
 #include "gpsim_object.h"
@@ -66,6 +67,11 @@ public:
   instruction(const instruction &) = delete;
   instruction& operator = (const instruction &) = delete;
 
+  // Instructions are allocated from a pool of reusable slots, since
+  // self-programming firmware replaces them one word at a time.
+  static void *operator new(std::size_t size);
+  static void operator delete(void *p, std::size_t size);
+
   virtual void execute() = 0;
   virtual void debug() {}
   virtual int instruction_size()
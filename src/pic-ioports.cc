@@ -156,18 +156,17 @@ PicTrisRegister::PicTrisRegister(Processor *pCpu, const char *pName, const char
 void PicTrisRegister::put(unsigned int new_value)
 {
     emplace_value_trace<trace::WriteRegisterEntry>();
-    value.put((value.get() & ~m_EnableMask) | (new_value & m_EnableMask));
-
-    if (m_port)
-        m_port->updatePort();
+    put_value(new_value);
 }
 
 void PicTrisRegister::put_value(unsigned int new_value)
 {
+    RegisterValue old = value;
     value.put((value.get() & ~m_EnableMask) | (new_value & m_EnableMask));
 
+    // Only pins whose direction bit changed (or was unknown) need an update.
     if (m_port)
-        m_port->updatePort();
+        m_port->updatePort((old.data ^ value.data) | old.init);
 }
 
 unsigned int PicTrisRegister::get()
@@ -275,7 +274,7 @@ void PicPortBRegister::put(unsigned int new_value)
     emplace_value_trace<trace::WriteRegisterEntry>();
 
 
-//  unsigned int diff = mEnableMask & (new_value ^ value.data);
+    unsigned int diff = mEnableMask & ((new_value ^ value.data) | (new_value ^ drivingValue));
     drivingValue = new_value & mEnableMask;
     value.data = drivingValue;
     // If no stimuli are connected to the Port pins, then the driving
@@ -283,7 +282,8 @@ void PicPortBRegister::put(unsigned int new_value)
     // stimuli (or perhaps internal peripherals) overdriving or overriding
     // this port, then the call to updatePort() will update 'drivenValue'
     // to its proper value.
-    updatePort();
+    if (diff)
+        updatePort(diff);
     lastDrivenValue = rvDrivenValue;
 
 }
@@ -570,7 +570,7 @@ void PicPSP_PortRegister::put(unsigned int new_value)
         // stimuli (or perhaps internal peripherals) overdriving or overriding
         // this port, then the call to updatePort() will update 'drivenValue'
         // to its proper value.
-        updatePort();
+        updatePort(diff);
     }
 }
 
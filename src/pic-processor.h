@@ -42,6 +42,7 @@ class EEPROM;
 class FSR;
 class INDF;
 class IOPIN;
+class LCD_MODULE;
 class PCHelper;
 class PCL;
 class PCLATH;
@@ -457,6 +458,7 @@ public:
     virtual bool swdten_active() { return true; } // WDTCON can enable WDT
     bool is_sleeping();
     void step(std::function<bool(unsigned int)> cond) override;
+    void step_cycles(uint64_t ncycles) override;
     void step_over() override;
     void step_cycle() override;
     void step_one() override;
@@ -491,6 +493,7 @@ public:
 
     virtual void set_eeprom(EEPROM *e);
     virtual EEPROM *get_eeprom() { return eeprom; }
+    virtual LCD_MODULE *get_lcd_module() { return nullptr; }
     virtual void createMCLRPin(int pkgPinNumber);
     virtual void assignMCLRPin(int pkgPinNumber);
     virtual void unassignMCLRPin();
@@ -555,6 +558,8 @@ public:
     virtual void Wput(unsigned int);
     virtual unsigned int Wget();
 
+    bool enable_reverse(bool enable) override;
+
 protected:
     ConfigMemory *m_configMemory = nullptr;
     eProcessorActivityStates m_ActivityState = ePAActive;
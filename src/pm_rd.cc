@@ -249,6 +249,7 @@ void PM_RW::write_row()
   write_latches[index] = pmdata.value.get() | (pmdath.value.get() << 8);
   get_cycles().set_break(get_cycles().get() + 2e-3 * get_cycles().instruction_cps(), this);
   rd_adr &= ~(num_latches - 1);
+  cpu->begin_program_memory_update();
 
   for (index = 0; index < num_latches; index++) {
     unsigned int opcode = cpu->get_program_memory_at_address(rd_adr);
@@ -261,6 +262,8 @@ void PM_RW::write_row()
     write_latches[index] = LATCH_EMPTY;
     rd_adr++;
   }
+
+  cpu->end_program_memory_update();
 }
 
 
@@ -274,12 +277,15 @@ void PM_RW::erase_row()
 
   get_cycles().set_break(get_cycles().get() + 2e-3 * get_cycles().instruction_cps(), this);
   rd_adr &= ~(num_latches - 1);
+  cpu->begin_program_memory_update();
 
   for (int index = 0; index < num_latches; index++) {
     cpu->init_program_memory_at_index(rd_adr, LATCH_EMPTY);
     write_latches[index] = LATCH_EMPTY;
     rd_adr++;
   }
+
+  cpu->end_program_memory_update();
 }
 
 
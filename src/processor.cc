@@ -55,10 +55,14 @@ License along with this library; if not, see
 #include "interface.h"
 #include "modules.h"
 #include "pic-processor.h"
+#include "reverse.h"
 #include "sim_context.h"
 #include "stimuli.h"
 #include "trace.h"
 #include "ui.h"
+#include "translate.h"
+#include "util/assertions.h"
+#include "util/coverage.h"
 
 
 #define STR_HELPER(x) #x
@@ -207,6 +211,15 @@ Processor::Processor(const char *_name, const char *_desc)
 //-------------------------------------------------------------------
 Processor::~Processor()
 {
+  if (assertions)
+    assertions->detach();
+
+  if (coverage)
+    coverage->detach();
+
+  delete translator;
+  delete reverse;
+
   deleteSymbol(m_pbBreakOnInvalidRegisterRead);
   deleteSymbol(m_pbBreakOnInvalidRegisterWrite);
   deleteSymbol(m_pWarnMode);
@@ -305,6 +318,7 @@ double Processor::get_frequency()
 void Processor::update_cps()
 {
   get_cycles().set_instruction_cps((uint64_t)(get_frequency() / clocks_per_inst));
+  fosc_clock.set_frequency((uint64_t)get_frequency());
 }
 
 
@@ -644,9 +658,19 @@ void Processor::init_program_memory(unsigned int address, unsigned int value)
   }
 
   if (uIndex < program_memory_size()) {
-    if (program_memory[uIndex] != 0 && program_memory[uIndex]->isa() != instruction::INVALID_INSTRUCTION) {
+    instruction *old_inst = program_memory[uIndex];
+
+    // Rewriting a word with the same value, as when a bootloader
+    // reprograms a whole row, keeps the decoded instruction.
+    if (old_inst && (old_inst->isa() == instruction::NORMAL_INSTRUCTION ||
+                     old_inst->isa() == instruction::MULTIWORD_INSTRUCTION) &&
+        old_inst->get_opcode() == value) {
+      return;
+    }
+
+    if (old_inst != 0 && old_inst->isa() != instruction::INVALID_INSTRUCTION) {
       // this should not happen
-      delete program_memory[uIndex];
+      delete old_inst;
     }
 
     program_memory[uIndex] = disasm(address, value);
@@ -655,6 +679,15 @@ void Processor::init_program_memory(unsigned int address, unsigned int value)
       program_memory[uIndex] = &bad_instruction;
     }
 
+    program_memory_changed(uIndex);
+
+    // This may be the second word of a multi-word instruction.
+    if (uIndex > 0 && program_memory[uIndex - 1] &&
+        program_memory[uIndex - 1]->isa() == instruction::MULTIWORD_INSTRUCTION) {
+      program_memory[uIndex - 1]->initialize(false);
+      program_memory_changed(uIndex - 1);
+    }
+
     //program_memory[uIndex]->add_line_number_symbol();
 
   } else if (set_config_word(address, value)) {
@@ -683,6 +716,7 @@ void Processor::erase_program_memory(unsigned int address)
     if (program_memory[uIndex] != 0 && program_memory[uIndex]->isa() != instruction::INVALID_INSTRUCTION) {
       delete program_memory[uIndex];
       program_memory[uIndex] = &bad_instruction;
+      program_memory_changed(uIndex);
     }
 
   } else {
@@ -702,9 +736,103 @@ void Processor::init_program_memory_at_index(unsigned int uIndex, unsigned int v
 void Processor::init_program_memory_at_index(unsigned int uIndex,
     const unsigned char *bytes, int nBytes)
 {
+  begin_program_memory_update();
+
   for (int i = 0; i < nBytes / 2; i++) {
     init_program_memory_at_index(uIndex + i, (((unsigned int)bytes[2 * i + 1]) << 8)  | bytes[2 * i]);
   }
+
+  end_program_memory_update();
+}
+
+
+void Processor::write_program_memory_row(unsigned int uIndex,
+    const unsigned int *words, unsigned int count)
+{
+  begin_program_memory_update();
+
+  for (unsigned int i = 0; i < count; i++) {
+    init_program_memory_at_index(uIndex + i, words[i]);
+  }
+
+  end_program_memory_update();
+}
+
+
+//-------------------------------------------------------------------
+// Program memory listeners
+//
+// Changed indices are collected as ranges while an update is in
+// progress, so a row write is one notification with one range.
+
+void Processor::begin_program_memory_update()
+{
+  ++m_pmUpdateDepth;
+}
+
+
+void Processor::end_program_memory_update()
+{
+  if (--m_pmUpdateDepth > 0 || m_pmChanged.empty()) {
+    return;
+  }
+
+  std::sort(m_pmChanged.begin(), m_pmChanged.end());
+
+  auto out = m_pmChanged.begin();
+
+  for (auto it = m_pmChanged.begin() + 1; it != m_pmChanged.end(); ++it) {
+    if (it->first <= out->second) {
+      out->second = std::max(out->second, it->second);
+
+    } else {
+      *++out = *it;
+    }
+  }
+
+  m_pmChanged.erase(out + 1, m_pmChanged.end());
+
+  // Listeners may write program memory themselves.
+  ProgramMemoryListener::Ranges ranges;
+  ranges.swap(m_pmChanged);
+
+  for (auto listener : m_pmListeners) {
+    listener->program_memory_changed(this, ranges);
+  }
+}
+
+
+void Processor::program_memory_changed(unsigned int uIndex)
+{
+  if (m_pmListeners.empty()) {
+    return;
+  }
+
+  if (!m_pmChanged.empty() && m_pmChanged.back().second == uIndex) {
+    m_pmChanged.back().second++;
+
+  } else if (m_pmChanged.empty() || m_pmChanged.back().first > uIndex ||
+             m_pmChanged.back().second < uIndex) {
+    m_pmChanged.emplace_back(uIndex, uIndex + 1);
+  }
+
+  if (!m_pmUpdateDepth) {
+    begin_program_memory_update();
+    end_program_memory_update();
+  }
+}
+
+
+void Processor::add_program_memory_listener(ProgramMemoryListener *listener)
+{
+  m_pmListeners.push_back(listener);
+}
+
+
+void Processor::remove_program_memory_listener(ProgramMemoryListener *listener)
+{
+  m_pmListeners.erase(std::remove(m_pmListeners.begin(), m_pmListeners.end(), listener),
+                      m_pmListeners.end());
 }
 
 
@@ -729,10 +857,14 @@ void Processor::build_program_memory(unsigned int *memory,
                                      unsigned int minaddr,
                                      unsigned int maxaddr)
 {
+  begin_program_memory_update();
+
   for (unsigned int i = minaddr; i <= maxaddr; i++)
     if (memory[i] != 0xffffffff) {
       init_program_memory(i, memory[i]);
     }
+
+  end_program_memory_update();
 }
 
 
@@ -858,6 +990,36 @@ Processor * Processor::construct()
 }
 
 
+//-------------------------------------------------------------------
+//
+// step_cycles - step until the cycle counter has advanced ncycles.
+//
+
+void Processor::step_cycles(uint64_t ncycles)
+{
+  uint64_t stop_cycle = get_cycles().get() + ncycles;
+
+  step([stop_cycle](unsigned int) { return get_cycles().get() < stop_cycle; });
+}
+
+
+//-------------------------------------------------------------------
+//
+// step_back, continue_back - move back in time, see reverse.h.
+//
+
+unsigned int Processor::step_back(unsigned int steps)
+{
+  return reverse ? reverse->step_back(steps) : 0;
+}
+
+
+unsigned int Processor::continue_back(unsigned int address)
+{
+  return reverse ? reverse->continue_back(address) : 0;
+}
+
+
 //-------------------------------------------------------------------
 //
 // step_over - In most cases, step_over will simulate just one instruction.
@@ -983,6 +1145,7 @@ void ProgramMemoryAccess::putToIndex(unsigned int uIndex, instruction *new_instr
   }
 
   cpu->program_memory[uIndex] = new_instruction;
+  cpu->program_memory_changed(uIndex);
 }
 
 
@@ -1154,6 +1317,7 @@ void ProgramMemoryAccess::put_opcode(unsigned int addr, unsigned int new_opcode)
   cpu->program_memory[uIndex] = new_inst;
   cpu->program_memory[uIndex]->setModified(true);
   delete old_inst;
+  cpu->program_memory_changed(uIndex);
 }
 
 
@@ -1341,6 +1505,18 @@ ProcessorConstructor::ProcessorConstructor(tCpuContructor _cpu_constructor,
 }
 
 
+ProcessorConstructor::ProcessorConstructor(tCpuContructor _cpu_constructor,
+    const char *_family,
+    const char *name1,
+    const char *name2,
+    const char *name3,
+    const char *name4)
+  : ProcessorConstructor(_cpu_constructor, name1, name2, name3, name4)
+{
+  family = _family;
+}
+
+
 //------------------------------------------------------------
 Processor * ProcessorConstructor::ConstructProcessor(const char *opt_name)
 {
@@ -1349,6 +1525,14 @@ Processor * ProcessorConstructor::ConstructProcessor(const char *opt_name)
   // this processor will be used instead. (Why 3rd?... Before optional
   // processor names were allowed, the default name matched what is now
   // the third alias; this maintains a backward compatibility).
+  if (!cpu_constructor) {
+    if (!family || !family_loader || !family_loader(family) || !cpu_constructor) {
+      std::cout << "unable to load the " << (family ? family : "unknown")
+                << " processor family\n";
+      return nullptr;
+    }
+  }
+
   if (opt_name && *opt_name != '\0') {
     return cpu_constructor(opt_name);
   }
@@ -1358,6 +1542,7 @@ Processor * ProcessorConstructor::ConstructProcessor(const char *opt_name)
 
 
 ProcessorConstructorList * ProcessorConstructor::processor_list;
+ProcessorConstructor::tFamilyLoader ProcessorConstructor::family_loader;
 
 ProcessorConstructorList * ProcessorConstructor::GetList()
 {
@@ -1391,6 +1576,25 @@ ProcessorConstructor *ProcessorConstructor::findByType(const char *name)
 }
 
 
+void ProcessorConstructor::set_family_loader(tFamilyLoader loader)
+{
+  family_loader = loader;
+}
+
+
+bool ProcessorConstructor::provide(const char *name, tCpuContructor constructor)
+{
+  ProcessorConstructor *pc = findByType(name);
+
+  if (!pc) {
+    return false;
+  }
+
+  pc->cpu_constructor = constructor;
+  return true;
+}
+
+
 //------------------------------------------------------------
 // dump() --  Print out a list of all of the processors
 //
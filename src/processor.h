@@ -28,7 +28,9 @@ License along with this library; if not, see
 #include <list>
 #include <map>
 #include <string>
+#include <utility>
 
+#include "clock_domain.h"
 #include "gpsim_classes.h"
 #include "gpsim_object.h"
 #include "modules.h"
@@ -40,7 +42,10 @@ License along with this library; if not, see
 #include "trace.h"
 #include "trigger.h"
 #include "value.h"
+#include "util/metrics.h"
 
+class BlockTranslator;
+class ReverseStepper;
 class CPU_Freq;
 class ClockPhase;
 class Processor;
@@ -52,6 +57,11 @@ class phaseExecute2ndHalf;
 class phaseIdle;
 class phaseSkip;
 
+namespace util {
+class Assertions;
+class Coverage;
+}
+
 //---------------------------------------------------------
 /// MemoryAccess - A base class designed to support
 /// access to memory. For the PIC, this class is extended by
@@ -168,6 +178,23 @@ private:
 };
 
 
+//------------------------------------------------------------------------
+//
+/// ProgramMemoryListener - is told which program memory indices have
+/// been rewritten, e.g. to invalidate anything derived from the
+/// instructions there. See Processor::add_program_memory_listener().
+
+class ProgramMemoryListener
+{
+public:
+    /// Half-open [first, last) index ranges, sorted and disjoint.
+    using Ranges = std::vector<std::pair<unsigned int, unsigned int>>;
+
+    virtual ~ProgramMemoryListener() = default;
+    virtual void program_memory_changed(Processor *cpu, const Ranges &ranges) = 0;
+};
+
+
 //------------------------------------------------------------------------
 //
 /// Processor - a generic base class for processors supported by gpsim
@@ -284,6 +311,20 @@ public:
             unsigned int value);
     virtual void init_program_memory_at_index(unsigned int address,
             const unsigned char *, int nBytes);
+
+    /// Writes a row of words starting at a program memory index. Only
+    /// words that differ from the current contents are decoded again.
+    void write_program_memory_row(unsigned int uIndex,
+                                  const unsigned int *words, unsigned int count);
+
+    /// Program memory changes between begin and end are reported to
+    /// the listeners once, as a list of ranges. Calls may nest, and
+    /// changes outside of an update are reported immediately.
+    void begin_program_memory_update();
+    void end_program_memory_update();
+    void program_memory_changed(unsigned int uIndex);
+    void add_program_memory_listener(ProgramMemoryListener *listener);
+    void remove_program_memory_listener(ProgramMemoryListener *listener);
     virtual unsigned int program_memory_size() const
     {
         return 0;
@@ -334,6 +375,9 @@ public:
     }
     virtual void inattentive(unsigned int count) {}
     virtual void step(std::function<bool(unsigned int)> cond) = 0;
+    // Steps for ncycles instruction cycles. Unlike step(), this lets
+    // the processor execute straight-line code in batches.
+    virtual void step_cycles(uint64_t ncycles);
     virtual void step_over();
     virtual void step_one() = 0;
     virtual void step_cycle() = 0;
@@ -392,6 +436,12 @@ public:
     void set_RCfreq_active(bool);
     virtual double get_frequency();
 
+    // Clock domains for peripherals that count and schedule in their
+    // own ticks, see clock_domain.h. Fosc follows get_frequency().
+    ClockDomain fosc_clock{"fosc"};
+    ClockDomain sosc_clock{"sosc", 32768};
+    ClockDomain lfintosc_clock{"lfintosc", 31000};
+
     void set_ClockCycles_per_Instruction(unsigned int cpi)
     {
         clocks_per_inst = cpi;
@@ -470,6 +520,36 @@ public:
     phaseIdle 		*mIdle = nullptr;
     phaseSkip		*mSkip = nullptr;
 
+    // Assertion engine evaluated by the execute phase, if attached.
+    util::Assertions *assertions = nullptr;
+
+    // Coverage collector updated by the execute phase, if attached.
+    util::Coverage *coverage = nullptr;
+
+    // Translation engine used by the execute phase, if enabled.
+    BlockTranslator *translator = nullptr;
+
+    // Instructions run by the execute phase, see util/metrics.h.
+    util::metrics::CoreCounter instructions_executed{this};
+
+    // Enables or disables translation of hot straight-line code, see
+    // translate.h. Returns false if the core does not support it.
+    virtual bool enable_translation(bool) { return false; }
+
+    // Reverse stepping engine, if enabled.
+    ReverseStepper *reverse = nullptr;
+
+    // Enables or disables recording the history needed for reverse
+    // stepping, see reverse.h. Returns false if the core does not
+    // support it, or another processor uses it.
+    virtual bool enable_reverse(bool) { return false; }
+
+    // Moves back by up to steps instructions, or until the program
+    // counter reaches the address. Return the number of instructions
+    // undone.
+    unsigned int step_back(unsigned int steps);
+    unsigned int continue_back(unsigned int address);
+
 protected:
     // Writes an entry to the trace buffer.
     template<typename T, typename... Args>
@@ -482,6 +562,10 @@ private:
     CPU_Freq *mFrequency;
     unsigned int  m_ProgramMemoryAllocationSize;
 
+    std::vector<ProgramMemoryListener *> m_pmListeners;
+    ProgramMemoryListener::Ranges m_pmChanged;
+    int m_pmUpdateDepth = 0;
+
     // Simulation modes
     bool bSafeMode;
     bool bWarnMode;
@@ -526,6 +610,10 @@ class ProcessorConstructor
 public:
     typedef Processor * (*tCpuContructor)(const char *_name);
 
+    // Loads the family of processors with the given name, e.g. with
+    // dlopen(). The family provides its constructors when loaded.
+    typedef bool (*tFamilyLoader)(const char *family);
+
 protected:
     // A pointer to a function that when called will construct a processor
     tCpuContructor cpu_constructor;
@@ -537,6 +625,11 @@ public:
 #define nProcessorNames 4
     const char *names[nProcessorNames];
 
+    // The family of processors in the core catalog, e.g. "p16f88x".
+    // When gpsim is built with GPSIM_LAZY_PROCESSORS, the catalog has
+    // no constructors, and ConstructProcessor() loads the family first.
+    const char *family = nullptr;
+
     //------------------------------------------------------------
     // contructor --
     //
@@ -547,6 +640,14 @@ public:
         const char *name3 = nullptr,
         const char *name4 = nullptr);
 
+    ProcessorConstructor(
+        tCpuContructor    _cpu_constructor,
+        const char *_family,
+        const char *name1,
+        const char *name2,
+        const char *name3,
+        const char *name4);
+
     virtual ~ProcessorConstructor()
     {
     }
@@ -556,8 +657,21 @@ public:
     static ProcessorConstructor * findByType(const char *type);
     static std::string listDisplayString();
 
+    // Is the processor constructible without loading its family?
+    bool isLoaded() const
+    {
+        return cpu_constructor != nullptr;
+    }
+
+    static void set_family_loader(tFamilyLoader loader);
+
+    // Called by a loaded family, to set the constructor of a processor
+    // in the catalog. Returns false if there is no such processor.
+    static bool provide(const char *name, tCpuContructor constructor);
+
 private:
     static ProcessorConstructorList * processor_list;
+    static tFamilyLoader family_loader;
 };
 
 
@@ -173,6 +173,9 @@ public:
   Register(Module *, const char *pName, const char *pDesc = nullptr, unsigned int address = AN_INVALID_ADDRESS);
   virtual ~Register();
 
+  static void *operator new(std::size_t size) { return util::memory::allocate(util::memory::REGISTERS, size); }
+  static void operator delete(void *p, std::size_t size) { util::memory::deallocate(util::memory::REGISTERS, p, size); }
+
 
   /// get - method for accessing the register's contents.
 
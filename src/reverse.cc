@@ -0,0 +1,406 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "reverse.h"
+
+#include <iostream>
+#include <map>
+#include <utility>
+
+#include "12bit-instructions.h"
+#include "14bit-instructions.h"
+#include "14bit-registers.h"
+#include "16bit-instructions.h"
+#include "clock_phase.h"
+#include "gpsim_time.h"
+#include "intcon.h"
+#include "pic-processor.h"
+
+namespace {
+
+bool is_pc_entry(trace::EntryType type)
+{
+    return type >= trace::SET_PC && type <= trace::BRANCH_PC;
+}
+
+unsigned int pc_address(const trace::EntryConstRef &ref)
+{
+    switch (ref.type())
+    {
+    case trace::SET_PC:
+        return ref.as<trace::SetPCEntry>().address();
+    case trace::INCREMENT_PC:
+        return ref.as<trace::IncrementPCEntry>().address();
+    case trace::SKIP_PC:
+        return ref.as<trace::SkipPCEntry>().address();
+    default:
+        return ref.as<trace::BranchPCEntry>().address();
+    }
+}
+
+}  // namespace
+
+//========================================================================
+
+ReverseStepper::ReverseStepper(pic_processor *cpu)
+    : m_cpu(cpu), m_history(HISTORY_SIZE)
+{
+    stateless_breaks = true;
+    m_attached = trace::set_global_history(&m_history);
+
+    if (m_attached)
+        get_cycles().set_break(get_cycles().get() + CHECKPOINT_INTERVAL, this);
+}
+
+ReverseStepper::~ReverseStepper()
+{
+    if (m_attached)
+    {
+        get_cycles().clear_break(this);
+        trace::clear_global_history(&m_history);
+    }
+}
+
+unsigned int ReverseStepper::step_back(unsigned int steps)
+{
+    return rewind(steps, NONE);
+}
+
+unsigned int ReverseStepper::continue_back(unsigned int address)
+{
+    return rewind(~0U, m_cpu->map_pm_address2index(address));
+}
+
+//------------------------------------------------------------------------
+// callback
+//
+// Checkpoints are taken between instructions. The cycle counter is
+// about to be incremented past the instruction that just ran.
+
+void ReverseStepper::callback()
+{
+    uint64_t now = get_cycles().get();
+
+    if (m_cpu->mCurrentPhase != m_cpu->mExecute1Cycle)
+    {
+        get_cycles().set_break(now + 1, this);
+        return;
+    }
+
+    take_checkpoint(now + 1);
+    get_cycles().set_break(now + CHECKPOINT_INTERVAL, this);
+}
+
+void ReverseStepper::callback_print()
+{
+    std::cout << m_cpu->name() << " reverse stepper CallBack ID " << CallBackID << '\n';
+}
+
+void ReverseStepper::take_checkpoint(uint64_t cycle)
+{
+    if (m_checkpoints.size() >= MAX_CHECKPOINTS)
+        m_checkpoints.erase(m_checkpoints.begin());
+
+    m_checkpoints.emplace_back();
+    Checkpoint &cp = m_checkpoints.back();
+    unsigned int n = m_cpu->register_memory_size();
+
+    cp.cycle = cycle;
+    cp.registers.resize(n);
+    for (unsigned int i = 0; i < n; ++i)
+        cp.registers[i] = m_cpu->registers[i]->value;
+
+    cp.w = m_cpu->Wreg->value;
+    cp.stack.assign(std::begin(m_cpu->stack->contents), std::end(m_cpu->stack->contents));
+    cp.stack_pointer = m_cpu->stack->pointer;
+
+    // Marks the position in the history.
+    trace::global_writer().emplace<trace::CycleCounterEntry>(cycle);
+}
+
+void ReverseStepper::restore_checkpoint(const Checkpoint &cp)
+{
+    for (unsigned int i = 0; i < cp.registers.size(); ++i)
+        m_cpu->registers[i]->value = cp.registers[i];
+
+    m_cpu->Wreg->value = cp.w;
+    std::copy(cp.stack.begin(), cp.stack.end(), m_cpu->stack->contents);
+    m_cpu->stack->pointer = cp.stack_pointer;
+}
+
+//------------------------------------------------------------------------
+
+Register *ReverseStepper::register_at(unsigned int address)
+{
+    if (address < m_cpu->register_memory_size())
+        return m_cpu->registers[address];
+
+    // W is not in the register file on most 12 and 14-bit cores.
+    if ((m_cpu->Wreg->getAddress() & 0xFFFF) == address)
+        return m_cpu->Wreg;
+
+    return nullptr;
+}
+
+// How the instruction at index changed the stack.
+ReverseStepper::StackOp ReverseStepper::stack_op(trace::EntryType pc_type, bool interrupt, unsigned int index)
+{
+    if (interrupt)
+        return STACK_POP;
+
+    if (index >= m_cpu->program_memory_size())
+        return STACK_NONE;
+
+    instruction *inst = m_cpu->program_memory[index];
+
+    if (pc_type == trace::BRANCH_PC &&
+        (dynamic_cast<CALL *>(inst) || dynamic_cast<CALL16 *>(inst) ||
+         dynamic_cast<RCALL *>(inst) || dynamic_cast<CALLW *>(inst)))
+        return STACK_POP;
+
+    if (dynamic_cast<PUSH *>(inst))
+        return STACK_POP;
+
+    if (pc_type == trace::SET_PC &&
+        (dynamic_cast<RETURN *>(inst) || dynamic_cast<RETLW *>(inst) ||
+         dynamic_cast<RETFIE *>(inst)))
+        return STACK_PUSH;
+
+    return STACK_NONE;
+}
+
+//------------------------------------------------------------------------
+// rewind
+//
+// Plans the steps first, walking the history backwards from the newest
+// entry, and then undoes them, since restoring the stack writes new
+// trace entries. Only the entries of the steps undone are read, and
+// indices count from the newest one.
+
+unsigned int ReverseStepper::rewind(unsigned int max_steps, unsigned int stop_index)
+{
+    if (!m_attached || m_cpu->mCurrentPhase != m_cpu->mExecute1Cycle)
+        return 0;
+
+    std::vector<trace::TraceBuffer::const_iterator> entries;
+    trace::TraceBuffer::const_iterator walk = m_history.end();
+
+    // Interrupt vectoring is the only thing clearing a global interrupt
+    // enable bit just before a branch. Finds those writes, comparing
+    // each to the next value of the register.
+    std::vector<bool> gie_cleared;
+    std::map<Register *, unsigned int> next_value;
+
+    // Reads entries up to index i. Returns false if the history has
+    // fewer.
+    auto read = [&](std::size_t i) {
+        while (entries.size() <= i && walk != m_history.begin())
+        {
+            --walk;
+
+            trace::EntryConstRef ref = *walk;
+            bool cleared = false;
+
+            if (ref.type() == trace::BASE)
+                continue;
+
+            if (ref.type() == trace::WRITE_REGISTER)
+            {
+                const trace::WriteRegisterEntry &e = ref.as<trace::WriteRegisterEntry>();
+                Register *reg = register_at(e.address());
+
+                if (dynamic_cast<INTCON *>(reg))
+                {
+                    auto it = next_value.emplace(reg, reg->value.get()).first;
+                    unsigned int gie = INTCON::GIE | INTCON::PEIE;
+
+                    cleared = (e.value() & gie) & ~it->second;
+                    it->second = e.value();
+                }
+            }
+
+            entries.push_back(walk);
+            gie_cleared.push_back(cleared);
+        }
+
+        return i < entries.size();
+    };
+
+    auto type = [&entries](std::size_t i) { return (*entries[i]).type(); };
+
+    std::vector<Step> steps;
+    std::vector<std::size_t> markers(m_checkpoints.size(), NONE);
+    std::size_t pos = 0;  // Entries undone so far.
+    uint64_t cycle = get_cycles().get();
+
+    while (steps.size() < max_steps)
+    {
+        std::size_t last = pos;
+
+        while (read(last) && !is_pc_entry(type(last)))
+            ++last;
+
+        if (!read(last))
+            break;
+
+        // A computed goto writes a SetPCEntry before incrementing.
+        std::size_t first = last;
+
+        if (type(last) == trace::INCREMENT_PC && read(last + 1) && type(last + 1) == trace::SET_PC)
+            ++first;
+
+        std::size_t begin = first;
+
+        while (read(begin + 1) && !is_pc_entry(type(begin + 1)))
+            ++begin;
+
+        // An interrupt is vectored after it is requested. The flags that
+        // caused it were set before, and stay set when stepping back.
+        bool interrupt = false;
+
+        if (type(last) == trace::BRANCH_PC)
+        {
+            std::size_t i = last + 1;
+
+            while (i <= begin && !gie_cleared[i])
+                ++i;
+
+            if (i <= begin)
+            {
+                interrupt = true;
+
+                std::size_t request = i;
+
+                while (request < begin && type(request) != trace::INTERRUPT)
+                    ++request;
+
+                begin = type(request) == trace::INTERRUPT ? request : i;
+            }
+        }
+
+        uint64_t start = cycle;
+
+        for (std::size_t i = pos; i <= begin; ++i)
+        {
+            trace::EntryConstRef ref = *entries[i];
+
+            if (ref.type() == trace::CYCLE_COUNTER)
+            {
+                start = ref.as<trace::CycleCounterEntry>().cycle();
+
+                for (std::size_t k = 0; k < m_checkpoints.size(); ++k)
+                {
+                    if (markers[k] == NONE && m_checkpoints[k].cycle == start)
+                        markers[k] = i;
+                }
+            }
+
+            if (i == last)
+                start -= type(first) == trace::INCREMENT_PC || interrupt ? 1 : 2;
+        }
+
+        // Pending cycle breaks are not in the history, so stop before
+        // an instruction that ran while they changed.
+        if (start <= get_cycles().last_break_change())
+            break;
+
+        cycle = start;
+
+        Step step;
+
+        step.begin = begin;
+        step.end = last;
+        step.pc_index = pc_address(*entries[first]);
+        step.stack_op = stack_op(type(last), interrupt, step.pc_index);
+        step.push_address = type(last) == trace::SET_PC ? (*entries[last]).as<trace::SetPCEntry>().target() : 0;
+        steps.push_back(step);
+
+        pos = begin + 1;
+
+        if (step.pc_index == stop_index)
+            break;
+    }
+
+    if (steps.empty())
+        return 0;
+
+    // Start from the earliest checkpoint after the target, if any. Its
+    // marker and the entries after it need no undoing.
+    std::size_t from = 0;
+    const Checkpoint *checkpoint = nullptr;
+
+    for (std::size_t k = 0; k < m_checkpoints.size(); ++k)
+    {
+        if (markers[k] != NONE && markers[k] < pos && markers[k] >= from)
+        {
+            from = markers[k] + 1;
+            checkpoint = &m_checkpoints[k];
+        }
+    }
+
+    std::vector<std::pair<Register *, unsigned int>> writes;
+
+    for (std::size_t i = from; i < pos; ++i)
+    {
+        trace::EntryConstRef ref = *entries[i];
+
+        if (ref.type() != trace::WRITE_REGISTER)
+            continue;
+
+        const trace::WriteRegisterEntry &e = ref.as<trace::WriteRegisterEntry>();
+        Register *reg = register_at(e.address());
+
+        if (reg)
+            writes.emplace_back(reg, e.value());
+    }
+
+    trace::TraceBuffer::const_iterator target = entries[pos - 1];
+
+    m_history.truncate(target);
+
+    if (checkpoint)
+        restore_checkpoint(*checkpoint);
+
+    for (const Step &step : steps)
+    {
+        if (step.end < from)
+            continue;
+
+        if (step.stack_op == STACK_POP)
+            m_cpu->stack->pop();
+        else if (step.stack_op == STACK_PUSH)
+            m_cpu->stack->push(step.push_address);
+    }
+
+    for (const auto &w : writes)
+        w.first->value.put(w.second);
+
+    m_cpu->pc->value = steps.back().pc_index;
+    m_cpu->pc->update_pcl();
+
+    // Drops entries written while restoring the stack.
+    m_history.truncate(target);
+    get_cycles().preset(cycle);
+
+    while (!m_checkpoints.empty() && m_checkpoints.back().cycle > cycle)
+        m_checkpoints.pop_back();
+
+    return steps.size();
+}
@@ -0,0 +1,133 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_REVERSE_H_
+#define SRC_REVERSE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "registers.h"
+#include "trace.h"
+#include "trigger.h"
+
+class pic_processor;
+
+/*
+  ReverseStepper
+
+  Moves a processor back in time, using the trace as an undo log.
+
+  Every entry written to the global trace buffer is also written to a
+  private history buffer, which readers of the global buffer cannot
+  consume. Walking the history backwards, an instruction ends at its
+  program counter entry, WriteRegisterEntries hold the value each
+  register had before the write, and the PC entries hold the index
+  of the instruction. Calls, returns and interrupts are undone on the
+  stack, using the instruction at that address and the return target
+  of SetPCEntries. Peripheral writes between two instructions are
+  undone with the later one, except for the writes that requested an
+  interrupt, which stay when stepping back over the vectoring.
+
+  The cycle counter is exact at CycleCounterEntries, such as those
+  written at the end of Processor::step(). In between, it is estimated
+  as one cycle per instruction, and two for branches and skips.
+
+  Registers changed by peripherals without a trace entry cannot be
+  recovered from the history. Checkpoints of all register values and
+  the stack are therefore taken every CHECKPOINT_INTERVAL cycles, and
+  stepping back starts from the earliest checkpoint after the target,
+  rather than the current state. Peripheral state outside registers,
+  like timer prescalers, is not restored. Peripherals also schedule
+  their events as cycle breaks, which are not in the history, so
+  stepping back stops at the last cycle any break was set, moved,
+  cleared or fired, see Cycle_Counter::last_break_change().
+
+  Registers are restored without side effects. Only one processor can
+  use reverse stepping at a time, since the trace does not record
+  which processor wrote an entry.
+*/
+class ReverseStepper : public TriggerObject
+{
+public:
+    explicit ReverseStepper(pic_processor *cpu);
+    ~ReverseStepper() override;
+
+    ReverseStepper(const ReverseStepper &) = delete;
+    ReverseStepper &operator =(const ReverseStepper &) = delete;
+
+    // True if the history buffer could be attached to the global trace.
+    bool attached() const { return m_attached; }
+
+    // Undoes up to steps instructions. Returns the number undone.
+    unsigned int step_back(unsigned int steps);
+
+    // Undoes instructions until the program counter is at the program
+    // memory address, or the history is exhausted. Returns the number
+    // undone.
+    unsigned int continue_back(unsigned int address);
+
+    void callback() override;
+    void callback_print() override;
+
+    static const unsigned int HISTORY_SIZE = 1 << 16;
+    static const uint64_t CHECKPOINT_INTERVAL = 1 << 14;
+    static const unsigned int MAX_CHECKPOINTS = 8;
+
+private:
+    static const unsigned int NONE = ~0U;
+
+    struct Checkpoint
+    {
+        uint64_t cycle;
+        std::vector<RegisterValue> registers;
+        RegisterValue w;
+        std::vector<unsigned int> stack;
+        int stack_pointer;
+    };
+
+    enum StackOp { STACK_NONE, STACK_POP, STACK_PUSH };
+
+    // An instruction to undo, with the history entries from its first
+    // one up to the end of the previous undone instruction.
+    struct Step
+    {
+        std::size_t begin;
+        std::size_t end;
+        unsigned int pc_index;
+        StackOp stack_op;
+        unsigned int push_address;
+    };
+
+    unsigned int rewind(unsigned int max_steps, unsigned int stop_index);
+    Register *register_at(unsigned int address);
+    StackOp stack_op(trace::EntryType pc_type, bool interrupt, unsigned int index);
+    void take_checkpoint(uint64_t cycle);
+    void restore_checkpoint(const Checkpoint &cp);
+
+private:
+    pic_processor *m_cpu;
+    trace::TraceBuffer m_history;
+    bool m_attached = false;
+
+    std::vector<Checkpoint> m_checkpoints;  // Oldest first.
+};
+
+#endif  // SRC_REVERSE_H_
@@ -256,7 +256,7 @@ Processor * CSimulationContext::GetActiveCPU()
 
 Cycle_Counter * CSimulationContext::GetCycleCounter()
 {
-  return &cycles;
+  return &get_cycles();
 }
 
 
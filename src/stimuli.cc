@@ -21,6 +21,7 @@ License along with this library; if not, see
 
 
 #include <stdio.h>
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <list>
@@ -39,6 +40,7 @@ License along with this library; if not, see
 #include "symbol.h"
 #include "ui.h"
 #include "value.h"
+#include "util/metrics.h"
 
 class Processor;
 
@@ -86,8 +88,8 @@ void Stimulus_Node::new_name(std::string &rName)
 
 double Stimulus_Node::get_nodeVoltage()
 {
-    if (future_cycle > cap_start_cycle) // RC calculation in progress, get current value
-        callback();
+    if (bSettling) // RC calculation in progress, get current value
+        voltage = settlingVoltage(get_cycles().get());
     return voltage;
 }
 
@@ -129,7 +131,8 @@ std::string Stimulus_Node::toString()
 
 Stimulus_Node::Stimulus_Node(const char *n)
     : TriggerObject(nullptr),
-      cap_start_cycle(0), future_cycle(0), settlingTimeStep(0)
+      cap_start_cycle(0), future_cycle(0), settlingTimeStep(0),
+      bUpdatePending(false)
 {
     warned  = 0;
     voltage = 0;
@@ -164,6 +167,14 @@ Stimulus_Node::~Stimulus_Node()
     //cout << "~Stimulus_Node\n";
     stimulus *sptr = stimuli;
 
+    // Leave a hole in the delta queues, processUpdates() skips it. A
+    // node is only queued by the thread settling it.
+    if (bUpdatePending)
+    {
+        std::replace(pendingUpdates.begin(), pendingUpdates.end(), this, (Stimulus_Node *)nullptr);
+        std::replace(deltaUpdates.begin(), deltaUpdates.end(), this, (Stimulus_Node *)nullptr);
+    }
+
     while (sptr)
     {
         sptr->detach(this);
@@ -308,87 +319,92 @@ void Stimulus_Node::update(uint64_t /* current_time */ )
 //
 void Stimulus_Node::refresh()
 {
+    util::metrics::count(util::metrics::STIMULUS_REFRESHES);
+
     if (stimuli)
     {
         stimulus *sptr = stimuli;
 
         initial_voltage = get_nodeVoltage();
 
-        switch (nStimuli)
+        if (!refreshDigital())
         {
+            switch (nStimuli)
+            {
 
-        case 0:
-            // hmm, strange nStimuli is 0, but the stimuli pointer is non null.
-            break;
+            case 0:
+                // hmm, strange nStimuli is 0, but the stimuli pointer is non null.
+                break;
 
-        case 1:
-            // Only one stimulus is attached.
-            DCVoltage = sptr->get_Vth();   // RP - was just voltage
-            Zth =  sptr->get_Zth();
-            break;
+            case 1:
+                // Only one stimulus is attached.
+                DCVoltage = sptr->get_Vth();   // RP - was just voltage
+                Zth =  sptr->get_Zth();
+                break;
 
-        case 2:
-            // 2 stimuli are attached to the node. This is the typical case
-            // and we'll optimize for it.
-        {
-            stimulus *sptr2 = sptr ? sptr->next : nullptr;
-            if (!sptr2)
-                break;     // error, nStimuli is two, but there aren't two stimuli
-
-            double V1, Z1, C1;
-            double V2, Z2, C2;
-            sptr->getThevenin(V1, Z1, C1);
-            sptr2->getThevenin(V2, Z2, C2);
-            DCVoltage = (V1 * Z2  + V2 * Z1) / (Z1 + Z2);
-            Zth = Z1 * Z2 / (Z1 + Z2);
-            Cth = C1 + C2;
+            case 2:
+                // 2 stimuli are attached to the node. This is the typical case
+                // and we'll optimize for it.
+            {
+                stimulus *sptr2 = sptr ? sptr->next : nullptr;
+                if (!sptr2)
+                    break;     // error, nStimuli is two, but there aren't two stimuli
 
-        }
-        break;
+                double V1, Z1, C1;
+                double V2, Z2, C2;
+                sptr->getThevenin(V1, Z1, C1);
+                sptr2->getThevenin(V2, Z2, C2);
+                DCVoltage = (V1 * Z2  + V2 * Z1) / (Z1 + Z2);
+                Zth = Z1 * Z2 / (Z1 + Z2);
+                Cth = C1 + C2;
 
-        default:
-        {
-            /*
-              There are 3 or more stimuli connected to this node. Recall
-              that these are all in parallel. The Thevenin voltage and
-              impedance for this is:
+            }
+            break;
 
-              Thevenin impedance:
-              Zt = 1 / sum(1/Zi)
+            default:
+            {
+                /*
+                  There are 3 or more stimuli connected to this node. Recall
+                  that these are all in parallel. The Thevenin voltage and
+                  impedance for this is:
 
-              Thevenin voltage:
+                  Thevenin impedance:
+                  Zt = 1 / sum(1/Zi)
 
-              Vt = sum( Vi / ( ((Zi - Zt)/Zt) + 1) )
-              = sum( Vi * Zt /Zi)
-              = Zt * sum(Vi/Zi)
-            */
+                  Thevenin voltage:
 
-            double conductance = 0.0;	// Thevenin conductance.
-            Cth = 0;
-            DCVoltage = 0.0;
+                  Vt = sum( Vi / ( ((Zi - Zt)/Zt) + 1) )
+                  = sum( Vi * Zt /Zi)
+                  = Zt * sum(Vi/Zi)
+                */
 
-            //cout << "multi-node summing:\n";
-            while (sptr)
-            {
+                double conductance = 0.0;	// Thevenin conductance.
+                Cth = 0;
+                DCVoltage = 0.0;
 
-                double V1, Z1, C1;
-                sptr->getThevenin(V1, Z1, C1);
-                /*
-                cout << " N: " <<sptr->name()
-                << " V=" << V1
-                << " Z=" << Z1
-                << " C=" << C1 << endl;
-                */
+                //cout << "multi-node summing:\n";
+                while (sptr)
+                {
 
-                double Cs = 1 / Z1;
-                DCVoltage += V1 * Cs;
-                conductance += Cs;
-                Cth += C1;
-                sptr = sptr->next;
+                    double V1, Z1, C1;
+                    sptr->getThevenin(V1, Z1, C1);
+                    /*
+                    cout << " N: " <<sptr->name()
+                    << " V=" << V1
+                    << " Z=" << Z1
+                    << " C=" << C1 << endl;
+                    */
+
+                    double Cs = 1 / Z1;
+                    DCVoltage += V1 * Cs;
+                    conductance += Cs;
+                    Cth += C1;
+                    sptr = sptr->next;
+                }
+                Zth = 1.0 / conductance;
+                DCVoltage *= Zth;
+            }
             }
-            Zth = 1.0 / conductance;
-            DCVoltage *= Zth;
-        }
         }
 
         current_time_constant = Cth * Zth;
@@ -408,41 +424,70 @@ void Stimulus_Node::refresh()
 
             voltage = DCVoltage;
             future_cycle = 0;
+            bSettling = false;
 
         }
         else
         {
-            settlingTimeStep = calc_settlingTimeStep();
+            /*
+            Restart the curve from the present voltage. If we were in
+            the middle of an RC calculation, initial_voltage already
+            accounts for it.
+            */
             voltage = initial_voltage;
+            cap_start_cycle = get_cycles().get();
+            bSettling = true;
+            scheduleSettling();
 
             if (verbose)
-                std::cout << "Stimulus_Node::refresh " << name() << " settlingTimeStep="
-                          << settlingTimeStep << " voltage=" << voltage << " Finalvoltage="
+                std::cout << "Stimulus_Node::refresh " << name() << " next event="
+                          << future_cycle << " voltage=" << voltage << " Finalvoltage="
                           << DCVoltage << '\n';
-            /*
-            If future_cycle is not 0 we are in the middle of an RC
-            calculation, but an input condition has changed.
-            */
-
-            if (future_cycle && (get_cycles().get() > cap_start_cycle))
-            {
-                callback();
-            }
-            else
-            {
-                if (future_cycle) get_cycles().clear_break(this);
-                cap_start_cycle = get_cycles().get();
-                future_cycle = cap_start_cycle + settlingTimeStep;
-                get_cycles().set_break(future_cycle,this);
-#ifdef DEBUG
-                get_cycles().dump_breakpoints();
-#endif
-            }
         }
 
     }
 }
 
+//------------------------------------------------------------------------
+// refreshDigital() - resolve a node with a single push-pull driver
+//
+// If one stimulus drives the node and everything else is a high
+// impedance input, the node simply follows the driver and the
+// Thevenin sums can be skipped. Returns false if the node needs the
+// full computation.
+
+bool Stimulus_Node::refreshDigital()
+{
+    stimulus *driver = nullptr;
+
+    for (stimulus *sptr = stimuli; sptr; sptr = sptr->next)
+    {
+        switch (sptr->getDigitalDrive())
+        {
+        case stimulus::DRIVE_NONE:
+            break;
+
+        case stimulus::DRIVE_PUSH_PULL:
+            if (driver)
+                return false;     // contention
+            driver = sptr;
+            break;
+
+        default:
+            return false;
+        }
+    }
+
+    if (!driver)
+        return false;           // floating
+
+    DCVoltage = driver->get_Vth();
+    Zth = driver->get_Zth();
+    Cth = 0.0;
+
+    return true;
+}
+
 uint64_t Stimulus_Node::calc_settlingTimeStep()
 {
     /* Select a time interval where the voltage does not change more
@@ -484,17 +529,165 @@ void Stimulus_Node::updateStimuli()
 
 void Stimulus_Node::update()
 {
-    if (stimuli)
+    util::metrics::count(util::metrics::STIMULUS_UPDATES);
+
+    if (!bUpdatePending)
+    {
+        bUpdatePending = true;
+        pendingUpdates.push_back(this);
+    }
+
+    if (!updateBatchDepth)
+        processUpdates();
+}
+
+unsigned int Stimulus_Node::maxDeltaCycles = 1000;
+thread_local int Stimulus_Node::updateBatchDepth = 0;
+thread_local std::vector<Stimulus_Node *> Stimulus_Node::pendingUpdates;
+thread_local std::vector<Stimulus_Node *> Stimulus_Node::deltaUpdates;
+
+void Stimulus_Node::endUpdateBatch()
+{
+    if (!--updateBatchDepth)
+        processUpdates();
+}
+
+//------------------------------------------------------------------------
+// processUpdates
+//
+// Settles the queued nodes one delta cycle at a time. Whatever the
+// stimuli do while being driven only queues nodes for the next delta,
+// so propagation through glue logic is iterative rather than
+// recursive.
+
+void Stimulus_Node::processUpdates()
+{
+    unsigned int delta = 0;
+
+    ++updateBatchDepth;
+
+    while (!pendingUpdates.empty())
     {
-        refresh();
-        updateStimuli();
+        if (++delta > maxDeltaCycles)
+        {
+            std::cout << "Warning: nodes did not settle after " << maxDeltaCycles
+                      << " delta cycles, oscillating:";
+
+            for (Stimulus_Node *node : pendingUpdates)
+            {
+                if (node)
+                {
+                    std::cout << ' ' << node->name();
+                    node->bUpdatePending = false;
+                }
+            }
+
+            std::cout << '\n';
+            pendingUpdates.clear();
+            break;
+        }
+
+        deltaUpdates.swap(pendingUpdates);
+
+        // A node deleted meanwhile leaves a null entry.
+        for (std::size_t i = 0; i < deltaUpdates.size(); ++i)
+        {
+            Stimulus_Node *node = deltaUpdates[i];
+            if (!node)
+                continue;
+
+            node->bUpdatePending = false;
+            if (node->stimuli)
+            {
+                node->refresh();
+                node->updateStimuli();
+            }
+        }
+
+        deltaUpdates.clear();
     }
+
+    --updateBatchDepth;
 }
 
 void Stimulus_Node::set_nodeVoltage(double v)
 {
     voltage = v;
+    beginUpdateBatch();
     updateStimuli();
+    endUpdateBatch();
+}
+
+//------------------------------------------------------------------------
+// settlingVoltage
+//
+// The exact RC curve, assuming no circuit changes since cap_start_cycle.
+
+double Stimulus_Node::settlingVoltage(uint64_t now) const
+{
+    double Time_Step = (now - cap_start_cycle) /
+                       (get_cycles().instruction_cps() * current_time_constant);
+
+    return DCVoltage - (DCVoltage - initial_voltage) * exp(-Time_Step);
+}
+
+//------------------------------------------------------------------------
+// scheduleSettling
+//
+// Set the break for the next time the stimuli need to see a new
+// voltage. That is the first threshold of an attached stimulus crossed
+// on the way to DCVoltage, or the point where the voltage is within
+// minThreshold of DCVoltage. If a stimulus follows the voltage
+// continuously, fall back to small steps.
+
+void Stimulus_Node::scheduleSettling()
+{
+    uint64_t now = get_cycles().get();
+    double tau = get_cycles().instruction_cps() * current_time_constant;
+    double v = settlingVoltage(now);
+    double dv0 = DCVoltage - initial_voltage;
+
+    // Cycles from cap_start_cycle until |DCVoltage - v| < minThreshold.
+    double t_next = tau * log(fabs(dv0) / minThreshold);
+
+    bool continuous = false;
+    thresholds.clear();
+
+    for (stimulus *sptr = stimuli; sptr && !continuous; sptr = sptr->next)
+        continuous = !sptr->add_thresholds(thresholds);
+
+    if (continuous)
+    {
+        voltage = v;
+        settlingTimeStep = calc_settlingTimeStep();
+        t_next = std::min(t_next, (double)(now - cap_start_cycle + settlingTimeStep));
+    }
+    else
+    {
+        for (double th : thresholds)
+        {
+            // Only thresholds strictly between v and DCVoltage.
+            if ((th - v) * (DCVoltage - v) <= 0 || fabs(th - v) >= fabs(DCVoltage - v))
+                continue;
+
+            double t = tau * log(dv0 / (DCVoltage - th));
+            if (t < t_next)
+                t_next = t;
+        }
+    }
+
+    uint64_t next = cap_start_cycle + (uint64_t)ceil(std::max(t_next, 0.0));
+    if (next <= now)
+        next = now + 1;
+
+    if (future_cycle)
+        get_cycles().reassign_break(future_cycle, next, this);
+    else
+        get_cycles().set_break(next, this);
+
+    future_cycle = next;
+
+    Dprintf(("%s next settling event at 0x%" PRINTF_INT64_T_MODIFIER "x now 0x%" PRINTF_INT64_T_MODIFIER "x\n", name().c_str(), future_cycle, now));
 }
 
 //------------------------------------------------------------------------
@@ -503,67 +696,35 @@ void Stimulus_Node::callback()
     if (verbose)
         callback_print();
 
-    initial_voltage = voltage;
-    double Time_Step;
-    double expz;
-    //
-    // increase time step as capacitor charges more slowly as final
-    // voltage is approached.
-    //
-
-    //
-    // The following is an exact calculation, assuming no circuit
-    // changes,  regardless of time step.
-    //
-    Time_Step = (get_cycles().get() - cap_start_cycle) /
-                (get_cycles().instruction_cps() * current_time_constant);
-    expz = exp(-Time_Step);
-    voltage = DCVoltage - (DCVoltage - voltage) * expz;
+    future_cycle = 0;
+    double last_voltage = voltage;
+    voltage = settlingVoltage(get_cycles().get());
 
     if (verbose)
-        std::cout << "\tVoltage was " << initial_voltage << "V now "
+        std::cout << "\tVoltage was " << last_voltage << "V now "
                   << voltage << "V\n";
 
     if (fabs(DCVoltage - voltage) < minThreshold)
     {
         voltage = DCVoltage;
-        if (future_cycle)
-            get_cycles().clear_break(this);
-        future_cycle = 0;
+        bSettling = false;
         if (verbose)
             std::cout << "\t" << name() <<
                       " Final voltage " << DCVoltage << " reached at "
                       << get_cycles().get() << " cycles\n";
         Dprintf(("%s DC Voltage %.2f reached at 0x%" PRINTF_INT64_T_MODIFIER "x cycles\n", name().c_str(), DCVoltage, get_cycles().get()));
     }
-    else if(get_cycles().get() >= future_cycle) // got here via break
-    {
-        settlingTimeStep = calc_settlingTimeStep();
-        cap_start_cycle = get_cycles().get();
-        get_cycles().clear_break(this);
-        future_cycle = cap_start_cycle + settlingTimeStep;
-        get_cycles().set_break(future_cycle, this);
-#ifdef DEBUG
-        get_cycles().dump_breakpoints();
-#endif
-        if (verbose)
-            std::cout << "\tBreak reached at " << cap_start_cycle <<
-                      " cycles, next break set for "
-                      << future_cycle << " delta=" << settlingTimeStep << '\n';
-    }
-    else	// updating value before break don't increase step size
+    else
     {
-        cap_start_cycle = get_cycles().get();
-        get_cycles().reassign_break(future_cycle,
-                                    cap_start_cycle + settlingTimeStep, this);
-        future_cycle = get_cycles().get() + settlingTimeStep;
+        scheduleSettling();
         if (verbose)
-            std::cout << "\tcallback called at " << cap_start_cycle <<
-                      " cycles, next break set for " << future_cycle << " delta="
-                      << settlingTimeStep << '\n';
+            std::cout << "\tBreak reached at " << get_cycles().get() <<
+                      " cycles, next break set for " << future_cycle << '\n';
     }
 
+    beginUpdateBatch();
     updateStimuli();
+    endUpdateBatch();
 }
 
 //------------------------------------------------------------------------
@@ -1040,6 +1201,14 @@ void IOPIN::set_nodeVoltage(double new_nodeVoltage)
         m_monitor->set_nodeVoltage(nodeVoltage);
 }
 
+bool IOPIN::add_thresholds(std::vector<double> &thresholds)
+{
+    thresholds.push_back(h2l_threshold);
+    thresholds.push_back(l2h_threshold);
+
+    return m_monitor ? m_monitor->add_thresholds(thresholds) : true;
+}
+
 //------------------------------------------------------------
 // putState - called by peripherals when they wish to
 // drive an I/O pin to a new state.
@@ -1271,6 +1440,24 @@ double IO_bi_directional::get_Zth()
     return getDriving() ? Zth : ZthIn;
 }
 
+// Uses the virtual getters, so pullups and open drain outputs in the
+// derived classes end up as DRIVE_ANALOG.
+stimulus::DigitalDrive IO_bi_directional::getDigitalDrive()
+{
+    if (get_Cth() != 0.0)
+        return DRIVE_ANALOG;
+
+    double z = get_Zth();
+
+    if (z >= ZthFloating)
+        return DRIVE_NONE;
+
+    if (getDriving() && z < ZthWeak)
+        return DRIVE_PUSH_PULL;
+
+    return DRIVE_ANALOG;
+}
+
 /*
    getBitChar() returns bit status as follows
      Input pin
@@ -24,6 +24,7 @@ License along with this library; if not, see
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include "gpsim_object.h"
 #include "trigger.h"
@@ -94,13 +95,31 @@ public:
     explicit Stimulus_Node(const char *n = nullptr);
     virtual ~Stimulus_Node();
 
+    static void *operator new(std::size_t size) { return util::memory::allocate(util::memory::STIMULUS_NODES, size); }
+    static void operator delete(void *p, std::size_t size) { util::memory::deallocate(util::memory::STIMULUS_NODES, p, size); }
+
     void   set_nodeVoltage(double v);
     double get_nodeVoltage();
     double get_nodeZth() { return Zth;}
     double get_nodeCth() { return Cth; }
 
+    // Schedules the node to be settled. Node updates are processed in
+    // delta cycles: settling a node drives its stimuli, and nodes
+    // those update in turn are queued for the next delta, so each
+    // changed node is settled once per delta no matter how many of its
+    // stimuli changed. A top level update() returns when all nodes
+    // have settled, or when maxDeltaCycles is exceeded, in which case
+    // the nodes still changing are reported as oscillating.
     void update();
 
+    // While a batch is open, update() only queues the node. The queue
+    // is processed when the outermost batch ends.
+    static void beginUpdateBatch() { ++updateBatchDepth; }
+    static void endUpdateBatch();
+
+    static unsigned int getMaxDeltaCycles() { return maxDeltaCycles; }
+    static void setMaxDeltaCycles(unsigned int n) { maxDeltaCycles = n ? n : 1; }
+
     void attach_stimulus(stimulus *);
     void detach_stimulus(stimulus *);
 
@@ -110,7 +129,9 @@ public:
     void new_name(std::string &) override;
 
     // When the node is settling (due to RC charging/discharging)
-    // it's voltage is periodically updated by invoking callback()
+    // its voltage follows a closed-form curve and is evaluated on
+    // demand. callback() is only invoked when the voltage crosses a
+    // threshold of an attached stimulus, or when settling completes.
     void callback() override;
     void callback_print() override;
 
@@ -121,10 +142,26 @@ public:
 protected:
     void update(uint64_t current_time); // deprecated
     void refresh();
+    bool refreshDigital();
     void updateStimuli();
     uint64_t calc_settlingTimeStep();
+    double settlingVoltage(uint64_t now) const;
+    void scheduleSettling();
 
     uint64_t settlingTimeStep;
+    std::vector<double> thresholds;  // Scratch space for scheduleSettling().
+
+    bool bUpdatePending;      // true when queued for the current or next delta
+
+    static void processUpdates();
+
+    static unsigned int maxDeltaCycles;
+
+    // Per thread, since a CoSimulation settles the nodes of each of
+    // its processors on the thread running it.
+    static thread_local int updateBatchDepth;
+    static thread_local std::vector<Stimulus_Node *> pendingUpdates;  // The next delta.
+    static thread_local std::vector<Stimulus_Node *> deltaUpdates;    // The current delta.
 };
 
 
@@ -167,9 +204,30 @@ public:
     virtual double get_Cth() { return Cth; }
     virtual void   set_Cth(double c) { Cth = c; }
 
-    virtual double get_nodeVoltage() { return nodeVoltage; }
+    virtual double get_nodeVoltage()
+    { return (snode && snode->bSettling) ? snode->get_nodeVoltage() : nodeVoltage; }
     virtual void   set_nodeVoltage(double v) { nodeVoltage = v; }
 
+    // Appends the node voltages at which this stimulus changes
+    // behavior. While its node is settling, set_nodeVoltage() is only
+    // called when one of these is crossed. Returns false if the
+    // stimulus must follow the node voltage continuously, which is
+    // the default. Stimuli that only compare the voltage against
+    // thresholds, or ignore it, opt in by returning true.
+    virtual bool add_thresholds(std::vector<double> &) { return false; }
+
+    // How the stimulus loads its node, for nodes that can be resolved
+    // without the Thevenin computation. A node where one stimulus is
+    // DRIVE_PUSH_PULL and all others are DRIVE_NONE takes the voltage
+    // of the driver.
+    enum DigitalDrive
+    {
+        DRIVE_ANALOG,     // Needs the full Thevenin computation.
+        DRIVE_NONE,       // High impedance input, no capacitance.
+        DRIVE_PUSH_PULL,  // Driving output, no capacitance.
+    };
+    virtual DigitalDrive getDigitalDrive() { return DRIVE_ANALOG; }
+
     virtual bool getDriving() { return bDriving; }
     virtual void setDriving(bool bNewDriving) { bDriving=bNewDriving; }
 
@@ -330,6 +388,11 @@ public:
     virtual void setDirection() = 0;
     virtual void updateUI() {}  // FIXME  - make this pure virtual too.
 
+    // See stimulus::add_thresholds.
+    virtual bool add_thresholds(std::vector<double> &) { return false; }
+
+    bool hasAnalogSinks() const { return !analogSinks.empty(); }
+
 protected:
     /// The SignalSink list is a list of all sinks that can receive digital data
     std::list<SignalSink *> sinks;
@@ -364,6 +427,9 @@ public:
 
     ~IOPIN();
 
+    static void *operator new(std::size_t size) { return util::memory::allocate(util::memory::PINS, size); }
+    static void operator delete(void *p, std::size_t size) { util::memory::deallocate(util::memory::PINS, p, size); }
+
     virtual void setMonitor(PinMonitor *);
     virtual PinMonitor *getMonitor() { return m_monitor; }
     void set_nodeVoltage(double v) override;
@@ -388,6 +454,7 @@ public:
     virtual double get_l2h_threshold() { return l2h_threshold;}
     virtual void set_h2l_threshold(double V) {h2l_threshold = V;}
     virtual double get_h2l_threshold() { return h2l_threshold;}
+    bool add_thresholds(std::vector<double> &) override;
 
     virtual void toggle();
     void attach(Stimulus_Node *s) override;
@@ -464,6 +531,7 @@ public:
     IOPIN_DIRECTION  get_direction() override
     {return getDriving() ? DIR_OUTPUT : DIR_INPUT;}
     void   getThevenin(double &v, double &z, double &c) override;
+    DigitalDrive getDigitalDrive() override;
     virtual bool getPullupStatus() { return false;}
 
 protected:
@@ -0,0 +1,159 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+
+#include "straight_line.h"
+
+#include <algorithm>
+#include <typeinfo>
+
+#include "12bit-instructions.h"
+#include "14bit-instructions.h"
+#include "16bit-instructions.h"
+#include "16bit-processors.h"
+#include "registers.h"
+
+namespace {
+
+bool is_plain(Register *reg)
+{
+    return reg && typeid(*reg) == typeid(Register);
+}
+
+}  // namespace
+
+//========================================================================
+
+StraightLine::~StraightLine()
+{
+    if (m_cpu)
+        m_cpu->remove_program_memory_listener(this);
+}
+
+void StraightLine::attach(Processor *cpu)
+{
+    m_cpu = cpu;
+    m_cpu16 = dynamic_cast<_16bit_processor *>(cpu);
+    m_kinds.assign(cpu->program_memory_size(), UNKNOWN);
+    m_cpu->add_program_memory_listener(this);
+}
+
+void StraightLine::program_memory_changed(Processor *, const Ranges &ranges)
+{
+    for (const auto &range : ranges)
+    {
+        unsigned int last = std::min<std::size_t>(range.second, m_kinds.size());
+
+        for (unsigned int i = range.first; i < last; ++i)
+            m_kinds[i] = UNKNOWN;
+    }
+}
+
+StraightLine::Kind StraightLine::classify(instruction *inst)
+{
+    if (!inst || inst->isa() != instruction::NORMAL_INSTRUCTION)
+        return OTHER;
+
+    // Skips change the next phase, and TRIS writes a port direction.
+    if (dynamic_cast<BTFSS *>(inst) || dynamic_cast<BTFSC *>(inst) ||
+            dynamic_cast<DECFSZ *>(inst) || dynamic_cast<INCFSZ *>(inst) ||
+            dynamic_cast<DCFSNZ *>(inst) || dynamic_cast<INFSNZ *>(inst) ||
+            dynamic_cast<CPFSEQ *>(inst) || dynamic_cast<CPFSGT *>(inst) ||
+            dynamic_cast<CPFSLT *>(inst) || dynamic_cast<TSTFSZ *>(inst) ||
+            dynamic_cast<TRIS *>(inst) || dynamic_cast<RETLW *>(inst))
+        return OTHER;
+
+    if (dynamic_cast<Register_op *>(inst))
+        return REGISTER_OP;
+
+    if (dynamic_cast<Bit_op *>(inst))
+        return BIT_OP;
+
+    if (dynamic_cast<Literal_op *>(inst) || dynamic_cast<NOP *>(inst) ||
+            dynamic_cast<CLRW *>(inst))
+        return PLAIN;
+
+    return OTHER;
+}
+
+unsigned int StraightLine::run(Processor *cpu, uint64_t max)
+{
+    if (cpu != m_cpu)
+    {
+        if (m_cpu)
+            m_cpu->remove_program_memory_listener(this);
+
+        attach(cpu);
+    }
+
+    // Indexed addressing makes the access bank depend on FSR2.
+    if (m_cpu16 && m_cpu16->extended_instruction())
+        return 0;
+
+    unsigned int n = 0;
+
+    while (n < max)
+    {
+        unsigned int index = cpu->pc->value;
+
+        if (index >= m_kinds.size())
+            break;
+
+        instruction *inst = cpu->program_memory[index];
+
+        if (m_kinds[index] == UNKNOWN)
+            m_kinds[index] = classify(inst);
+
+        // Resolve the register as the instruction will.
+        switch (m_kinds[index])
+        {
+        case PLAIN:
+            break;
+
+        case REGISTER_OP:
+        {
+            Register_op *op = static_cast<Register_op *>(inst);
+            Register *reg = op->access ? cpu->register_bank[op->register_address]
+                                       : cpu->registers[op->register_address];
+            if (!is_plain(reg))
+                return n;
+            break;
+        }
+
+        case BIT_OP:
+        {
+            Bit_op *op = static_cast<Bit_op *>(inst);
+            Register *reg = op->access ? cpu->register_bank[op->register_address]
+                                       : cpu->registers[op->register_address];
+            if (!is_plain(reg))
+                return n;
+            break;
+        }
+
+        default:
+            return n;
+        }
+
+        inst->execute();
+        ++n;
+    }
+
+    return n;
+}
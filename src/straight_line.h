@@ -0,0 +1,85 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+
+#ifndef SRC_STRAIGHT_LINE_H_
+#define SRC_STRAIGHT_LINE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "processor.h"
+
+class _16bit_processor;
+
+/*
+  StraightLine
+
+  Runs straight-line code for the execute phase without touching the
+  cycle counter, which then skips all the cycles at once, see
+  phaseExecute1Cycle::advance().
+
+  An instruction qualifies if it completes in one cycle, does not
+  change the next phase and only uses W, literals, the status flags
+  and plain general purpose registers. Special function registers are
+  read and written by peripherals that look at the cycle counter or
+  reschedule cycle breaks, so the first instruction addressing one
+  ends the run, as do skips, branches, TRIS, indirect access and
+  PIC18 indexed literal addressing. The run stops before it, to be
+  stepped normally.
+
+  The instruction classes are cached per program memory index, and
+  forgotten when the index is written.
+*/
+class StraightLine : public ProgramMemoryListener
+{
+public:
+    StraightLine() = default;
+    ~StraightLine() override;
+
+    StraightLine(const StraightLine &) = delete;
+    StraightLine &operator=(const StraightLine &) = delete;
+
+    // Executes at most max qualifying instructions from the PC.
+    // Returns how many ran.
+    unsigned int run(Processor *cpu, uint64_t max);
+
+    void program_memory_changed(Processor *cpu, const Ranges &ranges) override;
+
+private:
+    enum Kind : uint8_t
+    {
+        UNKNOWN,
+        OTHER,        // Ends the run.
+        PLAIN,        // Qualifies.
+        REGISTER_OP,  // Qualifies if its register is plain.
+        BIT_OP,       // Qualifies if its register is plain.
+    };
+
+    void attach(Processor *cpu);
+    static Kind classify(instruction *inst);
+
+private:
+    Processor *m_cpu = nullptr;            // Listened to.
+    _16bit_processor *m_cpu16 = nullptr;   // Set for the 16-bit cores.
+    std::vector<Kind> m_kinds;
+};
+
+#endif  // SRC_STRAIGHT_LINE_H_
@@ -62,15 +62,15 @@ int SymbolTable_t::addSymbol(gpsimObject *pSym, std::string *ps_AliasedName)
     if (pSym)
     {
         ps_AliasedName = (ps_AliasedName && !ps_AliasedName->empty()) ? ps_AliasedName : &pSym->name();
-        auto sti = table.find(*ps_AliasedName);
-        if (sti == table.end())
+        auto ii = index.find(*ps_AliasedName);
+        if (ii == index.end())
         {
-            table[*ps_AliasedName] = pSym;
+            insert(*ps_AliasedName, pSym);
             return 1;
         }
-        else if (pSym != sti->second)
+        else if (pSym != ii->second->second)
         {
-            std::cout << "SymbolTable_t::addSymbol " << *ps_AliasedName << " exists " << pSym << ' ' << sti->second << '\n';
+            std::cout << "SymbolTable_t::addSymbol " << *ps_AliasedName << " exists " << pSym << ' ' << ii->second->second << '\n';
             return 0;
         }
     }
@@ -93,7 +93,7 @@ int SymbolTable_t::removeSymbol(gpsimObject *pSym)
                 if (pSym)
                     std::cout << pSym->name() << '\n';
             }
-            table.erase(it);
+            erase(it);
             return 1;
         }
     }
@@ -102,13 +102,13 @@ int SymbolTable_t::removeSymbol(gpsimObject *pSym)
 
 int SymbolTable_t::removeSymbol(const std::string &s)
 {
-    auto sti = table.find(s);
-    if (sti != table.end())
+    auto ii = index.find(s);
+    if (ii != index.end())
     {
         if (DEBUG)
             std::cout << __FILE__ ":"  STR(__LINE__) " Removing symbol " << s << '\n';
 
-        table.erase(sti);
+        erase(ii->second);
         return 1;
     }
 
@@ -117,14 +117,14 @@ int SymbolTable_t::removeSymbol(const std::string &s)
 
 int SymbolTable_t::deleteSymbol(const std::string &s)
 {
-    auto sti = table.find(s);
-    if (sti != table.end())
+    auto ii = index.find(s);
+    if (ii != index.end())
     {
         if (DEBUG)
             std::cout << __FILE__ ":" STR(__LINE__) "  Deleting symbol " << s << '\n';
 
-        delete sti->second;
-        table.erase(sti);
+        delete ii->second->second;
+        erase(ii->second);
         return 1;
     }
 
@@ -134,10 +134,63 @@ int SymbolTable_t::deleteSymbol(const std::string &s)
 
 gpsimObject *SymbolTable_t::findSymbol(const std::string &searchString)
 {
-    stiFound = table.find(searchString);
+    auto ii = index.find(searchString);
+    stiFound = ii != index.end() ? ii->second : table.end();
     return stiFound != table.end() ? stiFound->second : nullptr;
 }
 
+std::vector<std::pair<std::string_view, gpsimObject *>>
+SymbolTable_t::findPrefix(std::string_view prefix, std::size_t max_count) const
+{
+    std::vector<std::pair<std::string_view, gpsimObject *>> found;
+
+    for (auto it = table.lower_bound(std::string(prefix)); it != table.end(); ++it)
+    {
+        if (it->first.compare(0, prefix.size(), prefix) != 0)
+            break;
+
+        if (max_count && found.size() >= max_count)
+            break;
+
+        found.emplace_back(it->first, it->second);
+    }
+
+    return found;
+}
+
+std::size_t SymbolTable_t::memory_bytes() const
+{
+    // Tree nodes have three links and a color, hash nodes a link and
+    // the cached hash.
+    const std::size_t tree_node = sizeof(Table_t::value_type) + 4 * sizeof(void *);
+    const std::size_t hash_node = sizeof(decltype(index)::value_type) + 2 * sizeof(void *);
+    const std::size_t inline_capacity = std::string().capacity();
+    std::size_t bytes = table.size() * (tree_node + hash_node)
+                        + index.bucket_count() * sizeof(void *);
+
+    for (const auto &sym : table)
+    {
+        if (sym.first.capacity() > inline_capacity)
+            bytes += sym.first.capacity() + 1;
+    }
+
+    return bytes;
+}
+
+void SymbolTable_t::insert(const std::string &name, gpsimObject *pSym)
+{
+    auto it = table.emplace(name, pSym).first;
+    index.emplace(it->first, it);
+    ++m_generation;
+}
+
+void SymbolTable_t::erase(Table_t::iterator it)
+{
+    index.erase(it->first);
+    table.erase(it);
+    ++m_generation;
+}
+
 //-------------------------------------------------------------------
 //-------------------------------------------------------------------
 
@@ -188,6 +241,7 @@ void SymbolTable::addModule(Module *pModule)
   if (pModule) {
     MSymbolTables[pModule->name()] = &pModule->getSymbolTable();
     globalSymbols().addSymbol(pModule);
+    ++m_generation;
   }
 }
 
@@ -199,6 +253,7 @@ void SymbolTable::removeModule(Module *pModule)
     if (mi != MSymbolTables.end())
       MSymbolTables.erase(mi);
     globalSymbols().removeSymbol(pModule);
+    ++m_generation;
   }
 }
 
@@ -249,9 +304,11 @@ gpsimObject *SymbolTable::find(const std::string &s)
                 scopeOperatorPosition++;
             }
         }
-        auto sti = searchTable->table.find(s.substr(scopeOperatorPosition));
-        if (sti != searchTable->table.end())
-            return sti->second;
+        if (gpsimObject *pScoped = searchTable->findSymbol(s.substr(scopeOperatorPosition)))
+            return pScoped;
+
+        // Global symbols may have periods in their names, e.g.
+        // "sim.verbosity", so fall back to searching for all of it.
     }
 
     gpsimObject *pFound = nullptr;  // assume the symbol is not found.
@@ -276,7 +333,7 @@ int SymbolTable::removeSymbol(const std::string &s)
     {
         if (searchTable->stiFound != searchTable->table.end())
         {
-            searchTable->table.erase(searchTable->stiFound);
+            searchTable->erase(searchTable->stiFound);
             return 1;
         }
     }
@@ -291,7 +348,7 @@ int SymbolTable::deleteSymbol(const std::string &s)
     {
         if (searchTable->stiFound != searchTable->table.end())
         {
-            searchTable->table.erase(searchTable->stiFound);
+            searchTable->erase(searchTable->stiFound);
             delete pObj;
             return 1;
         }
@@ -68,9 +68,15 @@ License along with this library; if not, see
 #define SRC_SYMBOL_H_
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <map>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "exports.h"
 
@@ -95,12 +101,22 @@ typedef std::pair<std::string, gpsimObject *> SymbolEntry_t;
 // A gpsim symbol table is an STL map of gpsimObject pointers that are keyed with
 // by the object's name.
 //
+// The map keeps the names sorted for iteration and prefix searches. A
+// hash index of views into the map keys makes lookups by name
+// constant time. The generation changes whenever a symbol is added or
+// removed, so clients caching the symbols know when to refresh.
+//
 
 class SymbolTable_t
 {
   // The SymbolTable class has access to all map<>'s methods.
   friend class SymbolTable;
 public:
+  SymbolTable_t() = default;
+
+  // The index refers into the table.
+  SymbolTable_t(const SymbolTable_t &) = delete;
+  SymbolTable_t &operator =(const SymbolTable_t &) = delete;
 
   int addSymbol(gpsimObject *, std::string *AliasedName = nullptr);
   int removeSymbol(gpsimObject *);
@@ -108,6 +124,19 @@ public:
   int deleteSymbol(const std::string &);
   gpsimObject *findSymbol(const std::string &);
 
+  /// findPrefix -- the symbols whose names start with prefix, in name
+  /// order. At most max_count symbols are returned, if non-zero. The
+  /// names are valid until the symbols are removed.
+  std::vector<std::pair<std::string_view, gpsimObject *>>
+  findPrefix(std::string_view prefix, std::size_t max_count = 0) const;
+
+  std::size_t size() const { return table.size(); }
+
+  /// memory_bytes -- an estimate of the heap bytes of the table and
+  /// its index, not counting the symbols themselves.
+  std::size_t memory_bytes() const;
+  uint64_t generation() const { return m_generation; }
+
   /// ForEachModuleSymbolTable -- thin wrapper around map<>'s for_each() algorithm.
   /// The pointer to the function passed must be declared like:
   /// void MyForEach(const SymbolEntry_t &sym) { /* do something with sym */ }
@@ -125,11 +154,19 @@ public:
   }
 
 protected:
+  typedef std::map<std::string, gpsimObject *> Table_t;
+
   // stiFound an iterator that points to the most recently found symbol.
-  std::map<std::string, gpsimObject *>::iterator stiFound;
+  Table_t::iterator stiFound;
+
+private:
+  void insert(const std::string &name, gpsimObject *pSym);
+  void erase(Table_t::iterator it);
 
 private:
-  std::map<std::string, gpsimObject *> table;
+  Table_t table;
+  std::unordered_map<std::string_view, Table_t::iterator> index;
+  uint64_t m_generation = 0;
 };
 
 
@@ -156,6 +193,9 @@ public:
   void removeModule(Module *);
   SymbolTable_t *findSymbolTable(const std::string &module_name);
 
+  /// generation -- changes whenever a module is added or removed.
+  uint64_t generation() const { return m_generation; }
+
   /// find - search for a particular symbol
   gpsimObject *find(const std::string &);
   gpsimObject *findObject(gpsimObject *);
@@ -177,6 +217,7 @@ public:
 
 protected:
   MSymbolTable_t MSymbolTables;
+  uint64_t m_generation = 0;
 };
 
 
@@ -20,8 +20,11 @@ License along with this library; if not, see
 
 #include "trace.h"
 
+#include <algorithm>
 #include <cassert>
 
+#include "util/metrics.h"
+
 
 namespace trace {
 
@@ -38,20 +41,26 @@ namespace trace {
         .size = static_cast<EntrySizeType>(data_.size() - back_),
         .type = EmptyEntry::type(),
       };
+      metas_.back().end_size = metas_[back_].size;
       back_ = 0;
     }
 
-    while (data_.size() - size() < n) {
+    // Keep a slot free, since a full buffer would look empty.
+    while (data_.size() - size() <= n) {
       pop();
       ++discarded_;
+      util::metrics::count(util::metrics::TRACE_DISCARDED);
     }
 
+    util::metrics::count(util::metrics::TRACE_ENTRIES);
+
     void *p = &data_[back_];
 
     metas_[back_] = {
       .size = static_cast<EntrySizeType>(n),
       .type = type,
     };
+    metas_[back_ + n - 1].end_size = static_cast<EntrySizeType>(n);
     back_ = clamp(back_ + n);
 
     return p;
@@ -64,6 +73,67 @@ namespace trace {
     if (empty()) discarded_ = 0;
   }
 
+  namespace internal {
+
+    SinkSet::Subscription::Subscription(TraceSink *s, const SinkFilter &f)
+      : sink(s), filter(f),
+        // One slot per entry, and one kept free.
+        batch(std::max<std::size_t>(f.batch_size, 1) + 1)
+    {
+    }
+
+    void SinkSet::Subscription::flush()
+    {
+      if (batch.empty()) return;
+
+      TraceReader reader(&batch);
+
+      sink->consume(reader);
+      batch.clear();
+    }
+
+    bool SinkSet::add(TraceSink *sink, const SinkFilter &filter)
+    {
+      for (const Subscription &sub : subs_) {
+        if (sub.sink == sink) return false;
+      }
+
+      subs_.emplace_back(sink, filter);
+      types_ |= filter.types;
+      return true;
+    }
+
+    void SinkSet::remove(TraceSink *sink)
+    {
+      auto it = std::find_if(subs_.begin(), subs_.end(), [sink](const Subscription &sub) {
+        return sub.sink == sink;
+      });
+
+      if (it == subs_.end()) return;
+
+      it->flush();
+      subs_.erase(it);
+
+      types_ = 0;
+      for (const Subscription &sub : subs_) types_ |= sub.filter.types;
+    }
+
+    void SinkSet::flush()
+    {
+      for (Subscription &sub : subs_) sub.flush();
+    }
+
+    std::size_t SinkSet::memory_bytes() const
+    {
+      std::size_t bytes = subs_.capacity() * sizeof(Subscription);
+
+      for (const Subscription &sub : subs_) bytes += sub.batch.memory_bytes();
+
+      return bytes;
+    }
+
+  }  // namespace internal
+
   namespace {
 
     TraceBuffer& global_buffer()
@@ -72,11 +142,25 @@ namespace trace {
       return global_buffer;
     }
 
+    TraceBuffer *global_history = nullptr;
+
+    // At namespace scope, unlike global_buffer(), since global_writer()
+    // passes it to every writer and a function-local static costs a
+    // guard check per entry. Before its initializer has run, it is
+    // zero-initialized, which is an empty set.
+    internal::SinkSet global_sinks;
+
+    uint32_t global_types = ALL_TYPES;
+
+    thread_local TraceBuffer *thread_buffer = nullptr;
+
   }
 
   TraceWriter global_writer()
   {
-    return TraceWriter(&global_buffer());
+    if (thread_buffer) return TraceWriter(thread_buffer, nullptr);
+
+    return TraceWriter(&global_buffer(), global_history, &global_sinks, global_types);
   }
 
   TraceReader global_reader()
@@ -84,4 +168,65 @@ namespace trace {
     return TraceReader(&global_buffer());
   }
 
+  bool set_global_history(TraceBuffer *history)
+  {
+    if (global_history && global_history != history) return false;
+
+    global_history = history;
+    return true;
+  }
+
+  void clear_global_history(TraceBuffer *history)
+  {
+    if (global_history == history) global_history = nullptr;
+  }
+
+  TraceBuffer *set_thread_buffer(TraceBuffer *buffer)
+  {
+    TraceBuffer *old = thread_buffer;
+
+    thread_buffer = buffer;
+    return old;
+  }
+
+  bool add_sink(TraceSink *sink, const SinkFilter &filter)
+  {
+    return global_sinks.add(sink, filter);
+  }
+
+  void remove_sink(TraceSink *sink)
+  {
+    global_sinks.remove(sink);
+  }
+
+  void flush_sinks()
+  {
+    global_sinks.flush();
+  }
+
+  uint32_t set_global_types(uint32_t types)
+  {
+    uint32_t old = global_types;
+
+    global_types = types;
+    return old;
+  }
+
+  util::memory::Usage memory_usage()
+  {
+    util::memory::Usage u;
+
+    u.objects = 1;
+    u.bytes = global_buffer().memory_bytes();
+
+    if (global_history) {
+      ++u.objects;
+      u.bytes += global_history->memory_bytes();
+    }
+
+    u.bytes += global_sinks.memory_bytes();
+
+    return u;
+  }
+
 }  // namespace trace
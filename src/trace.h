@@ -22,10 +22,12 @@ License along with this library; if not, see
 #define SRC_TRACE_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <type_traits>
 #include <vector>
 
 #include "gpsim_classes.h"
+#include "util/memory.h"
 
 namespace trace {
 
@@ -92,6 +94,7 @@ class TraceBuffer
   struct EntryMeta {
     EntrySizeType size;
     EntryType type;
+    EntrySizeType end_size;  // In the last slot of an entry, its size.
   };
 
   typedef std::vector<std::max_align_t> DataVector;
@@ -131,6 +134,19 @@ public:
       return *this;
     }
 
+    // Moves to the previous entry. Must not be called on begin().
+    const_iterator& operator --()
+    {
+      if (data_ == buffer_->data_.cbegin()) {
+        data_ = buffer_->data_.cend();
+        meta_ = buffer_->metas_.cend();
+      }
+      auto n = (meta_ - 1)->end_size;
+      data_ -= n;
+      meta_ -= n;
+      return *this;
+    }
+
     const_reference operator *() const
     {
       return EntryConstRef(reinterpret_cast<const internal::EntryBase*>(&*data_), meta_->type);
@@ -170,6 +186,12 @@ public:
 
   size_type discarded() const { return discarded_; }
 
+  // The heap bytes of the entries, which are allocated up front.
+  std::size_t memory_bytes() const
+  {
+    return data_.capacity() * sizeof(DataVector::value_type) + metas_.capacity() * sizeof(EntryMeta);
+  }
+
   EntryConstRef front() const { return EntryConstRef(reinterpret_cast<const internal::EntryBase*>(&data_[front_]), metas_[front_].type); }
 
   const_iterator cbegin() const { return const_iterator(data_.cbegin() + front_, metas_.cbegin() + front_, this); }
@@ -194,6 +216,18 @@ public:
 
   void pop();
 
+  // Removes all entries.
+  void clear()
+  {
+    front_ = back_ = discarded_ = 0;
+  }
+
+  // Removes the entries from it to the back.
+  void truncate(const const_iterator &it)
+  {
+    back_ = it.data_ - data_.cbegin();
+  }
+
 private:
   void* push(size_type n, EntryType type);
 
@@ -322,27 +356,121 @@ private:
   RESET_TYPE cause_;
 };
 
+// Bit t of a type mask selects the entries of EntryType t.
+constexpr uint32_t type_mask(EntryType type) { return uint32_t(1) << type; }
+
+const uint32_t ALL_TYPES = type_mask(NUM_ENTRY_TYPES) - 1;
+
+class TraceReader;
+
+/**
+ * A consumer of trace entries, see add_sink().
+ */
+class TraceSink
+{
+public:
+  virtual ~TraceSink() = default;
+
+  // Receives a batch of entries, in the order they were written. The
+  // batch is emptied when this returns.
+  virtual void consume(TraceReader &batch) = 0;
+};
+
+// The entries a sink subscribes to. Register and PC entries are only
+// passed on if their address is in [min_address, max_address]. Other
+// entries have no address.
+struct SinkFilter
+{
+  uint32_t types = ALL_TYPES;
+  uint32_t min_address = 0;
+  uint32_t max_address = UINT32_MAX;
+
+  // Entries collected before the sink is called.
+  std::size_t batch_size = 1024;
+
+  template<typename T>
+  bool accepts(const T &entry) const
+  {
+    if constexpr (std::is_base_of_v<RegisterEntryBase, T> || std::is_base_of_v<PCEntryBase, T>)
+      return entry.address() >= min_address && entry.address() <= max_address;
+    else
+      return true;
+  }
+};
+
+namespace internal {
+
+// The subscribed sinks, each with its own batch.
+class SinkSet
+{
+public:
+  // The union of the type masks of the sinks.
+  uint32_t types() const { return types_; }
+
+  template<typename T, typename... Args>
+  void emplace(Args&&... args)
+  {
+    const T entry(std::forward<Args>(args)...);
+
+    for (Subscription &sub : subs_) {
+      if ((sub.filter.types & type_mask(T::type())) && sub.filter.accepts(entry)) {
+        sub.batch.emplace<T>(entry);
+        if (sub.batch.size() >= sub.filter.batch_size) sub.flush();
+      }
+    }
+  }
+
+  bool add(TraceSink *sink, const SinkFilter &filter);
+  void remove(TraceSink *sink);
+  void flush();
+  std::size_t memory_bytes() const;
+
+private:
+  struct Subscription
+  {
+    Subscription(TraceSink *s, const SinkFilter &f);
+
+    void flush();
+
+    TraceSink *sink;
+    SinkFilter filter;
+    TraceBuffer batch;
+  };
+
+  std::vector<Subscription> subs_;
+  uint32_t types_ = 0;
+};
+
+}  // namespace internal
+
 /**
  * A proxy for TraceBuffer that only allows writing entries.
  */
 class TraceWriter
 {
 public:
-  explicit TraceWriter(TraceBuffer *buffer)
-    : buffer_(buffer) {}
+  explicit TraceWriter(TraceBuffer *buffer, TraceBuffer *history = nullptr,
+                       internal::SinkSet *sinks = nullptr, uint32_t types = ALL_TYPES)
+    : buffer_(buffer), history_(history), sinks_(sinks), types_(types) {}
 
   // Pushes a new entry, constructing it in-place.
   //
   // If the buffer is full, entries are pop()ed until there is enough
-  // room. discarded() is incremented when this happens.
+  // room. discarded() is incremented when this happens. The entry is
+  // only constructed for the buffer and the sinks that want its type.
   template<typename T, typename... Args>
   void emplace(Args&&... args)
   {
-    buffer_->emplace<T>(std::forward<Args>(args)...);
+    if (history_) history_->emplace<T>(args...);
+    if (sinks_ && (sinks_->types() & type_mask(T::type()))) sinks_->emplace<T>(args...);
+    if (types_ & type_mask(T::type())) buffer_->emplace<T>(std::forward<Args>(args)...);
   }
 
 private:
   TraceBuffer *buffer_;
+  TraceBuffer *history_;
+  internal::SinkSet *sinks_;
+  uint32_t types_;
 };
 
 /**
@@ -393,6 +521,42 @@ TraceWriter global_writer();
 // Returns a read handle to the global trace buffer.
 TraceReader global_reader();
 
+// Sets a buffer that receives a copy of every entry written to the
+// global trace buffer. Unlike the global buffer, it is not consumed by
+// readers, so it holds the most recent history, e.g. for reverse
+// stepping. Returns false if another history buffer is set.
+bool set_global_history(TraceBuffer *history);
+void clear_global_history(TraceBuffer *history);
+
+// Redirects global_writer() on this thread to the buffer, without
+// history or sinks, or back to the global buffer if nullptr. Returns
+// the previous buffer.
+TraceBuffer *set_thread_buffer(TraceBuffer *buffer);
+
+// Subscribes the sink to the entries written by global_writer(),
+// whether the global buffer keeps them or not. Filtering happens when
+// entries are written, and the sink is called with batches of them.
+// Returns false if the sink is already subscribed. Sinks must be added
+// and removed while the simulation is stopped, and not from consume().
+bool add_sink(TraceSink *sink, const SinkFilter &filter = SinkFilter());
+
+// Passes on the pending entries, and unsubscribes the sink.
+void remove_sink(TraceSink *sink);
+
+// Passes on the pending entries of all sinks. It is called when the
+// simulation stops.
+void flush_sinks();
+
+// Selects the entry types the global buffer keeps, e.g. if all
+// consumers are sinks. Entries of types neither the buffer nor a sink
+// wants are not written at all, except to the history. Returns the
+// previous mask.
+uint32_t set_global_types(uint32_t types);
+
+// The global trace buffer, the history buffer, if set, and the
+// batches of the sinks.
+util::memory::Usage memory_usage();
+
 }  // namespace trace
 
 #endif
@@ -0,0 +1,742 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "trace_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include "gpsim_time.h"
+
+
+namespace trace {
+
+  namespace {
+
+    const char HEADER_MAGIC[8] = {'G', 'P', 'S', 'I', 'M', 'T', 'R', 'C'};
+    const char TRAILER_MAGIC[8] = {'G', 'P', 'S', 'I', 'M', 'I', 'D', 'X'};
+    const uint32_t VERSION = 1;
+    const std::size_t HEADER_SIZE = 16;
+    const std::size_t TRAILER_SIZE = 24;
+
+    // Chunks are started at the first cycle stamp after this many
+    // bytes, and an index block is written every INDEX_INTERVAL chunks.
+    const uint64_t CHUNK_SIZE = 64 * 1024;
+    const std::size_t INDEX_INTERVAL = 64;
+    const std::size_t BUFFER_SIZE = 64 * 1024;
+
+    // Tag type for records that are not trace entries, with the kind
+    // in the argument nibble.
+    const uint8_t FILE_RECORD = 0x0F;
+    enum FileRecord : uint8_t {
+      CHUNK,  // varint cycle
+      INDEX,  // varint previous index, varint n, n * (varint cycle, varint offset)
+      LOST,   // varint number of discarded entries
+    };
+
+    static_assert(NUM_ENTRY_TYPES <= FILE_RECORD, "Entry types must fit in the tag nibble");
+
+    // Address arguments for PC entries.
+    const uint8_t PC_EXPECTED = 0;  // The previous address plus one.
+    const uint8_t PC_SAME = 1;      // The previous address.
+    const uint8_t PC_DELTA = 2;     // Followed by a varint delta.
+
+    // IncrementPCEntry arguments below this are runs of arg + 1
+    // entries at expected addresses.
+    const uint8_t INCREMENT_DELTA = 15;
+    const unsigned MAX_RUN = INCREMENT_DELTA;
+
+    // Register entry argument bits.
+    const uint8_t REG_MASK = 1;     // A mask byte follows the value.
+    const uint8_t REG_SAME = 2;     // Same address, no delta.
+
+    // Matches TraceFileReader::State, so the first expected address
+    // is zero.
+    const uint16_t INITIAL_PC = 0xFFFF;
+
+    uint8_t tag(EntryType type, uint8_t arg) { return type | arg << 4; }
+
+    uint64_t zigzag16(uint16_t delta)
+    {
+      int32_t s = static_cast<int16_t>(delta);
+      return static_cast<uint16_t>((s << 1) ^ (s >> 31));
+    }
+
+    uint16_t unzigzag16(uint64_t v)
+    {
+      return static_cast<uint16_t>((v >> 1) ^ -(v & 1));
+    }
+
+    uint64_t zigzag64(uint64_t delta)
+    {
+      int64_t s = static_cast<int64_t>(delta);
+      return (static_cast<uint64_t>(s) << 1) ^ static_cast<uint64_t>(s >> 63);
+    }
+
+    uint64_t unzigzag64(uint64_t v)
+    {
+      return (v >> 1) ^ -(v & 1);
+    }
+
+    uint64_t load_u64(const uint8_t *p)
+    {
+      uint64_t v = 0;
+      for (int i = 7; i >= 0; --i) v = v << 8 | p[i];
+      return v;
+    }
+
+    uint32_t load_u32(const uint8_t *p)
+    {
+      return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+    }
+
+  }  // namespace
+
+  //------------------------------------------------------------------------
+  // TraceRecorder
+
+  TraceRecorder::~TraceRecorder()
+  {
+    close();
+  }
+
+  int TraceRecorder::open(const std::string &path, uint64_t stamp_interval)
+  {
+    if (file_) return EBUSY;
+    if (!stamp_interval) return EINVAL;
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return errno;
+
+    error_ = 0;
+    interval_ = stamp_interval;
+    out_.clear();
+    out_.reserve(BUFFER_SIZE + 1024);
+    file_offset_ = 0;
+    entries_ = 0;
+    run_ = 0;
+    index_offset_ = 0;
+    pending_.clear();
+
+    out_.insert(out_.end(), HEADER_MAGIC, HEADER_MAGIC + sizeof(HEADER_MAGIC));
+    for (int i = 0; i < 4; ++i) put(VERSION >> (8 * i));
+    for (int i = 0; i < 4; ++i) put(0);
+
+    TraceReader reader = global_reader();
+    while (!reader.empty()) reader.pop();
+
+    uint64_t now = get_cycles().get();
+    start_chunk(now);
+    get_cycles().set_break(now + interval_, this);
+
+    return 0;
+  }
+
+  int TraceRecorder::close()
+  {
+    if (!file_) return 0;
+
+    uint64_t now = get_cycles().get();
+
+    get_cycles().clear_break(this);
+    global_writer().emplace<CycleCounterEntry>(now);
+    flush();
+    end_run();
+    write_index();
+
+    put_u64(index_offset_);
+    put_u64(now);
+    out_.insert(out_.end(), TRAILER_MAGIC, TRAILER_MAGIC + sizeof(TRAILER_MAGIC));
+    write_out();
+
+    if (std::fclose(file_) && !error_) error_ = errno;
+    file_ = nullptr;
+
+    return error_;
+  }
+
+  void TraceRecorder::flush()
+  {
+    if (!file_) return;
+
+    TraceReader reader = global_reader();
+
+    if (reader.discarded()) {
+      end_run();
+      put(tag(FILE_RECORD, LOST));
+      put_varint(reader.discarded());
+    }
+
+    while (!reader.empty()) {
+      encode(reader.front());
+      reader.pop();
+    }
+
+    if (out_.size() >= BUFFER_SIZE) write_out();
+  }
+
+  void TraceRecorder::callback()
+  {
+    uint64_t now = get_cycles().get();
+
+    global_writer().emplace<CycleCounterEntry>(now);
+    flush();
+    get_cycles().set_break(now + interval_, this);
+  }
+
+  void TraceRecorder::callback_print()
+  {
+    std::cout << "Trace recorder CallBack ID " << CallBackID << '\n';
+  }
+
+  void TraceRecorder::encode(const EntryConstRef &ref)
+  {
+    EntryType type = ref.type();
+
+    switch (type) {
+    case BASE:
+      // Filler at the end of the ring buffer.
+      return;
+
+    case CYCLE_COUNTER:
+      encode_cycle(ref.as<CycleCounterEntry>().cycle());
+      break;
+
+    case READ_REGISTER:
+      encode_register(type, ref.as<ReadRegisterEntry>());
+      break;
+
+    case WRITE_REGISTER:
+      encode_register(type, ref.as<WriteRegisterEntry>());
+      break;
+
+    case SET_PC: {
+      const SetPCEntry &e = ref.as<SetPCEntry>();
+      encode_pc(type, e.address());
+      put_varint(zigzag16(e.target() - e.address()));
+      // The next PC entry is for the target.
+      pc_ = e.target() - 1;
+      break;
+    }
+
+    case INCREMENT_PC:
+      encode_pc(type, ref.as<IncrementPCEntry>().address());
+      break;
+
+    case SKIP_PC:
+      encode_pc(type, ref.as<SkipPCEntry>().address());
+      break;
+
+    case BRANCH_PC:
+      encode_pc(type, ref.as<BranchPCEntry>().address());
+      break;
+
+    case INTERRUPT:
+      end_run();
+      put(tag(type, 0));
+      break;
+
+    case RESET:
+      end_run();
+      put(tag(type, 0));
+      put_varint(ref.as<ResetEntry>().cause());
+      break;
+
+    default:
+      // Decoded as an UnknownEntry.
+      end_run();
+      put(tag(BASE, 0));
+      put_varint(type);
+      break;
+    }
+
+    ++entries_;
+  }
+
+  void TraceRecorder::encode_pc(EntryType type, uint16_t addr)
+  {
+    uint16_t expected = pc_ + 1;
+
+    if (type == INCREMENT_PC && addr == expected) {
+      if (run_ == MAX_RUN) end_run();
+      ++run_;
+      pc_ = addr;
+      return;
+    }
+
+    end_run();
+
+    if (type == INCREMENT_PC) {
+      put(tag(type, INCREMENT_DELTA));
+      put_varint(zigzag16(addr - expected));
+    } else if (addr == expected) {
+      put(tag(type, PC_EXPECTED));
+    } else if (addr == pc_) {
+      put(tag(type, PC_SAME));
+    } else {
+      put(tag(type, PC_DELTA));
+      put_varint(zigzag16(addr - expected));
+    }
+
+    pc_ = addr;
+  }
+
+  void TraceRecorder::encode_register(EntryType type, const RegisterEntryBase &e)
+  {
+    uint8_t arg = 0;
+
+    end_run();
+
+    if (e.mask() != 0xFF) arg |= REG_MASK;
+    if (e.address() == reg_) arg |= REG_SAME;
+
+    put(tag(type, arg));
+    if (!(arg & REG_SAME)) put_varint(zigzag16(e.address() - reg_));
+    put(e.value());
+    if (arg & REG_MASK) put(e.mask());
+
+    reg_ = e.address();
+  }
+
+  void TraceRecorder::encode_cycle(uint64_t cycle)
+  {
+    end_run();
+
+    if (bytes() - chunk_offset_ >= CHUNK_SIZE) {
+      start_chunk(cycle);
+      return;
+    }
+
+    put(tag(CYCLE_COUNTER, 0));
+    put_varint(zigzag64(cycle - cycle_));
+    cycle_ = cycle;
+  }
+
+  void TraceRecorder::end_run()
+  {
+    if (!run_) return;
+
+    put(tag(INCREMENT_PC, run_ - 1));
+    run_ = 0;
+  }
+
+  // Starts a chunk with an absolute cycle stamp, which also counts
+  // as the CycleCounterEntry for the cycle.
+  void TraceRecorder::start_chunk(uint64_t cycle)
+  {
+    if (pending_.size() >= INDEX_INTERVAL) write_index();
+
+    chunk_offset_ = bytes();
+    pending_.push_back({cycle, chunk_offset_});
+
+    put(tag(FILE_RECORD, CHUNK));
+    put_varint(cycle);
+
+    cycle_ = cycle;
+    pc_ = INITIAL_PC;
+    reg_ = 0;
+  }
+
+  void TraceRecorder::write_index()
+  {
+    uint64_t offset = bytes();
+
+    put(tag(FILE_RECORD, INDEX));
+    put_varint(index_offset_);
+    put_varint(pending_.size());
+    for (const auto &chunk : pending_) {
+      put_varint(chunk.cycle);
+      put_varint(chunk.offset);
+    }
+
+    index_offset_ = offset;
+    pending_.clear();
+  }
+
+  void TraceRecorder::put_varint(uint64_t v)
+  {
+    while (v >= 0x80) {
+      out_.push_back(static_cast<uint8_t>(v) | 0x80);
+      v >>= 7;
+    }
+    out_.push_back(static_cast<uint8_t>(v));
+  }
+
+  void TraceRecorder::put_u64(uint64_t v)
+  {
+    for (int i = 0; i < 8; ++i) put(v >> (8 * i));
+  }
+
+  void TraceRecorder::write_out()
+  {
+    if (out_.empty()) return;
+
+    if (std::fwrite(out_.data(), 1, out_.size(), file_) != out_.size() && !error_)
+      error_ = errno ? errno : EIO;
+
+    file_offset_ += out_.size();
+    out_.clear();
+  }
+
+  //------------------------------------------------------------------------
+  // TraceFileReader
+
+  TraceFileReader::~TraceFileReader()
+  {
+    close();
+  }
+
+  int TraceFileReader::open(const std::string &path)
+  {
+    uint8_t header[HEADER_SIZE];
+
+    close();
+
+    file_ = std::fopen(path.c_str(), "rb");
+    if (!file_) return errno;
+
+    if (std::fseek(file_, 0, SEEK_END)) {
+      int err = errno;
+      close();
+      return err;
+    }
+    data_end_ = std::ftell(file_);
+
+    if (!read_at(0, header, sizeof(header)) ||
+        std::memcmp(header, HEADER_MAGIC, sizeof(HEADER_MAGIC)) ||
+        load_u32(header + 8) != VERSION) {
+      close();
+      return EINVAL;
+    }
+
+    buf_.resize(BUFFER_SIZE);
+
+    int err = load_index();
+    if (err) err = scan();
+    if (err) {
+      close();
+      return err;
+    }
+
+    return seek(0);
+  }
+
+  void TraceFileReader::close()
+  {
+    if (file_) std::fclose(file_);
+
+    file_ = nullptr;
+    data_end_ = 0;
+    end_cycle_ = 0;
+    indexed_ = false;
+    lost_ = 0;
+    buf_offset_ = 0;
+    buf_pos_ = 0;
+    buf_len_ = 0;
+    state_ = State();
+    chunks_.clear();
+  }
+
+  int TraceFileReader::load_index()
+  {
+    uint8_t trailer[TRAILER_SIZE];
+
+    if (data_end_ < HEADER_SIZE + TRAILER_SIZE ||
+        !read_at(data_end_ - TRAILER_SIZE, trailer, sizeof(trailer)) ||
+        std::memcmp(trailer + 16, TRAILER_MAGIC, sizeof(TRAILER_MAGIC)))
+      return ENOENT;
+
+    uint64_t end = data_end_ - TRAILER_SIZE;
+    uint64_t index = load_u64(trailer);
+
+    data_end_ = end;
+
+    while (index) {
+      uint64_t prev, n;
+
+      if (index < HEADER_SIZE || index >= end || reposition(index) ||
+          get() != tag(FILE_RECORD, INDEX) ||
+          !get_varint(&prev) || !get_varint(&n) || prev >= index) {
+        chunks_.clear();
+        data_end_ = end + TRAILER_SIZE;
+        return EINVAL;
+      }
+
+      for (uint64_t i = 0; i < n; ++i) {
+        Chunk chunk;
+        if (!get_varint(&chunk.cycle) || !get_varint(&chunk.offset)) {
+          chunks_.clear();
+          data_end_ = end + TRAILER_SIZE;
+          return EINVAL;
+        }
+        chunks_.push_back(chunk);
+      }
+
+      index = prev;
+    }
+
+    std::sort(chunks_.begin(), chunks_.end(),
+              [](const Chunk &a, const Chunk &b) { return a.offset < b.offset; });
+
+    end_cycle_ = load_u64(trailer + 8);
+    indexed_ = true;
+
+    return 0;
+  }
+
+  // Finds the chunks of a file that has no valid trailer.
+  int TraceFileReader::scan()
+  {
+    EntryRegistry::variant entry{UnknownEntry(BASE)};
+
+    int err = reposition(HEADER_SIZE);
+    if (err) return err;
+
+    state_ = State();
+    scanning_ = true;
+    while (next(&entry)) {}
+    scanning_ = false;
+
+    end_cycle_ = state_.cycle;
+    lost_ = 0;
+
+    return 0;
+  }
+
+  int TraceFileReader::seek(uint64_t cycle)
+  {
+    if (!file_) return EBADF;
+
+    // The last chunk starting at or before the cycle.
+    auto it = std::upper_bound(chunks_.begin(), chunks_.end(), cycle,
+                               [](uint64_t c, const Chunk &chunk) { return c < chunk.cycle; });
+    uint64_t start = it == chunks_.begin() ? HEADER_SIZE : std::prev(it)->offset;
+
+    int err = reposition(start);
+    if (err) return err;
+
+    state_ = State();
+
+    // Decode up to the last stamp at or before the cycle. The state
+    // is only saved before stamps, where there is no pending run.
+    uint64_t best_offset = start;
+    State best_state = state_;
+    EntryRegistry::variant entry{UnknownEntry(BASE)};
+
+    for (;;) {
+      uint64_t mark = offset();
+      State mark_state = state_;
+
+      if (!next(&entry)) break;
+
+      if (const auto *e = std::get_if<CycleCounterEntry>(&entry)) {
+        if (e->cycle() > cycle) break;
+        best_offset = mark;
+        best_state = mark_state;
+      }
+    }
+
+    err = reposition(best_offset);
+    state_ = best_state;
+
+    return err;
+  }
+
+  bool TraceFileReader::next(EntryRegistry::variant *entry)
+  {
+    for (;;) {
+      if (state_.run) {
+        --state_.run;
+        ++state_.pc;
+        *entry = IncrementPCEntry(state_.pc);
+        return true;
+      }
+
+      uint64_t start = offset();
+      int t = get();
+      if (t < 0) return false;
+
+      EntryType type = t & 0x0F;
+      uint8_t arg = t >> 4;
+      uint16_t expected = state_.pc + 1;
+      uint64_t v = 0;
+
+      switch (type) {
+      case BASE:
+        if (!get_varint(&v)) return false;
+        *entry = UnknownEntry(static_cast<EntryType>(v));
+        return true;
+
+      case CYCLE_COUNTER:
+        if (!get_varint(&v)) return false;
+        state_.cycle += unzigzag64(v);
+        *entry = CycleCounterEntry(state_.cycle);
+        return true;
+
+      case READ_REGISTER:
+      case WRITE_REGISTER: {
+        if (!(arg & REG_SAME)) {
+          if (!get_varint(&v)) return false;
+          state_.reg += unzigzag16(v);
+        }
+
+        int value = get();
+        int mask = arg & REG_MASK ? get() : 0xFF;
+        if (value < 0 || mask < 0) return false;
+
+        if (type == READ_REGISTER)
+          *entry = ReadRegisterEntry(state_.reg, value, mask);
+        else
+          *entry = WriteRegisterEntry(state_.reg, value, mask);
+        return true;
+      }
+
+      case INCREMENT_PC:
+        if (arg != INCREMENT_DELTA) {
+          state_.run = arg + 1;
+          continue;
+        }
+
+        if (!get_varint(&v)) return false;
+        state_.pc = expected + unzigzag16(v);
+        *entry = IncrementPCEntry(state_.pc);
+        return true;
+
+      case SET_PC:
+      case SKIP_PC:
+      case BRANCH_PC: {
+        if (arg == PC_EXPECTED) {
+          state_.pc = expected;
+        } else if (arg == PC_DELTA) {
+          if (!get_varint(&v)) return false;
+          state_.pc = expected + unzigzag16(v);
+        } else if (arg != PC_SAME) {
+          return false;
+        }
+
+        if (type == SET_PC) {
+          if (!get_varint(&v)) return false;
+          uint16_t addr = state_.pc;
+          uint16_t target = addr + unzigzag16(v);
+          state_.pc = target - 1;
+          *entry = SetPCEntry(addr, target);
+        } else if (type == SKIP_PC) {
+          *entry = SkipPCEntry(state_.pc);
+        } else {
+          *entry = BranchPCEntry(state_.pc);
+        }
+        return true;
+      }
+
+      case INTERRUPT:
+        *entry = InterruptEntry();
+        return true;
+
+      case RESET:
+        if (!get_varint(&v)) return false;
+        *entry = ResetEntry(static_cast<RESET_TYPE>(v));
+        return true;
+
+      case FILE_RECORD:
+        switch (arg) {
+        case CHUNK:
+          if (!get_varint(&v)) return false;
+          state_ = State();
+          state_.cycle = v;
+          if (scanning_) chunks_.push_back({v, start});
+          *entry = CycleCounterEntry(v);
+          return true;
+
+        case INDEX: {
+          uint64_t n;
+          if (!get_varint(&v) || !get_varint(&n)) return false;
+          for (uint64_t i = 0; i < 2 * n; ++i)
+            if (!get_varint(&v)) return false;
+          continue;
+        }
+
+        case LOST:
+          if (!get_varint(&v)) return false;
+          lost_ += v;
+          continue;
+
+        default:
+          return false;
+        }
+
+      default:
+        return false;
+      }
+    }
+  }
+
+  int TraceFileReader::reposition(uint64_t offset)
+  {
+    buf_offset_ = offset;
+    buf_pos_ = 0;
+    buf_len_ = 0;
+
+    if (std::fseek(file_, offset, SEEK_SET)) return errno;
+
+    return 0;
+  }
+
+  int TraceFileReader::get()
+  {
+    if (buf_pos_ == buf_len_) {
+      buf_offset_ += buf_len_;
+      buf_pos_ = 0;
+      buf_len_ = 0;
+
+      if (buf_offset_ >= data_end_) return -1;
+
+      std::size_t n = std::min<uint64_t>(buf_.size(), data_end_ - buf_offset_);
+      buf_len_ = std::fread(buf_.data(), 1, n, file_);
+      if (!buf_len_) return -1;
+    }
+
+    return buf_[buf_pos_++];
+  }
+
+  bool TraceFileReader::get_varint(uint64_t *v)
+  {
+    *v = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+      int b = get();
+      if (b < 0) return false;
+
+      *v |= static_cast<uint64_t>(b & 0x7F) << shift;
+      if (!(b & 0x80)) return true;
+    }
+
+    return false;
+  }
+
+  bool TraceFileReader::read_at(uint64_t offset, void *p, std::size_t n)
+  {
+    if (std::fseek(file_, offset, SEEK_SET)) return false;
+
+    return std::fread(p, 1, n, file_) == n;
+  }
+
+}  // namespace trace
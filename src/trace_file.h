@@ -0,0 +1,222 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_TRACE_FILE_H_
+#define SRC_TRACE_FILE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+#include "trace_registry.h"
+#include "trigger.h"
+
+namespace trace {
+
+/*
+  Trace files
+
+  A trace file stores the entries of the global trace buffer in a
+  compact, streamable encoding:
+
+    header   "GPSIMTRC", uint32 version, uint32 reserved
+    records  ...
+    trailer  uint64 last index offset, uint64 end cycle, "GPSIMIDX"
+
+  Integers in the header and trailer are little endian. Every record
+  starts with a tag byte, holding an entry type in the low nibble and
+  an argument in the high nibble. Program counter and register
+  addresses are zigzag coded varint deltas from the previous one, and
+  runs of up to 15 IncrementPCEntries at consecutive addresses take a
+  single byte. Cycle counter entries are varint deltas from the
+  previous stamp.
+
+  The record stream is split into chunks, each starting with an
+  absolute cycle stamp and a fresh delta state, so decoding can start
+  at any chunk. Index blocks list the chunks with their first cycle,
+  and are chained backwards from the trailer, so seeking by cycle is
+  a binary search followed by decoding at most one chunk. A file
+  without a trailer, e.g. after a crash, is read by scanning for the
+  chunk records instead.
+*/
+
+// Records the global trace buffer to a file.
+//
+// The recorder drains the buffer every stamp interval cycles, using a
+// cycle counter break, and whenever flush() is called. Draining pops
+// the entries, so other readers of the global buffer will not see
+// them. Only one recorder should be open at a time.
+class TraceRecorder : public TriggerObject
+{
+public:
+  static const uint64_t DEFAULT_STAMP_INTERVAL = 4096;
+
+  TraceRecorder() = default;
+  ~TraceRecorder() override;
+
+  TraceRecorder(const TraceRecorder &) = delete;
+  TraceRecorder& operator =(const TraceRecorder &) = delete;
+
+  // Creates the file and starts recording. Entries already in the
+  // global buffer are dropped. Returns zero, or an errno value.
+  //
+  // The stamp interval must be small enough that the global buffer
+  // does not overflow between drains.
+  int open(const std::string &path, uint64_t stamp_interval = DEFAULT_STAMP_INTERVAL);
+
+  // Stops recording, and writes the last index block and the
+  // trailer. Returns zero, or the first errno value seen while
+  // writing.
+  int close();
+
+  // Encodes all entries in the global buffer.
+  void flush();
+
+  bool is_open() const { return file_ != nullptr; }
+
+  // The number of entries and bytes written so far.
+  uint64_t entries() const { return entries_; }
+  uint64_t bytes() const { return file_offset_ + out_.size(); }
+
+  void callback() override;
+  void callback_print() override;
+
+private:
+  struct Chunk {
+    uint64_t cycle;
+    uint64_t offset;
+  };
+
+  void encode(const EntryConstRef &ref);
+  void encode_pc(EntryType type, uint16_t addr);
+  void encode_register(EntryType type, const RegisterEntryBase &e);
+  void encode_cycle(uint64_t cycle);
+  void end_run();
+  void start_chunk(uint64_t cycle);
+  void write_index();
+
+  void put(uint8_t b) { out_.push_back(b); }
+  void put_varint(uint64_t v);
+  void put_u64(uint64_t v);
+  void write_out();
+
+private:
+  FILE *file_ = nullptr;
+  int error_ = 0;
+  uint64_t interval_ = DEFAULT_STAMP_INTERVAL;
+
+  std::vector<uint8_t> out_;
+  uint64_t file_offset_ = 0;  // Bytes written before out_.
+  uint64_t entries_ = 0;
+
+  // Delta state, reset at each chunk.
+  uint64_t cycle_ = 0;
+  uint16_t pc_ = 0;
+  uint16_t reg_ = 0;
+  unsigned run_ = 0;          // Pending IncrementPCEntries.
+
+  uint64_t chunk_offset_ = 0;
+  uint64_t index_offset_ = 0;  // The last index block written.
+  std::vector<Chunk> pending_;  // Chunks since the last index block.
+};
+
+// Reads a file written by TraceRecorder.
+class TraceFileReader
+{
+public:
+  TraceFileReader() = default;
+  ~TraceFileReader();
+
+  TraceFileReader(const TraceFileReader &) = delete;
+  TraceFileReader& operator =(const TraceFileReader &) = delete;
+
+  // Opens the file and loads the chunk index. Returns zero, or an
+  // errno value.
+  int open(const std::string &path);
+  void close();
+
+  // Positions the reader at the last cycle stamp at or before the
+  // cycle, so the next entry is a CycleCounterEntry. Cycles before
+  // the first stamp position the reader at the start. Returns zero,
+  // or an errno value.
+  int seek(uint64_t cycle);
+
+  // Decodes the next entry. Returns false at the end of the file.
+  bool next(EntryRegistry::variant *entry);
+
+  // The cycle of the last stamp decoded.
+  uint64_t cycle() const { return state_.cycle; }
+
+  // The range of cycles covered by the file.
+  uint64_t first_cycle() const { return chunks_.empty() ? 0 : chunks_.front().cycle; }
+  uint64_t last_cycle() const { return end_cycle_; }
+
+  // The number of chunks, and whether they were found using the
+  // index rather than by scanning.
+  std::size_t num_chunks() const { return chunks_.size(); }
+  bool indexed() const { return indexed_; }
+
+  // The number of entries the recorder lost to buffer overflows, in
+  // the part of the file decoded so far.
+  uint64_t lost() const { return lost_; }
+
+private:
+  struct Chunk {
+    uint64_t cycle;
+    uint64_t offset;
+  };
+
+  struct State {
+    uint64_t cycle = 0;
+    uint16_t pc = 0xFFFF;
+    uint16_t reg = 0;
+    unsigned run = 0;
+  };
+
+  int load_index();
+  int scan();
+  int reposition(uint64_t offset);
+  uint64_t offset() const { return buf_offset_ + buf_pos_; }
+  int get();
+  bool get_varint(uint64_t *v);
+  bool read_at(uint64_t offset, void *p, std::size_t n);
+
+private:
+  FILE *file_ = nullptr;
+  uint64_t data_end_ = 0;
+  uint64_t end_cycle_ = 0;
+  bool indexed_ = false;
+  bool scanning_ = false;
+  uint64_t lost_ = 0;
+
+  std::vector<uint8_t> buf_;
+  uint64_t buf_offset_ = 0;  // File offset of buf_[0].
+  std::size_t buf_pos_ = 0;
+  std::size_t buf_len_ = 0;
+
+  State state_;
+  std::vector<Chunk> chunks_;  // Sorted by offset.
+};
+
+}  // namespace trace
+
+#endif
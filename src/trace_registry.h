@@ -21,6 +21,8 @@ License along with this library; if not, see
 #ifndef SRC_TRACE_REGISTRY_H_
 #define SRC_TRACE_REGISTRY_H_
 
+#include <array>
+#include <type_traits>
 #include <variant>
 
 #include "trace.h"
@@ -58,15 +60,14 @@ struct EntryRegistry {
 private:
   template<typename Entry>
   static variant parse_entry(const EntryConstRef &ref) {
-    static_assert(std::is_base_of_v<EntryBase, Entry>, "Can only parse subclasses of Entry");
-    return variant(std::in_place_type<Entry>, ref.as<const Entry>());
-  }
-
-  // An overload to allow specifying UnknownEntry in the registry, to
-  // fill gaps in the type enum.
-  template<>
-  static variant parse_entry<UnknownEntry>(const EntryConstRef &ref) {
-    return variant(std::in_place_type<UnknownEntry>, ref.type());
+    // UnknownEntry may be specified in the registry, to fill gaps in
+    // the type enum.
+    if constexpr (std::is_same_v<Entry, UnknownEntry>) {
+      return variant(std::in_place_type<UnknownEntry>, ref.type());
+    } else {
+      static_assert(std::is_base_of_v<EntryBase, Entry>, "Can only parse subclasses of Entry");
+      return variant(std::in_place_type<Entry>, ref.as<const Entry>());
+    }
   }
 
   typedef variant(*parser_type)(const EntryConstRef&);
@@ -0,0 +1,518 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "translate.h"
+
+#include <algorithm>
+#include <typeinfo>
+
+#include "14bit-registers.h"
+#include "16bit-processors.h"
+#include "16bit-registers.h"
+#include "pic-instructions.h"
+#include "registers.h"
+#include "trace.h"
+
+namespace {
+
+enum OpCode : uint8_t
+{
+    OP_NOP,
+
+    // Literal operations.
+    OP_MOVLW,
+    OP_ADDLW,
+    OP_SUBLW,
+    OP_ANDLW,
+    OP_IORLW,
+    OP_XORLW,
+    OP_MULLW,
+
+    // Byte-oriented file register operations.
+    OP_ADDWF,
+    OP_SUBWF,
+    OP_ANDWF,
+    OP_IORWF,
+    OP_XORWF,
+    OP_COMF,
+    OP_INCF,
+    OP_DECF,
+    OP_MOVF,
+    OP_RLNCF,
+    OP_RRNCF,
+    OP_SWAPF,
+    OP_MOVWF,
+    OP_CLRF,
+    OP_SETF,
+    OP_NEGF,
+    OP_MULWF,
+
+    // Bit-oriented file register operations.
+    OP_BCF,
+    OP_BSF,
+    OP_BTG,
+};
+
+struct Decoding
+{
+    unsigned int mask;
+    unsigned int match;
+    OpCode code;
+};
+
+// PIC18 encodings, as in 16bit-hexdecode.cc.
+const Decoding decodings[] = {
+    { 0xffff, 0x0000, OP_NOP },
+    { 0xff00, 0x0e00, OP_MOVLW },
+    { 0xff00, 0x0f00, OP_ADDLW },
+    { 0xff00, 0x0800, OP_SUBLW },
+    { 0xff00, 0x0b00, OP_ANDLW },
+    { 0xff00, 0x0900, OP_IORLW },
+    { 0xff00, 0x0a00, OP_XORLW },
+    { 0xff00, 0x0d00, OP_MULLW },
+    { 0xfc00, 0x2400, OP_ADDWF },
+    { 0xfc00, 0x5c00, OP_SUBWF },
+    { 0xfc00, 0x1400, OP_ANDWF },
+    { 0xfc00, 0x1000, OP_IORWF },
+    { 0xfc00, 0x1800, OP_XORWF },
+    { 0xfc00, 0x1c00, OP_COMF },
+    { 0xfc00, 0x2800, OP_INCF },
+    { 0xfc00, 0x0400, OP_DECF },
+    { 0xfc00, 0x5000, OP_MOVF },
+    { 0xfc00, 0x4400, OP_RLNCF },
+    { 0xfc00, 0x4000, OP_RRNCF },
+    { 0xfc00, 0x3800, OP_SWAPF },
+    { 0xfe00, 0x6e00, OP_MOVWF },
+    { 0xfe00, 0x6a00, OP_CLRF },
+    { 0xfe00, 0x6800, OP_SETF },
+    { 0xfe00, 0x6c00, OP_NEGF },
+    { 0xfe00, 0x0200, OP_MULWF },
+    { 0xf000, 0x9000, OP_BCF },
+    { 0xf000, 0x8000, OP_BSF },
+    { 0xf000, 0x7000, OP_BTG },
+};
+
+const uint8_t NO_BLOCK = 0xff;
+
+}  // namespace
+
+//========================================================================
+
+BlockTranslator::BlockTranslator(_16bit_processor *cpu)
+    : m_cpu(cpu)
+{
+    invalidate_all();
+    m_cpu->add_program_memory_listener(this);
+}
+
+BlockTranslator::~BlockTranslator()
+{
+    m_cpu->remove_program_memory_listener(this);
+}
+
+void BlockTranslator::invalidate_all()
+{
+    unsigned int size = m_cpu->program_memory_size();
+
+    m_blocks.clear();
+    m_blocks.resize(size);
+    m_hits.assign(size, 0);
+    m_nBlocks = 0;
+}
+
+// Invalidates [first, last), and blocks starting before first that
+// may extend into it.
+void BlockTranslator::invalidate(unsigned int first, unsigned int last)
+{
+    last = std::min<std::size_t>(last, m_blocks.size());
+    first = first >= MAX_BLOCK_SIZE ? first - MAX_BLOCK_SIZE + 1 : 0;
+
+    for (unsigned int i = first; i < last; ++i)
+    {
+        if (m_blocks[i])
+        {
+            m_blocks[i].reset();
+            --m_nBlocks;
+        }
+
+        m_hits[i] = 0;
+    }
+}
+
+void BlockTranslator::program_memory_changed(Processor *, const Ranges &ranges)
+{
+    for (const auto &range : ranges)
+        invalidate(range.first, range.second);
+}
+
+unsigned int BlockTranslator::run(uint64_t max_cycles)
+{
+    unsigned int index = m_cpu->pc->value;
+
+    if (index >= m_blocks.size())
+        return 0;
+
+    Block *block = m_blocks[index].get();
+
+    if (!block)
+    {
+        if (m_hits[index] == NO_BLOCK || ++m_hits[index] < HOT_COUNT)
+            return 0;
+
+        block = translate(index);
+
+        if (!block)
+        {
+            m_hits[index] = NO_BLOCK;
+            return 0;
+        }
+    }
+
+    unsigned int n = block->ops.size();
+
+    if (n > max_cycles)
+        return 0;
+
+    // Indexed addressing makes the access bank dynamic, and a pending
+    // PCLATH update must happen in Program_Counter16::increment().
+    if (m_cpu->extended_instruction() ||
+            static_cast<Program_Counter16 *>(m_cpu->pc)->update_latch)
+        return 0;
+
+    // Registers may have been replaced, and the old ones deleted,
+    // since the translation, so compare pointers by the address
+    // recorded then.
+    for (const Op &op : block->ops)
+    {
+        if (op.reg && m_cpu->registers[op.addr] != op.reg)
+        {
+            invalidate(index, index + 1);
+            return 0;
+        }
+    }
+
+    execute(index, *block);
+
+    return n;
+}
+
+//------------------------------------------------------------------------
+// translate
+//
+// Translates the instructions from index up to the first one that is
+// not supported. Blocks of a single instruction are not worth it.
+
+BlockTranslator::Block *BlockTranslator::translate(unsigned int index)
+{
+    auto block = std::make_unique<Block>();
+
+    // The last word wraps the PC, leave it to the interpreter.
+    unsigned int end = m_blocks.size() - 1;
+
+    for (unsigned int i = index; i < end && block->ops.size() < MAX_BLOCK_SIZE; ++i)
+    {
+        Op op;
+
+        if (!decode(i, op))
+            break;
+
+        block->ops.push_back(op);
+    }
+
+    if (block->ops.size() < 2)
+        return nullptr;
+
+    ++m_nBlocks;
+    m_blocks[index] = std::move(block);
+
+    return m_blocks[index].get();
+}
+
+bool BlockTranslator::decode(unsigned int index, Op &op)
+{
+    instruction *inst = m_cpu->program_memory[index];
+
+    if (!inst || inst->isa() != instruction::NORMAL_INSTRUCTION)
+        return false;
+
+    unsigned int opcode = inst->get_opcode();
+    const Decoding *d = nullptr;
+
+    for (const Decoding &dec : decodings)
+    {
+        if ((opcode & dec.mask) == dec.match)
+        {
+            d = &dec;
+            break;
+        }
+    }
+
+    if (!d)
+        return false;
+
+    op.code = d->code;
+    op.k = opcode & 0xff;
+    op.dest = opcode & 0x200;
+    op.addr = 0;
+    op.reg = nullptr;
+
+    if (op.code <= OP_MULLW)
+        return true;
+
+    // File register operands must be general purpose registers in the
+    // access bank, so they do not depend on BSR and have no side
+    // effects.
+    if (opcode & 0x100)
+        return false;
+
+    unsigned int addr = opcode & 0xff;
+
+    if (addr >= m_cpu->access_gprs())
+        return false;
+
+    Register *reg = m_cpu->registers[addr];
+
+    if (!reg || typeid(*reg) != typeid(Register))
+        return false;
+
+    op.addr = addr;
+    op.reg = reg;
+
+    if (op.code >= OP_BCF)
+        op.k = 1 << ((opcode >> 9) & 7);
+
+    return true;
+}
+
+//------------------------------------------------------------------------
+// execute
+//
+// Mirrors the execute() functions in 16bit-instructions.cc, including
+// the trace entries they write, except that the program counter is
+// only updated once.
+
+void BlockTranslator::execute(unsigned int index, const Block &block)
+{
+    _16bit_processor *cpu = m_cpu;
+    Status_register *status = cpu->status;
+    trace::TraceWriter writer = trace::global_writer();
+
+    for (const Op &op : block.ops)
+    {
+        Register *reg = op.reg;
+        unsigned int src, w, result;
+
+        switch (op.code)
+        {
+        case OP_NOP:
+            break;
+
+        case OP_MOVLW:
+            cpu->Wput(op.k);
+            break;
+
+        case OP_ADDLW:
+            result = (w = cpu->Wget()) + op.k;
+            cpu->Wput(result & 0xff);
+            status->put_Z_C_DC_OV_N(result, w, op.k);
+            break;
+
+        case OP_SUBLW:
+            result = op.k - (w = cpu->Wget());
+            cpu->Wput(result & 0xff);
+            status->put_Z_C_DC_OV_N_for_sub(result, op.k, w);
+            break;
+
+        case OP_ANDLW:
+            result = cpu->Wget() & op.k;
+            cpu->Wput(result);
+            status->put_N_Z(result);
+            break;
+
+        case OP_IORLW:
+            result = cpu->Wget() | op.k;
+            cpu->Wput(result);
+            status->put_N_Z(result);
+            break;
+
+        case OP_XORLW:
+            result = cpu->Wget() ^ op.k;
+            cpu->Wput(result);
+            status->put_N_Z(result);
+            break;
+
+        case OP_MULLW:
+            result = (0xff & cpu->Wget()) * op.k;
+            cpu->prodl.put(result & 0xff);
+            cpu->prodh.put((result >> 8) & 0xff);
+            break;
+
+        case OP_ADDWF:
+            result = (src = reg->get()) + (w = cpu->Wget());
+            if (op.dest)
+            {
+                reg->put(result & 0xff);
+                status->put_Z_C_DC_OV_N(result, src, w);
+            }
+            else
+            {
+                cpu->Wput(result & 0xff);
+                status->put_Z_C_DC_OV_N(result, w, src);
+            }
+            break;
+
+        case OP_SUBWF:
+            result = (src = reg->get()) - (w = cpu->Wget());
+            if (op.dest)
+                reg->put(result & 0xff);
+            else
+                cpu->Wput(result & 0xff);
+            status->put_Z_C_DC_OV_N_for_sub(result, src, w);
+            break;
+
+        case OP_ANDWF:
+        case OP_IORWF:
+        case OP_XORWF:
+            src = reg->get();
+            w = cpu->Wget();
+            result = op.code == OP_ANDWF ? src & w : op.code == OP_IORWF ? src | w : src ^ w;
+            if (op.dest)
+                reg->put(result);
+            else
+                cpu->Wput(result);
+            status->put_N_Z(result);
+            break;
+
+        case OP_COMF:
+            result = reg->get() ^ 0xff;
+            if (op.dest)
+                reg->put(result);
+            else
+                cpu->Wput(result);
+            status->put_N_Z(result);
+            break;
+
+        case OP_INCF:
+            result = (src = reg->get()) + 1;
+            if (op.dest)
+            {
+                reg->put(result & 0xff);
+                status->put_Z_C_DC_OV_N(result, src, 1);
+            }
+            else
+            {
+                cpu->Wput(result & 0xff);
+                status->put_Z_C_DC_OV_N(result, 1, src);
+            }
+            break;
+
+        case OP_DECF:
+            result = (src = reg->get()) - 1;
+            if (op.dest)
+                reg->put(result & 0xff);
+            else
+                cpu->Wput(result & 0xff);
+            status->put_Z_C_DC_OV_N_for_sub(result, src, 1);
+            break;
+
+        case OP_MOVF:
+            result = reg->get();
+            if (op.dest)
+                reg->put(result);
+            else
+                cpu->Wput(result);
+            status->put_N_Z(result);
+            break;
+
+        case OP_RLNCF:
+            src = reg->get();
+            result = (src << 1) | ((src & 0x80) ? 1 : 0);
+            if (op.dest)
+                reg->put(result & 0xff);
+            else
+                cpu->Wput(result & 0xff);
+            status->put_N_Z(result);
+            break;
+
+        case OP_RRNCF:
+            src = reg->get() & 0xff;
+            result = (src >> 1) | ((src & 1) ? 0x80 : 0);
+            if (op.dest)
+                reg->put(result & 0xff);
+            else
+                cpu->Wput(result & 0xff);
+            status->put_N_Z(result | ((src & 1) ? 0x100 : 0));
+            break;
+
+        case OP_SWAPF:
+            src = reg->get();
+            result = ((src >> 4) & 0x0f) | ((src << 4) & 0xf0);
+            if (op.dest)
+                reg->put(result);
+            else
+                cpu->Wput(result);
+            break;
+
+        case OP_MOVWF:
+            reg->put(cpu->Wget());
+            break;
+
+        case OP_CLRF:
+            reg->put(0);
+            status->put_Z(1);
+            break;
+
+        case OP_SETF:
+            reg->put(0xff);
+            break;
+
+        case OP_NEGF:
+            src = reg->get();
+            result = 1 + ~src;
+            reg->put(result & 0xff);
+            status->put_Z_C_DC_OV_N_for_sub(result, 0, src);
+            break;
+
+        case OP_MULWF:
+            result = (0xff & cpu->Wget()) * (0xff & reg->get());
+            cpu->prodl.put(result & 0xff);
+            cpu->prodh.put((result >> 8) & 0xff);
+            break;
+
+        case OP_BCF:
+            reg->put(reg->get_value() & ~op.k);
+            break;
+
+        case OP_BSF:
+            reg->put(reg->get_value() | op.k);
+            break;
+
+        case OP_BTG:
+            reg->put(reg->get() ^ op.k);
+            break;
+        }
+
+        // Program_Counter::increment() traces the word index.
+        writer.emplace<trace::IncrementPCEntry>(index++);
+    }
+
+    cpu->pc->value = index;
+    cpu->pc->update_pcl();
+}
@@ -0,0 +1,108 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_TRANSLATE_H_
+#define SRC_TRANSLATE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "processor.h"
+
+class Register;
+class _16bit_processor;
+
+/*
+  BlockTranslator
+
+  An optional execution engine for hot straight-line code. Program
+  memory indices are profiled as the execute phase reaches them, and
+  once an index has been reached HOT_COUNT times, the instructions
+  from there up to the first branch, skip or access to anything but
+  W, STATUS, PROD and plain general purpose registers are translated
+  into a block of pre-decoded operations. Executing a block replaces
+  the per-instruction virtual dispatch, register address resolution
+  and program counter updates, while producing the same register
+  values, status flags and trace entries as the interpreter.
+
+  Blocks only run when the execute phase may consume that many cycles
+  at once, see phaseExecute1Cycle::advance(). Writes to program memory
+  invalidate the blocks covering the written indices.
+
+  Only the 16-bit core is supported, where access bank addressing
+  makes register operands static. The other cores fall back to the
+  interpreter.
+*/
+class BlockTranslator : public ProgramMemoryListener
+{
+public:
+    explicit BlockTranslator(_16bit_processor *cpu);
+    ~BlockTranslator() override;
+
+    BlockTranslator(const BlockTranslator &) = delete;
+    BlockTranslator &operator =(const BlockTranslator &) = delete;
+
+    // Executes the block starting at the current PC, if there is one
+    // and it is at most max_cycles long. Returns the number of
+    // instructions executed, or zero if the caller should interpret
+    // the instruction at the PC.
+    unsigned int run(uint64_t max_cycles);
+
+    // Drops translations covering the program memory indices.
+    void invalidate(unsigned int first, unsigned int last);
+    void invalidate_all();
+
+    void program_memory_changed(Processor *cpu, const Ranges &ranges) override;
+
+    // The number of translated blocks.
+    std::size_t size() const { return m_nBlocks; }
+
+    static const unsigned int HOT_COUNT = 16;
+    static const unsigned int MAX_BLOCK_SIZE = 64;
+
+private:
+    struct Op
+    {
+        uint8_t code;
+        uint8_t k;           // Literal, or bit mask.
+        bool dest;           // Result goes to the file register.
+        unsigned int addr;   // Register address, valid if reg is set.
+        Register *reg;       // Only dereferenced after checking addr.
+    };
+
+    struct Block
+    {
+        std::vector<Op> ops;
+    };
+
+    Block *translate(unsigned int index);
+    bool decode(unsigned int index, Op &op);
+    void execute(unsigned int index, const Block &block);
+
+private:
+    _16bit_processor *m_cpu;
+
+    std::vector<std::unique_ptr<Block>> m_blocks;  // By start index.
+    std::vector<uint8_t> m_hits;                   // By start index.
+    std::size_t m_nBlocks = 0;
+};
+
+#endif  // SRC_TRANSLATE_H_
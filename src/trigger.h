@@ -24,6 +24,8 @@ License along with this library; if not, see
 
 #include <string>
 
+#include "util/metrics.h"
+
 class TriggerObject;
 
 //========================================================================
@@ -88,6 +90,13 @@ class TriggerObject
   // A unique number assigned when the break point is armed.
   int CallBackID;
 
+  // Where Cycle_Counter counts the breaks of this object.
+  util::metrics::BreakSlot break_metrics;
+
+  // Set by objects whose cycle breaks do not change the simulated
+  // state, so Cycle_Counter::last_break_change() ignores them.
+  bool stateless_breaks = false;
+
   // When the breakpoint associated with this object is encountered,
   // then 'callback' is invoked.
   virtual void callback();
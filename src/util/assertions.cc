@@ -0,0 +1,604 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "assertions.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+
+#include "../gpsim_time.h"
+#include "../processor.h"
+#include "../registers.h"
+#include "../symbol.h"
+#include "../value.h"
+
+
+namespace util {
+
+namespace {
+
+// Bytecode instructions. Each instruction is a 32-bit word with the
+// opcode in the low byte and an unsigned operand in the upper 24
+// bits. OP_CONST_WIDE is followed by two words holding the low and
+// high halves of the constant.
+enum Op : uint8_t {
+  OP_END,
+  OP_CONST,
+  OP_CONST_WIDE,
+  OP_REG,         // Operand is an index into m_registers.
+  OP_INT,         // Operand is an index into m_integers.
+  OP_CYCLES,
+  OP_DEREF,
+
+  OP_NEG,
+  OP_NOT,
+  OP_LNOT,
+
+  OP_MUL,
+  OP_DIV,
+  OP_MOD,
+  OP_ADD,
+  OP_SUB,
+  OP_SHL,
+  OP_SHR,
+  OP_LT,
+  OP_LE,
+  OP_GT,
+  OP_GE,
+  OP_EQ,
+  OP_NE,
+  OP_AND,
+  OP_XOR,
+  OP_OR,
+  OP_LAND,
+  OP_LOR,
+};
+
+constexpr uint32_t MAX_OPERAND = 0xFFFFFF;
+constexpr int MAX_STACK_DEPTH = 32;
+
+struct BinaryOp {
+  std::string_view token;
+  int precedence;
+  Op op;
+};
+
+// Ordered so that two-character tokens are matched first.
+constexpr BinaryOp BINARY_OPS[] = {
+  {"||", 1, OP_LOR},
+  {"&&", 2, OP_LAND},
+  {"==", 6, OP_EQ},
+  {"!=", 6, OP_NE},
+  {"<=", 7, OP_LE},
+  {">=", 7, OP_GE},
+  {"<<", 8, OP_SHL},
+  {">>", 8, OP_SHR},
+  {"|", 3, OP_OR},
+  {"^", 4, OP_XOR},
+  {"&", 5, OP_AND},
+  {"<", 7, OP_LT},
+  {">", 7, OP_GT},
+  {"+", 9, OP_ADD},
+  {"-", 9, OP_SUB},
+  {"*", 10, OP_MUL},
+  {"/", 10, OP_DIV},
+  {"%", 10, OP_MOD},
+};
+
+}  // namespace
+
+//-----------------------------------------------------------
+// A recursive descent compiler for a single assertion.
+class Assertions::Compiler {
+public:
+  Compiler(Assertions &asserts, std::string_view text)
+    : m_asserts(asserts), m_text(text) {}
+
+  // Appends the bytecode to m_asserts.m_code. Returns an errno
+  // and a description in *err on failure.
+  int compile(std::string *message, std::string *err)
+  {
+    std::size_t start = m_asserts.m_code.size();
+    int ret = compile_assertion(message);
+
+    if (ret) {
+      m_asserts.m_code.resize(start);
+      *err = m_err;
+    }
+
+    return ret;
+  }
+
+private:
+  int compile_assertion(std::string *message)
+  {
+    skip_space();
+
+    if (at_end() || peek() == '\'') {
+      // No expression: the assertion always fails.
+      emit(OP_CONST, 0);
+    } else {
+      if (int err = compile_binary(1); err)
+        return err;
+
+      skip_space();
+      if (!at_end() && peek() == ',') {
+        ++m_pos;
+        skip_space();
+      }
+    }
+
+    if (!at_end() && peek() == '\'') {
+      std::size_t end = m_text.find('\'', m_pos + 1);
+
+      if (end == std::string_view::npos)
+        return error("unterminated message");
+
+      *message = std::string(m_text.substr(m_pos + 1, end - m_pos - 1));
+      m_pos = end + 1;
+      skip_space();
+    }
+
+    if (!at_end())
+      return error("unexpected character");
+
+    emit(OP_END);
+
+    return 0;
+  }
+
+  int compile_binary(int min_precedence)
+  {
+    if (int err = compile_unary(); err)
+      return err;
+
+    while (true) {
+      skip_space();
+
+      const BinaryOp *bop = nullptr;
+      for (const auto &cand : BINARY_OPS) {
+        if (m_text.substr(m_pos, cand.token.size()) == cand.token) {
+          bop = &cand;
+          break;
+        }
+      }
+
+      if (!bop || bop->precedence < min_precedence)
+        return 0;
+
+      m_pos += bop->token.size();
+
+      if (int err = compile_binary(bop->precedence + 1); err)
+        return err;
+
+      emit(bop->op);
+      --m_depth;
+    }
+  }
+
+  int compile_unary()
+  {
+    skip_space();
+
+    if (at_end())
+      return error("expected operand");
+
+    Op op;
+    switch (peek()) {
+    case '-': op = OP_NEG; break;
+    case '~': op = OP_NOT; break;
+    case '*': op = OP_DEREF; break;
+    case '!':
+      if (m_text.substr(m_pos, 2) == "!=")
+        return error("expected operand");
+      op = OP_LNOT;
+      break;
+    case '+':
+      ++m_pos;
+      return compile_unary();
+    default:
+      return compile_primary();
+    }
+
+    ++m_pos;
+    if (int err = compile_unary(); err)
+      return err;
+
+    emit(op);
+
+    return 0;
+  }
+
+  int compile_primary()
+  {
+    char c = peek();
+
+    if (c == '(') {
+      ++m_pos;
+      if (int err = compile_binary(1); err)
+        return err;
+
+      skip_space();
+      if (at_end() || peek() != ')')
+        return error("expected ')'");
+      ++m_pos;
+
+      return 0;
+    }
+
+    if (std::isdigit(static_cast<unsigned char>(c)))
+      return compile_number();
+
+    if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+      return compile_identifier();
+
+    return error("unexpected character");
+  }
+
+  int compile_number()
+  {
+    std::string s(m_text.substr(m_pos));
+    const char *begin = s.c_str();
+    char *end;
+    int64_t v;
+
+    if (s.size() > 2 && s[0] == '0' && (s[1] == 'b' || s[1] == 'B'))
+      v = std::strtoll(begin + 2, &end, 2);
+    else
+      v = std::strtoll(begin, &end, 0);
+
+    m_pos += end - begin;
+    emit_const(v);
+
+    return 0;
+  }
+
+  int compile_identifier()
+  {
+    std::size_t start = m_pos;
+    while (!at_end() && (std::isalnum(static_cast<unsigned char>(peek())) || peek() == '_' || peek() == '.'))
+      ++m_pos;
+
+    std::string name(m_text.substr(start, m_pos - start));
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+
+    if (lower == "cycles") {
+      emit(OP_CYCLES);
+      return 0;
+    }
+
+    ::Processor *cpu = m_asserts.m_cpu;
+
+    for (const auto &n : {name, lower}) {
+      if (emit_object(cpu->findSymbol(n)))
+        return 0;
+    }
+
+    // W isn't always in the symbol table under its own name.
+    if (lower == "w" && emit_object(cpu->findSymbol("wreg")))
+      return 0;
+
+    for (const auto *sym : m_asserts.m_prog->find_symbols(name)) {
+      switch (sym->type) {
+      case SourceSymbolType::DATA:
+        if (static_cast<unsigned int>(sym->value) < cpu->rma.get_size()) {
+          emit_register(&cpu->rma[sym->value]);
+          return 0;
+        }
+        break;
+
+      case SourceSymbolType::PROGRAM:
+      case SourceSymbolType::CONSTANT:
+        emit_const(sym->value);
+        return 0;
+
+      default:
+        break;
+      }
+    }
+
+    if (emit_object(globalSymbolTable().find(name)))
+      return 0;
+
+    return error("unknown symbol '" + name + "'");
+  }
+
+  bool emit_object(gpsimObject *obj)
+  {
+    if (auto *reg = dynamic_cast<Register*>(obj)) {
+      emit_register(reg);
+      return true;
+    }
+
+    if (auto *i = dynamic_cast<Integer*>(obj)) {
+      auto &ints = m_asserts.m_integers;
+      auto it = std::find(ints.begin(), ints.end(), i);
+      if (it == ints.end())
+        it = ints.insert(ints.end(), i);
+
+      emit(OP_INT, it - ints.begin());
+      return true;
+    }
+
+    return false;
+  }
+
+  void emit_register(Register *reg)
+  {
+    auto &regs = m_asserts.m_registers;
+    auto it = std::find(regs.begin(), regs.end(), reg);
+    if (it == regs.end())
+      it = regs.insert(regs.end(), reg);
+
+    emit(OP_REG, it - regs.begin());
+  }
+
+  void emit_const(int64_t v)
+  {
+    if (v >= 0 && v <= MAX_OPERAND) {
+      emit(OP_CONST, v);
+      return;
+    }
+
+    emit(OP_CONST_WIDE);
+    m_asserts.m_code.push_back(static_cast<uint32_t>(v));
+    m_asserts.m_code.push_back(static_cast<uint32_t>(static_cast<uint64_t>(v) >> 32));
+  }
+
+  void emit(Op op, uint32_t operand = 0)
+  {
+    switch (op) {
+    case OP_CONST:
+    case OP_CONST_WIDE:
+    case OP_REG:
+    case OP_INT:
+    case OP_CYCLES:
+      if (++m_depth > m_max_depth)
+        m_max_depth = m_depth;
+      break;
+
+    default:
+      break;
+    }
+
+    m_asserts.m_code.push_back(op | (operand << 8));
+  }
+
+  int error(const std::string &msg)
+  {
+    if (m_err.empty())
+      m_err = msg + " at column " + std::to_string(m_pos + 1);
+
+    return EINVAL;
+  }
+
+  void skip_space()
+  {
+    while (!at_end() && std::isspace(static_cast<unsigned char>(peek())))
+      ++m_pos;
+  }
+
+  bool at_end() const { return m_pos >= m_text.size(); }
+  char peek() const { return m_text[m_pos]; }
+
+public:
+  int max_depth() const { return m_max_depth; }
+
+private:
+  Assertions &m_asserts;
+  std::string_view m_text;
+  std::size_t m_pos = 0;
+  int m_depth = 0;
+  int m_max_depth = 0;
+  std::string m_err;
+};
+
+//-----------------------------------------------------------
+Assertions::~Assertions()
+{
+  detach();
+}
+
+int Assertions::attach(::Processor *proc, const Program &prog)
+{
+  detach();
+
+  m_cpu = proc;
+  m_prog = &prog;
+
+  for (const auto *type : {"a", "A"}) {
+    for (const auto *dir : prog.find_directives_by_type(type)) {
+      Assertion a = {
+        .addr = dir->addr,
+        .code = static_cast<uint32_t>(m_code.size()),
+        .dir = dir,
+        .text = dir->text,
+        .message = {},
+      };
+      std::string err;
+      Compiler c(*this, dir->text);
+
+      if (c.compile(&a.message, &err) == 0 && c.max_depth() > MAX_STACK_DEPTH)
+        err = "expression too complex";
+
+      if (!err.empty()) {
+        std::cerr << "Ignoring assertion at 0x" << std::hex << dir->addr << std::dec
+                  << " \"" << dir->text << "\": " << err << std::endl;
+        continue;
+      }
+
+      m_asserts.push_back(std::move(a));
+    }
+  }
+
+  std::stable_sort(m_asserts.begin(), m_asserts.end(),
+                   [](const Assertion &a, const Assertion &b) { return a.addr < b.addr; });
+
+  m_armed.assign(proc->program_memory_size(), false);
+
+  for (std::size_t i = 0; i < m_asserts.size();) {
+    std::size_t j = i;
+    while (j < m_asserts.size() && m_asserts[j].addr == m_asserts[i].addr)
+      ++j;
+
+    if (m_asserts[i].addr < m_armed.size()) {
+      m_armed[m_asserts[i].addr] = true;
+      m_by_index[m_asserts[i].addr] = {i, j};
+    }
+
+    i = j;
+  }
+
+  proc->assertions = this;
+
+  return 0;
+}
+
+void Assertions::detach()
+{
+  if (m_cpu && m_cpu->assertions == this)
+    m_cpu->assertions = nullptr;
+
+  m_cpu = nullptr;
+  m_prog = nullptr;
+  m_code.clear();
+  m_registers.clear();
+  m_integers.clear();
+  m_asserts.clear();
+  m_by_index.clear();
+  m_armed.clear();
+}
+
+void Assertions::evaluate(unsigned int index)
+{
+  auto it = m_by_index.find(index);
+
+  if (it == m_by_index.end())
+    return;
+
+  for (std::size_t i = it->second.first; i < it->second.second; ++i) {
+    const auto &a = m_asserts[i];
+
+    if (run(a.code))
+      continue;
+
+    auto lines = m_prog->find_lines(a.addr);
+    const SourceLineRef *line = lines.empty() ? nullptr : lines.front();
+    uint64_t cycle = get_cycles().get();
+
+    std::cerr << "Assertion failed at 0x" << std::hex << a.addr << std::dec;
+    if (line)
+      std::cerr << " (" << line->file << ':' << line->line << ')';
+    std::cerr << ", cycle " << cycle << ": " << a.text << std::endl;
+
+    m_failures.push_back({
+        .cycle = cycle,
+        .addr = a.addr,
+        .text = a.text,
+        .message = a.message,
+        .line = line,
+      });
+
+    if (m_halt_on_failure)
+      m_halted = true;
+  }
+}
+
+int64_t Assertions::run(uint32_t pc) const
+{
+  int64_t stack[MAX_STACK_DEPTH];
+  int sp = -1;
+
+  while (true) {
+    uint32_t insn = m_code[pc++];
+    uint32_t operand = insn >> 8;
+
+    switch (static_cast<Op>(insn & 0xFF)) {
+    case OP_END:
+      return sp >= 0 ? stack[sp] : 0;
+
+    case OP_CONST:
+      stack[++sp] = operand;
+      break;
+
+    case OP_CONST_WIDE:
+      stack[++sp] = static_cast<int64_t>(m_code[pc] | (static_cast<uint64_t>(m_code[pc + 1]) << 32));
+      pc += 2;
+      break;
+
+    case OP_REG:
+      stack[++sp] = m_registers[operand]->get_value();
+      break;
+
+    case OP_INT:
+      stack[++sp] = m_integers[operand]->get();
+      break;
+
+    case OP_CYCLES:
+      stack[++sp] = get_cycles().get();
+      break;
+
+    case OP_DEREF: {
+      uint64_t addr = stack[sp];
+      stack[sp] = addr < m_cpu->rma.get_size() ? m_cpu->rma[addr].get_value() : 0;
+      break;
+    }
+
+    case OP_NEG: stack[sp] = -stack[sp]; break;
+    case OP_NOT: stack[sp] = ~stack[sp]; break;
+    case OP_LNOT: stack[sp] = !stack[sp]; break;
+
+    default: {
+      int64_t b = stack[sp--];
+      int64_t &a = stack[sp];
+
+      switch (static_cast<Op>(insn & 0xFF)) {
+      case OP_MUL: a *= b; break;
+      case OP_DIV: a = b ? a / b : 0; break;
+      case OP_MOD: a = b ? a % b : 0; break;
+      case OP_ADD: a += b; break;
+      case OP_SUB: a -= b; break;
+      case OP_SHL: a = (b >= 0 && b < 64) ? a << b : 0; break;
+      case OP_SHR: a = (b >= 0 && b < 64) ? a >> b : 0; break;
+      case OP_LT: a = a < b; break;
+      case OP_LE: a = a <= b; break;
+      case OP_GT: a = a > b; break;
+      case OP_GE: a = a >= b; break;
+      case OP_EQ: a = a == b; break;
+      case OP_NE: a = a != b; break;
+      case OP_AND: a &= b; break;
+      case OP_XOR: a ^= b; break;
+      case OP_OR: a |= b; break;
+      case OP_LAND: a = a && b; break;
+      case OP_LOR: a = a || b; break;
+      default: return 0;
+      }
+      break;
+    }
+    }
+  }
+}
+
+}  // namespace util
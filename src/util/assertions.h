@@ -0,0 +1,134 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_UTIL_ASSERTIONS_H_
+#define SRC_UTIL_ASSERTIONS_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "program.h"
+
+class Integer;
+class Processor;
+class Register;
+
+namespace util {
+
+// A failed assertion.
+struct AssertionFailure {
+  uint64_t cycle;
+  uint64_t addr;
+  std::string text;
+  std::string message;
+  const SourceLineRef *line;  // Null if there is no line reference.
+};
+
+// Evaluates assertion directives (gpasm .assert, or .direct "a") of a
+// Program while the processor runs.
+//
+// attach() compiles each assertion expression into bytecode, keyed
+// by program memory index, and installs the engine in the processor.
+// The execute phase calls check() for every instruction, which only
+// evaluates anything at annotated addresses. Assertions are evaluated
+// before the instruction at the address is executed.
+//
+// Expressions use C syntax and operator precedence. Identifiers are
+// resolved to processor registers and attributes, Program data
+// symbols (as registers), Program constants and addresses, "W" and
+// "cycles". The unary * operator reads the register at the given
+// address. An assertion may end with a message, e.g.
+//
+//   .assert "(porta & 0x3) == 0x2, 'RA1 should be high'"
+//
+// and an assertion with only a message (or empty) always fails.
+class Assertions {
+public:
+  Assertions() = default;
+  ~Assertions();
+
+  Assertions(const Assertions&) = delete;
+  Assertions& operator =(const Assertions&) = delete;
+
+  // Compiles the assertions in prog and installs them in proc,
+  // replacing any previously attached program. The Program must
+  // outlive the attachment. Assertions that fail to compile are
+  // reported and skipped.
+  int attach(::Processor *proc, const Program &prog);
+  void detach();
+
+  // Evaluates the assertions at the program memory index, if any.
+  void check(unsigned int index)
+  {
+    if (index < m_armed.size() && m_armed[index])
+      evaluate(index);
+  }
+
+  // The number of compiled assertions.
+  std::size_t size() const { return m_asserts.size(); }
+
+  // When true (the default), a failure sets halted().
+  void set_halt_on_failure(bool halt) { m_halt_on_failure = halt; }
+
+  // True if an assertion has failed since the last resume(). Check
+  // this in the Processor::step() condition to stop on failures.
+  bool halted() const { return m_halted; }
+  void resume() { m_halted = false; }
+
+  const std::vector<AssertionFailure>& failures() const { return m_failures; }
+  void clear_failures() { m_failures.clear(); }
+
+private:
+  struct Assertion {
+    uint64_t addr;
+    uint32_t code;  // Offset into m_code.
+    const SourceDirective *dir;
+    std::string text;
+    std::string message;
+  };
+
+  class Compiler;
+
+  void evaluate(unsigned int index);
+  int64_t run(uint32_t pc) const;
+
+private:
+  ::Processor *m_cpu = nullptr;
+  const Program *m_prog = nullptr;
+
+  std::vector<uint32_t> m_code;
+  std::vector<Register*> m_registers;
+  std::vector<Integer*> m_integers;
+  std::vector<Assertion> m_asserts;  // Ordered by addr.
+  std::unordered_map<unsigned int, std::pair<std::size_t, std::size_t>> m_by_index;
+  std::vector<bool> m_armed;
+
+  bool m_halt_on_failure = true;
+  bool m_halted = false;
+  std::vector<AssertionFailure> m_failures;
+};
+
+}  // namespace util
+
+#endif  // SRC_UTIL_ASSERTIONS_H_
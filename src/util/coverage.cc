@@ -0,0 +1,384 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "coverage.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include "../12bit-instructions.h"
+#include "../16bit-instructions.h"
+#include "../processor.h"
+
+
+namespace util {
+
+namespace {
+
+const char MAGIC[] = "GPSIMCOV";
+const uint32_t VERSION = 1;
+
+bool is_conditional(instruction *inst)
+{
+  return dynamic_cast<BTFSC*>(inst) || dynamic_cast<BTFSS*>(inst) ||
+    dynamic_cast<DECFSZ*>(inst) || dynamic_cast<INCFSZ*>(inst) ||
+    dynamic_cast<CPFSEQ*>(inst) || dynamic_cast<CPFSGT*>(inst) ||
+    dynamic_cast<CPFSLT*>(inst) || dynamic_cast<DCFSNZ*>(inst) ||
+    dynamic_cast<INFSNZ*>(inst) || dynamic_cast<TSTFSZ*>(inst) ||
+    dynamic_cast<Branching*>(inst);
+}
+
+void put_u32(std::ostream *os, uint32_t v)
+{
+  for (int i = 0; i < 4; ++i)
+    os->put(static_cast<char>(v >> (8 * i)));
+}
+
+bool get_u32(std::istream *is, uint32_t *v)
+{
+  *v = 0;
+
+  for (int i = 0; i < 4; ++i) {
+    int c = is->get();
+    if (c == std::char_traits<char>::eof())
+      return false;
+
+    *v |= static_cast<uint32_t>(c & 0xFF) << (8 * i);
+  }
+
+  return true;
+}
+
+std::string xml_escape(std::string_view s)
+{
+  std::string out;
+
+  for (char c : s) {
+    switch (c) {
+    case '&': out += "&amp;"; break;
+    case '<': out += "&lt;"; break;
+    case '>': out += "&gt;"; break;
+    case '"': out += "&quot;"; break;
+    case '\'': out += "&apos;"; break;
+    default: out += c; break;
+    }
+  }
+
+  return out;
+}
+
+double rate(unsigned int covered, unsigned int valid)
+{
+  return valid ? static_cast<double>(covered) / valid : 1.0;
+}
+
+}  // namespace
+
+struct Coverage::LineStats {
+  int file;
+  int line;
+  bool hit;
+  std::vector<std::pair<unsigned int, uint8_t>> conditionals;  // (index, flags)
+
+  unsigned int branches() const { return 2 * conditionals.size(); }
+
+  unsigned int branches_hit() const
+  {
+    unsigned int n = 0;
+    for (const auto &c : conditionals)
+      n += !!(c.second & TAKEN) + !!(c.second & NOT_TAKEN);
+    return n;
+  }
+};
+
+Coverage::~Coverage()
+{
+  detach();
+}
+
+int Coverage::attach(::Processor *proc)
+{
+  detach();
+
+  unsigned int n = proc->program_memory_size();
+
+  if (m_flags.size() != n)
+    m_flags.assign(n, 0);
+
+  for (unsigned int i = 0; i < n;) {
+    instruction *inst = proc->program_memory[i];
+    unsigned int size = 1;
+
+    m_flags[i] &= ~(INSTRUCTION | CONDITIONAL);
+
+    if (inst && inst->isa() != instruction::INVALID_INSTRUCTION) {
+      m_flags[i] |= INSTRUCTION;
+
+      if (is_conditional(inst))
+        m_flags[i] |= CONDITIONAL;
+
+      // The second word of a two-word instruction only runs as a NOP.
+      size = std::max(inst->instruction_size(), 1);
+    }
+
+    for (unsigned int j = i + 1; j < i + size && j < n; ++j)
+      m_flags[j] &= ~(INSTRUCTION | CONDITIONAL);
+
+    i += size;
+  }
+
+  m_cpu = proc;
+  proc->coverage = this;
+
+  return 0;
+}
+
+void Coverage::detach()
+{
+  if (m_cpu && m_cpu->coverage == this)
+    m_cpu->coverage = nullptr;
+
+  m_cpu = nullptr;
+}
+
+void Coverage::executed_range(unsigned int index, unsigned int n)
+{
+  unsigned int end = std::min<std::size_t>(index + n, m_flags.size());
+
+  for (unsigned int i = index; i < end; ++i)
+    m_flags[i] |= HIT | NOT_TAKEN;
+}
+
+void Coverage::clear()
+{
+  for (auto &f : m_flags)
+    f &= INSTRUCTION | CONDITIONAL;
+}
+
+int Coverage::merge(const Coverage &other)
+{
+  if (m_flags.empty()) {
+    m_flags = other.m_flags;
+    return 0;
+  }
+
+  if (other.m_flags.size() != m_flags.size())
+    return EINVAL;
+
+  for (std::size_t i = 0; i < m_flags.size(); ++i)
+    m_flags[i] |= other.m_flags[i];
+
+  return 0;
+}
+
+int Coverage::write(std::ostream *os) const
+{
+  os->write(MAGIC, sizeof(MAGIC) - 1);
+  put_u32(os, VERSION);
+  put_u32(os, m_flags.size());
+  os->write(reinterpret_cast<const char*>(m_flags.data()), m_flags.size());
+
+  return *os ? 0 : EIO;
+}
+
+int Coverage::read(std::istream *is)
+{
+  char magic[sizeof(MAGIC) - 1];
+  uint32_t version, size;
+
+  if (!is->read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC))
+    return EINVAL;
+
+  if (!get_u32(is, &version) || version != VERSION || !get_u32(is, &size))
+    return EINVAL;
+
+  if (!m_flags.empty() && m_flags.size() != size)
+    return EINVAL;
+
+  std::vector<uint8_t> flags(size);
+
+  if (!is->read(reinterpret_cast<char*>(flags.data()), size))
+    return EINVAL;
+
+  if (m_flags.empty()) {
+    m_flags = std::move(flags);
+  } else {
+    for (std::size_t i = 0; i < size; ++i)
+      m_flags[i] |= flags[i];
+  }
+
+  return 0;
+}
+
+std::vector<Coverage::LineStats> Coverage::line_stats(const Program &prog) const
+{
+  std::map<std::pair<int, int>, LineStats> lines;
+
+  for (unsigned int i = 0; i < m_flags.size(); ++i) {
+    if (!(m_flags[i] & INSTRUCTION))
+      continue;
+
+    SourceLocation loc = prog.find_location(i);
+
+    if (loc.file < 0)
+      continue;
+
+    auto [it, inserted] = lines.emplace(std::make_pair(loc.file, loc.line),
+                                        LineStats{loc.file, loc.line, false, {}});
+    LineStats &stats = it->second;
+
+    stats.hit |= !!(m_flags[i] & HIT);
+
+    if (m_flags[i] & CONDITIONAL)
+      stats.conditionals.emplace_back(i, m_flags[i]);
+  }
+
+  std::vector<LineStats> out;
+  out.reserve(lines.size());
+  for (auto &entry : lines)
+    out.push_back(std::move(entry.second));
+
+  return out;
+}
+
+int Coverage::write_lcov(std::ostream *os, const Program &prog, std::string_view test_name) const
+{
+  auto lines = line_stats(prog);
+
+  for (auto start = lines.begin(); start != lines.end();) {
+    auto end = std::find_if(start, lines.end(),
+                            [start](const LineStats &s) { return s.file != start->file; });
+    unsigned int lines_hit = 0, branches = 0, branches_hit = 0;
+
+    *os << "TN:" << test_name << '\n';
+    *os << "SF:" << prog.line_files()[start->file] << '\n';
+
+    for (auto it = start; it != end; ++it) {
+      for (const auto &c : it->conditionals) {
+        // Branch 0 is the skip or branch, 1 the next instruction.
+        for (int b = 0; b < 2; ++b) {
+          *os << "BRDA:" << it->line << ',' << c.first << ',' << b << ',';
+
+          if (c.second & HIT)
+            *os << !!(c.second & (b ? NOT_TAKEN : TAKEN)) << '\n';
+          else
+            *os << "-\n";
+        }
+      }
+
+      branches += it->branches();
+      branches_hit += it->branches_hit();
+    }
+
+    *os << "BRF:" << branches << '\n';
+    *os << "BRH:" << branches_hit << '\n';
+
+    for (auto it = start; it != end; ++it) {
+      *os << "DA:" << it->line << ',' << it->hit << '\n';
+      lines_hit += it->hit;
+    }
+
+    *os << "LF:" << (end - start) << '\n';
+    *os << "LH:" << lines_hit << '\n';
+    *os << "end_of_record\n";
+
+    start = end;
+  }
+
+  return *os ? 0 : EIO;
+}
+
+int Coverage::write_cobertura(std::ostream *os, const Program &prog) const
+{
+  auto lines = line_stats(prog);
+  unsigned int lines_hit = 0, branches = 0, branches_hit = 0;
+
+  for (const auto &s : lines) {
+    lines_hit += s.hit;
+    branches += s.branches();
+    branches_hit += s.branches_hit();
+  }
+
+  *os << "<?xml version=\"1.0\" ?>\n"
+      << "<!DOCTYPE coverage SYSTEM \"http://cobertura.sourceforge.net/xml/coverage-04.dtd\">\n"
+      << "<coverage line-rate=\"" << rate(lines_hit, lines.size())
+      << "\" branch-rate=\"" << rate(branches_hit, branches)
+      << "\" lines-covered=\"" << lines_hit << "\" lines-valid=\"" << lines.size()
+      << "\" branches-covered=\"" << branches_hit << "\" branches-valid=\"" << branches
+      << "\" complexity=\"0\" version=\"gpsim\" timestamp=\"" << std::time(nullptr) << "\">\n"
+      << "  <sources>\n    <source>.</source>\n  </sources>\n"
+      << "  <packages>\n"
+      << "    <package name=\"firmware\" line-rate=\"" << rate(lines_hit, lines.size())
+      << "\" branch-rate=\"" << rate(branches_hit, branches) << "\" complexity=\"0\">\n"
+      << "      <classes>\n";
+
+  for (auto start = lines.begin(); start != lines.end();) {
+    auto end = std::find_if(start, lines.end(),
+                            [start](const LineStats &s) { return s.file != start->file; });
+    unsigned int file_lines_hit = 0, file_branches = 0, file_branches_hit = 0;
+
+    for (auto it = start; it != end; ++it) {
+      file_lines_hit += it->hit;
+      file_branches += it->branches();
+      file_branches_hit += it->branches_hit();
+    }
+
+    std::string name = xml_escape(prog.line_files()[start->file]);
+
+    *os << "        <class name=\"" << name << "\" filename=\"" << name
+        << "\" line-rate=\"" << rate(file_lines_hit, end - start)
+        << "\" branch-rate=\"" << rate(file_branches_hit, file_branches)
+        << "\" complexity=\"0\">\n"
+        << "          <methods/>\n"
+        << "          <lines>\n";
+
+    for (auto it = start; it != end; ++it) {
+      *os << "            <line number=\"" << it->line << "\" hits=\"" << it->hit << "\" branch=\"";
+
+      if (it->conditionals.empty()) {
+        *os << "false\"/>\n";
+      } else {
+        unsigned int n = it->branches(), hit = it->branches_hit();
+        *os << "true\" condition-coverage=\"" << (100 * hit / n) << "% ("
+            << hit << '/' << n << ")\"/>\n";
+      }
+    }
+
+    *os << "          </lines>\n"
+        << "        </class>\n";
+
+    start = end;
+  }
+
+  *os << "      </classes>\n"
+      << "    </package>\n"
+      << "  </packages>\n"
+      << "</coverage>\n";
+
+  return *os ? 0 : EIO;
+}
+
+}  // namespace util
@@ -0,0 +1,115 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_UTIL_COVERAGE_H_
+#define SRC_UTIL_COVERAGE_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+#include "program.h"
+
+class Processor;
+
+namespace util {
+
+// Collects statement and branch coverage of the program memory.
+//
+// attach() sizes the coverage to the program memory of the processor,
+// marks the indices holding skip and conditional branch instructions,
+// and installs the collector in the processor. The execute phase
+// calls executed() for every instruction, which sets a few flag bits:
+// whether the instruction ran at all, and whether it ever branched or
+// skipped, and ever continued at the next instruction. Translated
+// blocks are marked as a whole.
+//
+// Coverage of several runs, e.g. of parallel test processes, is
+// combined with merge(), or by reading saved files into one object.
+// Reports map the program memory indices to source lines through the
+// Program line table.
+class Coverage {
+public:
+  enum Flags : uint8_t {
+    INSTRUCTION = 1 << 0,  // There is an instruction at the index.
+    CONDITIONAL = 1 << 1,  // A skip or conditional branch.
+    HIT         = 1 << 2,
+    TAKEN       = 1 << 3,  // Skipped or branched.
+    NOT_TAKEN   = 1 << 4,  // Continued at the next instruction.
+  };
+
+  Coverage() = default;
+  ~Coverage();
+
+  Coverage(const Coverage&) = delete;
+  Coverage& operator =(const Coverage&) = delete;
+
+  // Installs the collector in proc. Hits recorded earlier are kept if
+  // the program memory size is the same, so coverage accumulates
+  // across attachments and resets.
+  int attach(::Processor *proc);
+  void detach();
+
+  // Records that the instruction at the program memory index ran, and
+  // whether the PC then left the straight line.
+  void executed(unsigned int index, bool branched)
+  {
+    if (index < m_flags.size())
+      m_flags[index] |= branched ? HIT | TAKEN : HIT | NOT_TAKEN;
+  }
+
+  // Records a run of n straight-line instructions.
+  void executed_range(unsigned int index, unsigned int n);
+
+  // Forgets all hits.
+  void clear();
+
+  // Adds the hits of other. Returns EINVAL if the sizes differ.
+  int merge(const Coverage &other);
+
+  // The flags by program memory index.
+  const std::vector<uint8_t>& flags() const { return m_flags; }
+
+  // Saves and loads the flags in a small binary format. read() merges
+  // into the existing flags, if any. Both return zero, or an errno
+  // value.
+  int write(std::ostream *os) const;
+  int read(std::istream *is);
+
+  // Writes an LCOV tracefile (geninfo format) or a Cobertura XML
+  // report. Lines are executable if they have an instruction, and
+  // every conditional instruction has a taken and a not-taken branch.
+  int write_lcov(std::ostream *os, const Program &prog, std::string_view test_name = {}) const;
+  int write_cobertura(std::ostream *os, const Program &prog) const;
+
+private:
+  struct LineStats;
+
+  std::vector<LineStats> line_stats(const Program &prog) const;
+
+private:
+  ::Processor *m_cpu = nullptr;
+  std::vector<uint8_t> m_flags;
+};
+
+}  // namespace util
+
+#endif  // SRC_UTIL_COVERAGE_H_
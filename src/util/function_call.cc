@@ -0,0 +1,248 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "function_call.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+
+#include "../14bit-registers.h"
+#include "../gpsim_time.h"
+#include "../pic-processor.h"
+
+
+namespace util {
+
+// Sends the trace of this thread to the private buffer while in scope,
+// and marks the registers written meanwhile.
+class FunctionCall::Scope {
+public:
+  explicit Scope(FunctionCall *fc)
+    : m_fc(fc), m_saved(trace::set_thread_buffer(&fc->m_trace)) {}
+
+  ~Scope()
+  {
+    trace::set_thread_buffer(m_saved);
+    m_fc->mark_trace();
+  }
+
+private:
+  FunctionCall *m_fc;
+  trace::TraceBuffer *m_saved;
+};
+
+
+FunctionCall::FunctionCall(pic_processor *cpu)
+  : m_cpu(cpu), m_trace(TRACE_SIZE)
+{
+  snapshot();
+}
+
+
+void FunctionCall::snapshot()
+{
+  unsigned int n = m_cpu->register_memory_size();
+
+  m_registers.resize(n);
+  for (unsigned int i = 0; i < n; ++i)
+    m_registers[i] = m_cpu->registers[i]->value;
+
+  m_w = m_cpu->Wreg->value;
+  m_stack.assign(std::begin(m_cpu->stack->contents), std::end(m_cpu->stack->contents));
+  m_stack_pointer = m_cpu->stack->pointer;
+  m_pc = m_cpu->pc->value;
+
+  m_dirty.assign(n, false);
+  clear_dirty();
+}
+
+
+void FunctionCall::restore(bool all)
+{
+  if (m_cpu->pc->value != m_pc) {
+    // Only a call that timed out leaves the PC elsewhere.
+    Scope scope(this);
+    m_cpu->pc->put_value(m_pc);
+  }
+
+  if (all || m_overflowed) {
+    for (unsigned int i = 0; i < m_registers.size(); ++i)
+      m_cpu->registers[i]->value = m_registers[i];
+  } else {
+    for (uint16_t addr : m_written)
+      m_cpu->registers[addr]->value = m_registers[addr];
+  }
+
+  m_cpu->Wreg->value = m_w;
+
+  // The stack is at most 32 entries, cheaper to copy than to track.
+  std::copy(m_stack.begin(), m_stack.end(), m_cpu->stack->contents);
+  m_cpu->stack->pointer = m_stack_pointer;
+
+  clear_dirty();
+}
+
+
+void FunctionCall::set_register(unsigned int address, unsigned int value)
+{
+  if (address >= m_registers.size())
+    return;
+
+  Scope scope(this);
+
+  // put_value() is not traced.
+  mark(address);
+  m_cpu->registers[address]->put_value(value);
+}
+
+
+unsigned int FunctionCall::get_register(unsigned int address) const
+{
+  if (address >= m_registers.size())
+    return 0;
+
+  return m_cpu->registers[address]->get_value();
+}
+
+
+void FunctionCall::set_w(unsigned int value)
+{
+  m_cpu->Wreg->value.put(value);
+}
+
+
+unsigned int FunctionCall::get_w() const
+{
+  return m_cpu->Wreg->value.get();
+}
+
+
+int FunctionCall::call(unsigned int address, uint64_t max_cycles)
+{
+  if (m_cpu->simulation_mode != eSM_STOPPED)
+    return EBUSY;
+
+  Scope scope(this);
+  Program_Counter *pc = m_cpu->pc;
+  Stack *stack = m_cpu->stack;
+
+  // Return to where we are now, like a CALL from here would. The PC
+  // may pass the return address inside the routine, so the stack
+  // depth tells the return apart.
+  unsigned int return_pc = pc->value;
+  int depth = stack->pointer;
+
+  stack->push(return_pc);
+  m_cpu->pma->set_PC(address);
+
+  uint64_t start = get_cycles().get();
+  uint64_t stop = start + max_cycles;
+
+  m_cpu->step([pc, stack, return_pc, depth, stop](unsigned int) {
+    return (pc->value != return_pc || stack->pointer != depth) && get_cycles().get() < stop;
+  });
+
+  m_cycles = get_cycles().get() - start;
+
+  if (pc->value != return_pc || stack->pointer != depth)
+    return ETIMEDOUT;
+
+  return 0;
+}
+
+
+int FunctionCall::run(uint64_t cycles)
+{
+  if (m_cpu->simulation_mode != eSM_STOPPED)
+    return EBUSY;
+
+  Scope scope(this);
+  uint64_t start = get_cycles().get();
+
+  m_cpu->step_cycles(cycles);
+  m_cycles = get_cycles().get() - start;
+
+  return 0;
+}
+
+
+int FunctionCall::call(const Program &prog, std::string_view name, uint64_t max_cycles)
+{
+  unsigned int address;
+
+  if (int err = find_routine(prog, name, &address); err)
+    return err;
+
+  return call(address, max_cycles);
+}
+
+
+int FunctionCall::find_routine(const Program &prog, std::string_view name, unsigned int *address)
+{
+  for (const SourceSymbol *sym : prog.find_symbols(name)) {
+    if (sym->type == SourceSymbolType::PROGRAM) {
+      *address = sym->value;
+      return 0;
+    }
+  }
+
+  return ENOENT;
+}
+
+
+void FunctionCall::mark(unsigned int address)
+{
+  if (address < m_dirty.size() && !m_dirty[address]) {
+    m_dirty[address] = true;
+    m_written.push_back(address);
+  }
+}
+
+
+void FunctionCall::mark_trace()
+{
+  // Entries were dropped to make room, so writes may be missing.
+  if (m_trace.discarded() != m_discarded)
+    m_overflowed = true;
+
+  if (m_observer && !m_trace.empty())
+    m_observer(m_trace);
+
+  for (auto it = m_trace.begin(); it != m_trace.end(); ++it) {
+    if ((*it).type() == trace::WRITE_REGISTER)
+      mark((*it).as<trace::WriteRegisterEntry>().address());
+  }
+
+  m_trace.truncate(m_trace.begin());
+  m_discarded = m_trace.discarded();
+}
+
+
+void FunctionCall::clear_dirty()
+{
+  for (uint16_t addr : m_written)
+    m_dirty[addr] = false;
+
+  m_written.clear();
+  m_overflowed = false;
+}
+
+}  // namespace util
@@ -0,0 +1,147 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_UTIL_FUNCTION_CALL_H_
+#define SRC_UTIL_FUNCTION_CALL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../registers.h"
+#include "../trace.h"
+#include "program.h"
+
+class pic_processor;
+
+namespace util {
+
+// Calls firmware routines directly, e.g. to unit test or fuzz them.
+//
+// The constructor takes a snapshot of the register file, W, the stack
+// and the PC. call() pushes the current PC as the return address,
+// jumps to the routine and runs until it returns there, at the same
+// stack depth. Arguments and results are passed in registers, as the
+// calling convention of the firmware says.
+//
+// While a call runs, the trace of this thread goes to a private
+// buffer instead of the global one, and after the call the register
+// writes in it are marked dirty. restore() then only puts back the
+// dirty registers, plus W, the stack and the PC, so a call of a short
+// routine and its restore take about as long as the instructions
+// themselves. If a call overflows the buffer, the next restore() puts
+// back all registers. Like ReverseStepper checkpoints, registers are
+// restored without side effects, and peripheral state outside
+// registers, as well as registers a peripheral changes without
+// tracing, are not restored.
+class FunctionCall {
+public:
+  explicit FunctionCall(pic_processor *cpu);
+  ~FunctionCall() = default;
+
+  FunctionCall(const FunctionCall&) = delete;
+  FunctionCall& operator =(const FunctionCall&) = delete;
+
+  // Takes a new snapshot of the current state, and forgets the writes.
+  void snapshot();
+
+  // Puts back the snapshot. With all, every register is put back, e.g.
+  // after a reset, which does not trace all of its changes.
+  void restore(bool all = false);
+
+  // Writes and reads registers by address, e.g. arguments and results.
+  // Writes are restored like those of the firmware.
+  void set_register(unsigned int address, unsigned int value);
+  unsigned int get_register(unsigned int address) const;
+
+  // Marks a register as written, for changes made without tracing.
+  void touch(unsigned int address) { mark(address); }
+
+  void set_w(unsigned int value);
+  unsigned int get_w() const;
+
+  // Runs the routine at the program memory address until it returns.
+  // Returns zero, EBUSY if the simulation is running, or ETIMEDOUT if
+  // it did not return within max_cycles. The state is left as the
+  // routine left it.
+  int call(unsigned int address, uint64_t max_cycles = DEFAULT_MAX_CYCLES);
+
+  // Like above, but looks up the routine by program symbol. Returns
+  // ENOENT if there is no such symbol.
+  int call(const Program &prog, std::string_view name,
+           uint64_t max_cycles = DEFAULT_MAX_CYCLES);
+
+  // Runs the processor on from where it is for the cycles, with the
+  // same write tracking as call(). Returns zero, or EBUSY if the
+  // simulation is running.
+  int run(uint64_t cycles);
+
+  // Is called with the private trace before it is emptied, after
+  // calls, runs and register writes, e.g. to collect coverage.
+  void set_trace_observer(std::function<void(const trace::TraceBuffer&)> observer)
+  {
+    m_observer = std::move(observer);
+  }
+
+  // Cycles used by the last call or run.
+  uint64_t cycles() const { return m_cycles; }
+
+  // Register addresses written since the last restore, unless the
+  // trace buffer overflowed.
+  const std::vector<uint16_t>& written() const { return m_written; }
+
+  // The address of a program symbol. Returns ENOENT if there is none.
+  static int find_routine(const Program &prog, std::string_view name, unsigned int *address);
+
+  static const uint64_t DEFAULT_MAX_CYCLES = 1 << 20;
+  static const std::size_t TRACE_SIZE = 1 << 16;
+
+private:
+  class Scope;
+
+  void mark(unsigned int address);
+  void mark_trace();
+  void clear_dirty();
+
+private:
+  pic_processor *m_cpu;
+
+  trace::TraceBuffer m_trace;
+  std::size_t m_discarded = 0;
+  bool m_overflowed = false;
+  std::vector<bool> m_dirty;
+  std::vector<uint16_t> m_written;
+  std::function<void(const trace::TraceBuffer&)> m_observer;
+
+  std::vector<RegisterValue> m_registers;
+  RegisterValue m_w;
+  std::vector<unsigned int> m_stack;
+  int m_stack_pointer = 0;
+  unsigned int m_pc = 0;
+
+  uint64_t m_cycles = 0;
+};
+
+}  // namespace util
+
+#endif  // SRC_UTIL_FUNCTION_CALL_H_
@@ -0,0 +1,463 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "fuzzer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#include "../14bit-registers.h"
+#include "../clock_phase.h"
+#include "../pic-processor.h"
+#include "../uart.h"
+#include "assertions.h"
+
+
+namespace util {
+
+namespace {
+
+// Bytes that often matter to parsers.
+const uint8_t INTERESTING[] = { 0, 1, 0x7F, 0x80, 0xFF, '\r', '\n', ' ', '0', '9', 'A', 'z' };
+
+// Spreads program memory indices over the bitmap.
+inline uint32_t scramble(uint32_t v)
+{
+  return v * 0x9E3779B1u >> 8;
+}
+
+// The AFL hit count bucket of a count.
+inline uint8_t bucket(uint8_t count)
+{
+  if (count <= 3)
+    return count ? 1 << (count - 1) : 0;
+  if (count <= 7)
+    return 1 << 3;
+  if (count <= 15)
+    return 1 << 4;
+  if (count <= 31)
+    return 1 << 5;
+  if (count <= 127)
+    return 1 << 6;
+
+  return 1 << 7;
+}
+
+// FNV-1a, to name files by contents.
+uint64_t content_hash(const u8string &data)
+{
+  uint64_t h = 0xCBF29CE484222325ull;
+
+  for (uint8_t c : data) {
+    h ^= c;
+    h *= 0x100000001B3ull;
+  }
+
+  return h;
+}
+
+}  // namespace
+
+
+Fuzzer::Fuzzer(pic_processor *cpu, const Options &opts)
+  : m_cpu(cpu), m_opts(opts), m_call(cpu),
+    m_hits(MAP_SIZE, 0), m_seen(MAP_SIZE, 0), m_rng(opts.seed)
+{
+  unsigned int n = m_cpu->program_memory_size();
+
+  m_invalid.resize(n);
+  for (unsigned int i = 0; i < n; ++i)
+    m_invalid[i] = m_cpu->program_memory[i]->isa() == instruction::INVALID_INSTRUCTION;
+
+  if (m_opts.injection == INJECT_UART && m_opts.address < m_cpu->register_memory_size()) {
+    m_rcreg = dynamic_cast<_RCREG *>(m_cpu->registers[m_opts.address]);
+
+    if (m_rcreg) {
+      m_fifo_sp = m_rcreg->fifo_sp;
+      m_oldest_value = m_rcreg->oldest_value;
+    }
+
+    // push() changes RX9D without tracing.
+    for (unsigned int i = 0; i < m_cpu->register_memory_size(); ++i) {
+      Register *reg = m_cpu->registers[i];
+
+      if (dynamic_cast<_RCSTA *>(reg) && reg->getAddress() == i)
+        m_rcsta_addresses.push_back(i);
+    }
+  }
+
+  m_call.set_trace_observer([this](const trace::TraceBuffer &trace) { observe(trace); });
+
+  m_fastForward = m_cpu->mExecute1Cycle->getFastForward();
+  m_cpu->mExecute1Cycle->setFastForward(false);
+}
+
+
+Fuzzer::~Fuzzer()
+{
+  m_cpu->mExecute1Cycle->setFastForward(m_fastForward);
+}
+
+
+void Fuzzer::add_seed(const u8string &input)
+{
+  run_case(input);
+  m_corpus.push_back(input);
+}
+
+
+int Fuzzer::load_corpus()
+{
+  if (m_opts.corpus_dir.empty())
+    return 0;
+
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  std::vector<fs::path> paths;
+
+  if (!fs::exists(m_opts.corpus_dir, ec))
+    return 0;
+
+  for (fs::directory_iterator it(m_opts.corpus_dir, ec), end; !ec && it != end; it.increment(ec)) {
+    if (it->is_regular_file(ec))
+      paths.push_back(it->path());
+  }
+
+  if (ec)
+    return ec.value();
+
+  // Directory order is arbitrary, and the coverage depends on it.
+  std::sort(paths.begin(), paths.end());
+
+  for (const fs::path &path : paths) {
+    std::ifstream is(path, std::ios::binary);
+
+    if (!is)
+      return EIO;
+
+    std::string data((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    add_seed(u8string(data.begin(), data.end()));
+  }
+
+  return 0;
+}
+
+
+unsigned int Fuzzer::run_case(const u8string &input)
+{
+  m_call.restore(m_reset);
+
+  if (m_rcreg) {
+    m_rcreg->fifo_sp = m_fifo_sp;
+    m_rcreg->oldest_value = m_oldest_value;
+  }
+
+  Stack *stack = m_cpu->stack;
+  unsigned int overflows = stack->overflows;
+
+  if (m_asserts) {
+    m_asserts->clear_failures();
+    m_asserts->resume();
+  }
+
+  m_previous = 0;
+  m_findings = 0;
+  m_reset = false;
+
+  if (m_opts.length_address != NO_ADDRESS)
+    m_call.set_register(m_opts.length_address, input.size());
+
+  int err = 0;
+
+  switch (m_opts.injection) {
+  case INJECT_REGISTERS:
+    for (std::size_t i = 0; i < input.size(); ++i)
+      m_call.set_register(m_opts.address + i, input[i]);
+    break;
+
+  case INJECT_UART:
+    for (uint8_t c : input) {
+      inject_uart(c);
+
+      if (m_opts.routine != NO_ADDRESS)
+        err = m_call.call(m_opts.routine, m_opts.max_cycles);
+      else
+        m_call.run(m_opts.byte_cycles);
+
+      if (err)
+        break;
+    }
+    break;
+
+  case INJECT_CALLBACK:
+    if (m_injector)
+      m_injector(m_call, input);
+    break;
+  }
+
+  if (m_opts.injection != INJECT_UART || m_opts.routine == NO_ADDRESS) {
+    if (m_opts.routine != NO_ADDRESS)
+      err = m_call.call(m_opts.routine, m_opts.max_cycles);
+    else
+      m_call.run(m_opts.max_cycles);
+  }
+
+  if (err == ETIMEDOUT)
+    m_findings |= TIMEOUT;
+
+  if (stack->overflows != overflows)
+    m_findings |= STACK_OVERFLOW;
+
+  if (m_asserts && !m_asserts->failures().empty())
+    m_findings |= ASSERTION;
+
+  m_new_coverage = merge_hits();
+  ++m_executions;
+
+  return m_findings;
+}
+
+
+int Fuzzer::fuzz(uint64_t executions)
+{
+  if (m_corpus.empty())
+    add_seed(u8string());
+
+  for (uint64_t i = 0; i < executions; ++i) {
+    u8string input = mutate(m_corpus[m_rng() % m_corpus.size()]);
+    unsigned int findings = run_case(input);
+
+    if (findings && (m_new_coverage || (findings & ~m_seen_findings))) {
+      m_seen_findings |= findings;
+      m_crashes.push_back({ input, findings });
+
+      if (!m_opts.corpus_dir.empty()) {
+        if (int err = save(input, m_opts.corpus_dir + "/crashes"); err)
+          return err;
+      }
+    } else if (m_new_coverage) {
+      m_corpus.push_back(input);
+
+      if (!m_opts.corpus_dir.empty()) {
+        if (int err = save(input, m_opts.corpus_dir); err)
+          return err;
+      }
+    }
+  }
+
+  // Leaves the processor as it was.
+  m_call.restore(m_reset);
+  m_reset = false;
+
+  return 0;
+}
+
+
+void Fuzzer::observe(const trace::TraceBuffer &trace)
+{
+  for (auto it = trace.begin(); it != trace.end(); ++it) {
+    auto e = *it;
+
+    switch (e.type()) {
+    case trace::INCREMENT_PC: {
+      unsigned int index = e.as<trace::IncrementPCEntry>().address();
+
+      if (index >= m_invalid.size() || m_invalid[index])
+        m_findings |= INVALID_INSTRUCTION;
+      break;
+    }
+
+    case trace::SKIP_PC:
+      hit(scramble(e.as<trace::SkipPCEntry>().address()));
+      break;
+
+    case trace::BRANCH_PC:
+      hit(scramble(e.as<trace::BranchPCEntry>().address()));
+      break;
+
+    case trace::SET_PC: {
+      const trace::SetPCEntry &pc = e.as<trace::SetPCEntry>();
+
+      // Returns and computed gotos go to many places from one.
+      hit(scramble(pc.address()) ^ scramble(pc.target() + 1));
+      break;
+    }
+
+    case trace::INTERRUPT:
+      hit(scramble(~0U));
+      break;
+
+    case trace::RESET: {
+      RESET_TYPE cause = e.as<trace::ResetEntry>().cause();
+
+      if (cause == WDT_RESET || cause == WDTWV_RESET)
+        m_findings |= WATCHDOG_RESET;
+      else if (cause == STKOVF_RESET || cause == STKUNF_RESET)
+        m_findings |= STACK_OVERFLOW;
+
+      m_reset = true;
+      break;
+    }
+
+    default:
+      break;
+    }
+  }
+}
+
+
+void Fuzzer::hit(uint32_t location)
+{
+  uint32_t index = (location ^ m_previous) & (MAP_SIZE - 1);
+
+  if (m_hits[index] == 0)
+    m_touched.push_back(index);
+
+  if (m_hits[index] != 0xFF)
+    ++m_hits[index];
+
+  m_previous = location >> 1;
+}
+
+
+bool Fuzzer::merge_hits()
+{
+  bool found = false;
+
+  for (uint32_t index : m_touched) {
+    uint8_t b = bucket(m_hits[index]);
+
+    if (b & ~m_seen[index]) {
+      if (!m_seen[index])
+        ++m_edges;
+
+      m_seen[index] |= b;
+      found = true;
+    }
+
+    m_hits[index] = 0;
+  }
+
+  m_touched.clear();
+  return found;
+}
+
+
+void Fuzzer::inject_uart(uint8_t c)
+{
+  if (!m_rcreg)
+    return;
+
+  // Pushing traces RCREG and the interrupt flag, but not RCSTA.
+  for (unsigned int address : m_rcsta_addresses)
+    m_call.touch(address);
+
+  m_rcreg->push(c);
+}
+
+
+u8string Fuzzer::mutate(const u8string &input)
+{
+  u8string out = input;
+  unsigned int ops = 1 << (1 + m_rng() % 4);
+
+  for (unsigned int i = 0; i < ops; ++i) {
+    if (out.empty()) {
+      out.push_back(m_rng());
+      continue;
+    }
+
+    std::size_t pos = m_rng() % out.size();
+
+    switch (m_rng() % 8) {
+    case 0:
+      out[pos] ^= 1 << (m_rng() % 8);
+      break;
+
+    case 1:
+      out[pos] = m_rng();
+      break;
+
+    case 2:
+      out[pos] = INTERESTING[m_rng() % sizeof(INTERESTING)];
+      break;
+
+    case 3:
+      out[pos] += (m_rng() % 2 ? 1 : -1) * (1 + m_rng() % 16);
+      break;
+
+    case 4:
+      out.insert(out.begin() + pos, static_cast<uint8_t>(m_rng()));
+      break;
+
+    case 5:
+      out.erase(pos, 1 + m_rng() % std::min<std::size_t>(out.size() - pos, 4));
+      break;
+
+    case 6: {
+      std::size_t n = 1 + m_rng() % std::min<std::size_t>(out.size() - pos, 8);
+      out.insert(m_rng() % (out.size() + 1), out.substr(pos, n));
+      break;
+    }
+
+    case 7: {
+      // Splices in the tail of another corpus entry.
+      const u8string &other = m_corpus[m_rng() % m_corpus.size()];
+
+      if (!other.empty()) {
+        std::size_t from = m_rng() % other.size();
+        out = out.substr(0, pos) + other.substr(from);
+      }
+      break;
+    }
+    }
+  }
+
+  if (out.size() > m_opts.max_input)
+    out.resize(m_opts.max_input);
+
+  return out;
+}
+
+
+int Fuzzer::save(const u8string &input, const std::string &dir)
+{
+  std::error_code ec;
+
+  std::filesystem::create_directories(dir, ec);
+  if (ec)
+    return ec.value();
+
+  char name[17];
+  snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(content_hash(input)));
+
+  std::ofstream os(dir + "/" + name, std::ios::binary);
+  os.write(reinterpret_cast<const char *>(input.data()), input.size());
+
+  return os ? 0 : EIO;
+}
+
+}  // namespace util
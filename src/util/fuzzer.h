@@ -0,0 +1,193 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_UTIL_FUZZER_H_
+#define SRC_UTIL_FUZZER_H_
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../trace.h"
+#include "function_call.h"
+#include "program.h"
+
+class _RCREG;
+class pic_processor;
+
+namespace util {
+
+class Assertions;
+
+// A coverage-guided fuzzer for firmware input handlers.
+//
+// Every case starts from the state the processor was in when the
+// fuzzer was created, restored with a FunctionCall. The input bytes
+// are written to registers, pushed into a UART receive register one
+// at a time, or handed to a callback. Then a routine is called, or the
+// processor runs on for a number of cycles.
+//
+// Edge coverage comes from the private trace of the FunctionCall: the
+// branch, skip, set-PC and interrupt entries are hashed in pairs into
+// a bitmap, AFL style, with hit counts in power of two buckets. Inputs
+// reaching new buckets are added to the corpus, and mutated in turn.
+// The same entries feed the oracles: executing an invalid instruction,
+// watchdog and stack resets, stack overflows, assertion failures and
+// calls that do not return.
+//
+// With a corpus directory, new corpus entries are saved in it, and
+// inputs with findings in its crashes subdirectory, named by a hash
+// of their contents. load_corpus() reads it back, e.g. to resume.
+class Fuzzer {
+public:
+  enum Injection {
+    INJECT_REGISTERS,  // Bytes go to registers from address on.
+    INJECT_UART,       // Bytes are received by the _RCREG at address.
+    INJECT_CALLBACK,   // See set_injector().
+  };
+
+  enum Finding : unsigned int {
+    STACK_OVERFLOW      = 1 << 0,
+    INVALID_INSTRUCTION = 1 << 1,
+    WATCHDOG_RESET      = 1 << 2,
+    ASSERTION           = 1 << 3,
+    TIMEOUT             = 1 << 4,
+  };
+
+  static const unsigned int NO_ADDRESS = ~0U;
+
+  struct Options {
+    Injection injection = INJECT_REGISTERS;
+    unsigned int address = 0;
+
+    // The register receiving the input length, if any.
+    unsigned int length_address = NO_ADDRESS;
+
+    // The routine to call after injecting, or after every UART byte.
+    // Without one, the processor runs for max_cycles, and byte_cycles
+    // after every UART byte.
+    unsigned int routine = NO_ADDRESS;
+    uint64_t max_cycles = 100000;
+    uint64_t byte_cycles = 1000;
+
+    std::size_t max_input = 256;
+    uint32_t seed = 1;
+    std::string corpus_dir;
+  };
+
+  struct Crash {
+    u8string input;
+    unsigned int findings;
+  };
+
+  // The bitmap size, a power of two.
+  static const std::size_t MAP_SIZE = 1 << 16;
+
+  Fuzzer(pic_processor *cpu, const Options &opts);
+  ~Fuzzer();
+
+  Fuzzer(const Fuzzer&) = delete;
+  Fuzzer& operator =(const Fuzzer&) = delete;
+
+  // For INJECT_CALLBACK. The injector writes the input, e.g. with
+  // FunctionCall::set_register(), so the writes are restored.
+  void set_injector(std::function<void(FunctionCall&, const u8string&)> injector)
+  {
+    m_injector = std::move(injector);
+  }
+
+  // Checks assertion failures. The assertions must be attached to the
+  // same processor.
+  void set_assertions(Assertions *asserts) { m_asserts = asserts; }
+
+  // Runs the input, and adds it to the corpus. Does not save it.
+  void add_seed(const u8string &input);
+
+  // Reads and runs all files of the corpus directory. Returns zero, or
+  // an errno value.
+  int load_corpus();
+
+  // Runs one case, and returns its findings. new_coverage() tells if
+  // it reached new edges.
+  unsigned int run_case(const u8string &input);
+  bool new_coverage() const { return m_new_coverage; }
+
+  // Runs mutated corpus entries. Returns zero, or an errno value if
+  // saving an input failed.
+  int fuzz(uint64_t executions);
+
+  uint64_t executions() const { return m_executions; }
+  std::size_t edges() const { return m_edges; }
+  const std::vector<u8string>& corpus() const { return m_corpus; }
+  const std::vector<Crash>& crashes() const { return m_crashes; }
+
+  // The buckets of hit counts reached per bitmap entry.
+  const std::vector<uint8_t>& bitmap() const { return m_seen; }
+
+private:
+  void observe(const trace::TraceBuffer &trace);
+  void hit(uint32_t location);
+  bool merge_hits();
+  void inject_uart(uint8_t c);
+  u8string mutate(const u8string &input);
+  int save(const u8string &input, const std::string &dir);
+
+private:
+  pic_processor *m_cpu;
+  Options m_opts;
+  FunctionCall m_call;
+  std::function<void(FunctionCall&, const u8string&)> m_injector;
+  Assertions *m_asserts = nullptr;
+
+  // Restored on destruction. Idle loop fast-forward hides edges.
+  bool m_fastForward = true;
+
+  // Program memory indices holding invalid instructions.
+  std::vector<bool> m_invalid;
+
+  // The UART receive FIFO is not in registers, so it is restored here.
+  _RCREG *m_rcreg = nullptr;
+  unsigned int m_fifo_sp = 0;
+  unsigned int m_oldest_value = 0;
+  std::vector<unsigned int> m_rcsta_addresses;
+
+  // The current case.
+  std::vector<uint8_t> m_hits;
+  std::vector<uint32_t> m_touched;
+  uint32_t m_previous = 0;
+  unsigned int m_findings = 0;
+  bool m_reset = false;
+  bool m_new_coverage = false;
+
+  std::vector<uint8_t> m_seen;
+  std::size_t m_edges = 0;
+  unsigned int m_seen_findings = 0;
+
+  std::vector<u8string> m_corpus;
+  std::vector<Crash> m_crashes;
+  uint64_t m_executions = 0;
+  std::mt19937 m_rng;
+};
+
+}  // namespace util
+
+#endif  // SRC_UTIL_FUZZER_H_
@@ -0,0 +1,282 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+
+#include "memory.h"
+
+#include <atomic>
+#include <new>
+#include <string>
+#include <unordered_set>
+
+#include "../ioports.h"
+#include "../modules.h"
+#include "../pic-instructions.h"
+#include "../processor.h"
+#include "../registers.h"
+#include "../stimuli.h"
+#include "../symbol.h"
+#include "../trace.h"
+
+
+namespace util {
+namespace memory {
+
+namespace {
+
+const char *const CATEGORIES[NUM_CATEGORIES] = {
+  "registers", "instructions", "pins", "stimulus_nodes", "symbols", "values", "trace",
+};
+
+// Allocations may come from any thread with a simulation.
+std::atomic<uint64_t> live_objects[NUM_CATEGORIES];
+std::atomic<uint64_t> live_bytes[NUM_CATEGORIES];
+
+
+class Walker {
+public:
+  Walker()
+    : m_allocated(allocated())
+  {}
+
+  void add_module(Module *module);
+  void add_table(SymbolTable_t &table);
+  void add_object(gpsimObject *obj);
+
+  Report report() const;
+
+private:
+  void add(Category c, const void *p)
+  {
+    if (p && m_seen.insert(p).second)
+      ++m_report.usage[c].objects;
+  }
+
+  void add_pin(IOPIN *pin);
+  void add_processor(Processor *cpu);
+
+private:
+  Report m_allocated;
+  Report m_report;
+  std::unordered_set<const void *> m_seen;
+};
+
+
+void Walker::add_module(Module *module)
+{
+  if (!module || !m_seen.insert(module).second)
+    return;
+
+  if (Processor *cpu = dynamic_cast<Processor *>(module))
+    add_processor(cpu);
+
+  for (int i = 1; i <= module->get_pin_count(); ++i)
+    add_pin(module->get_pin(i));
+
+  add_table(module->getSymbolTable());
+}
+
+
+void Walker::add_processor(Processor *cpu)
+{
+  unsigned int n = cpu->register_memory_size();
+
+  m_report.usage[REGISTERS].bytes += n * sizeof(Register *);
+
+  for (unsigned int i = 0; i < n; ++i) {
+    Register *reg = cpu->registers[i];
+
+    add_object(reg);
+
+    // The pin modules of ports are only reachable from them.
+    if (PortModule *port = dynamic_cast<PortModule *>(reg)) {
+      for (unsigned int j = 0; j < port->getNumIopins(); ++j) {
+        if (PinModule *pm = port->getIOpins(j)) {
+          add(PINS, pm);
+          add_pin(pm->getPin());
+        }
+      }
+    }
+  }
+
+  // The data EEPROM, if any.
+  n = cpu->ema.get_size();
+  m_report.usage[REGISTERS].bytes += n * sizeof(Register *);
+
+  for (unsigned int i = 0; i < n; ++i)
+    add_object(cpu->ema.get_register(i));
+
+  n = cpu->program_memory_size();
+  m_report.usage[INSTRUCTIONS].bytes += n * sizeof(instruction *);
+
+  for (unsigned int i = 0; i < n; ++i)
+    add_object(cpu->program_memory[i]);
+}
+
+
+void Walker::add_pin(IOPIN *pin)
+{
+  if (!pin)
+    return;
+
+  add(PINS, pin);
+  add_object(pin->snode);
+}
+
+
+void Walker::add_table(SymbolTable_t &table)
+{
+  if (!m_seen.insert(&table).second)
+    return;
+
+  m_report.usage[SYMBOLS].objects += table.size();
+  m_report.usage[SYMBOLS].bytes += table.memory_bytes();
+
+  table.ForEachSymbol([this](const SymbolEntry_t &sym) {
+    add_object(sym.second);
+  });
+}
+
+
+void Walker::add_object(gpsimObject *obj)
+{
+  if (!obj)
+    return;
+
+  if (Module *module = dynamic_cast<Module *>(obj))
+    add_module(module);
+  else if (dynamic_cast<instruction *>(obj))
+    add(INSTRUCTIONS, obj);
+  else if (dynamic_cast<Register *>(obj))
+    add(REGISTERS, obj);
+  else if (IOPIN *pin = dynamic_cast<IOPIN *>(obj))
+    add_pin(pin);
+  else if (dynamic_cast<Stimulus_Node *>(obj))
+    add(STIMULUS_NODES, obj);
+  else if (dynamic_cast<Value *>(obj))
+    add(VALUES, obj);
+}
+
+
+Report Walker::report() const
+{
+  Report r = m_report;
+
+  for (unsigned int i = 0; i < NUM_CATEGORIES; ++i) {
+    const Usage &a = m_allocated.usage[i];
+
+    if (i != SYMBOLS && i != TRACE && a.objects)
+      r.usage[i].bytes += r.usage[i].objects * a.bytes / a.objects;
+  }
+
+  return r;
+}
+
+}  // namespace
+
+
+Usage Report::total() const
+{
+  Usage t;
+
+  for (const Usage &u : usage)
+    t += u;
+
+  return t;
+}
+
+
+const char *name(Category c)
+{
+  return CATEGORIES[c];
+}
+
+
+void account_allocation(Category c, std::size_t size)
+{
+  live_objects[c].fetch_add(1, std::memory_order_relaxed);
+  live_bytes[c].fetch_add(size, std::memory_order_relaxed);
+}
+
+
+void account_deallocation(Category c, std::size_t size)
+{
+  live_objects[c].fetch_sub(1, std::memory_order_relaxed);
+  live_bytes[c].fetch_sub(size, std::memory_order_relaxed);
+}
+
+
+void *allocate(Category c, std::size_t size)
+{
+  void *p = ::operator new(size);
+
+  account_allocation(c, size);
+  return p;
+}
+
+
+void deallocate(Category c, void *p, std::size_t size)
+{
+  account_deallocation(c, size);
+  ::operator delete(p);
+}
+
+
+Report allocated()
+{
+  Report r;
+
+  for (unsigned int i = 0; i < NUM_CATEGORIES; ++i) {
+    r.usage[i].objects = live_objects[i].load(std::memory_order_relaxed);
+    r.usage[i].bytes = live_bytes[i].load(std::memory_order_relaxed);
+  }
+
+  r.usage[TRACE] = trace::memory_usage();
+
+  return r;
+}
+
+
+Report account(Module *module)
+{
+  Walker w;
+
+  w.add_module(module);
+  return w.report();
+}
+
+
+Report account_all()
+{
+  Walker w;
+
+  // Includes the global symbols, and through them the modules.
+  globalSymbolTable().ForEachModule([&w](const SymbolTableEntry_t &st) {
+    w.add_table(*st.second);
+  });
+
+  Report r = w.report();
+
+  r.usage[TRACE] = trace::memory_usage();
+  return r;
+}
+
+}  // namespace memory
+}  // namespace util
@@ -0,0 +1,95 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+
+#ifndef SRC_UTIL_MEMORY_H_
+#define SRC_UTIL_MEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+
+class Module;
+
+namespace util {
+namespace memory {
+
+// The object families that memory is accounted for.
+enum Category {
+  REGISTERS,       // Register, including invalid registers.
+  INSTRUCTIONS,    // instruction, in program memory.
+  PINS,            // IOPIN and PinModule.
+  STIMULUS_NODES,  // Stimulus_Node.
+  SYMBOLS,         // SymbolTable_t entries and indexes.
+  VALUES,          // Other Values, e.g. attributes.
+  TRACE,           // Trace buffers.
+
+  NUM_CATEGORIES,
+};
+
+struct Usage {
+  uint64_t objects = 0;
+  uint64_t bytes = 0;
+
+  Usage& operator +=(const Usage &u)
+  {
+    objects += u.objects;
+    bytes += u.bytes;
+    return *this;
+  }
+};
+
+struct Report {
+  Usage usage[NUM_CATEGORIES];
+
+  Usage total() const;
+};
+
+// Short names, e.g. "registers", as used by the WASM API.
+const char *name(Category c);
+
+// The class specific operator new and delete of the families call
+// these, so the live objects and bytes on the heap are known.
+void *allocate(Category c, std::size_t size);
+void deallocate(Category c, void *p, std::size_t size);
+void account_allocation(Category c, std::size_t size);
+void account_deallocation(Category c, std::size_t size);
+
+// The live heap objects of each family, in all simulations of the
+// process. TRACE is the global trace buffer and its history.
+Report allocated();
+
+// Walks the module, its pins, their nodes and its symbol table, and
+// for processors also the register file and program memory. Objects
+// are counted once, even if reachable several ways. The sizes of
+// objects are not recorded per object, so their bytes are estimated
+// from the average heap size of the family in allocated(). Objects
+// that are members of others, like many special function registers,
+// are counted, but their bytes are part of their owner. The arrays
+// of registers and instructions are included exactly.
+Report account(Module *module);
+
+// Like above, for all modules and global symbols, plus the global
+// trace buffer, i.e. what one simulation uses.
+Report account_all();
+
+}  // namespace memory
+}  // namespace util
+
+#endif  // SRC_UTIL_MEMORY_H_
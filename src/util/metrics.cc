@@ -0,0 +1,375 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#include "../gpsim_object.h"
+
+
+namespace util {
+namespace metrics {
+
+namespace {
+
+struct CounterInfo {
+  const char *key;
+  const char *name;
+  const char *labels;
+  const char *help;
+};
+
+const CounterInfo COUNTERS[NUM_COUNTERS] = {
+  { "stimulus_node_updates", "gpsim_stimulus_node_updates_total", "", "Stimulus_Node::update() calls." },
+  { "stimulus_node_refreshes", "gpsim_stimulus_node_refreshes_total", "", "Stimulus_Node::refresh() calls." },
+  { "pin_updates", "gpsim_pin_updates_total", "", "PinModule::updatePinModule() calls." },
+  { "trace_entries", "gpsim_trace_entries_total", "", "Entries written to trace buffers." },
+  { "trace_discarded", "gpsim_trace_discarded_total", "", "Trace entries dropped to make room." },
+  { "wasm_calls_in", "gpsim_wasm_calls_total", "direction=\"in\"", "Calls across the WASM boundary." },
+  { "wasm_calls_out", "gpsim_wasm_calls_total", "direction=\"out\"", "Calls across the WASM boundary." },
+  { "idle_instructions", "gpsim_idle_instructions_total", "", "Instructions fast-forwarded in idle loops." },
+};
+
+const CounterInfo HISTOGRAMS[NUM_HISTOGRAMS] = {
+  { "break_delay_cycles", "gpsim_break_delay_cycles", "", "Cycles from setting a cycle break to the break." },
+  { "batch_instructions", "gpsim_batch_instructions", "", "Instructions run per execute phase advance." },
+};
+
+const char *const BREAK_EVENTS[NUM_BREAK_EVENTS] = { "set", "cleared", "fired" };
+
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<ThreadMetrics *> threads;
+  std::vector<CoreCounter *> cores;
+
+  // Interned TriggerObject class names.
+  std::unordered_map<std::type_index, std::string> trigger_names;
+
+  // Threads that have exited, and cores that were destroyed.
+  Snapshot retired;
+};
+
+// Never destroyed, as threads may exit after static destruction.
+Registry& registry()
+{
+  static Registry *r = new Registry;
+  return *r;
+}
+
+
+std::atomic<uint64_t> next_thread_id{1};
+
+
+std::string demangle(const char *name)
+{
+#ifdef __GNUG__
+  int status = 0;
+  char *s = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+
+  if (s) {
+    std::string out(s);
+    std::free(s);
+    return out;
+  }
+#endif
+
+  return name;
+}
+
+
+void fold(const ThreadMetrics &m, Snapshot *s)
+{
+  for (unsigned int i = 0; i < NUM_COUNTERS; ++i)
+    s->counters[i] += m.counters[i].load(std::memory_order_relaxed);
+
+  for (unsigned int h = 0; h < NUM_HISTOGRAMS; ++h) {
+    for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; ++i)
+      s->buckets[h][i] += m.buckets[h][i].load(std::memory_order_relaxed);
+
+    s->sums[h] += m.sums[h].load(std::memory_order_relaxed);
+  }
+
+  for (const auto &b : m.breaks) {
+    auto &out = s->breaks[b.first];
+
+    for (unsigned int i = 0; i < NUM_BREAK_EVENTS; ++i)
+      out[i] += b.second[i].load(std::memory_order_relaxed);
+  }
+}
+
+
+// Owns the metrics of a thread, and retires them when it exits.
+struct ThreadHolder {
+  ThreadMetrics metrics;
+
+  ThreadHolder()
+  {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    r.threads.push_back(&metrics);
+  }
+
+  ~ThreadHolder()
+  {
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    fold(metrics, &r.retired);
+    r.threads.erase(std::remove(r.threads.begin(), r.threads.end(), &metrics), r.threads.end());
+    thread_metrics = nullptr;
+    exited = true;
+  }
+
+  static thread_local bool exited;
+};
+
+thread_local bool ThreadHolder::exited = false;
+
+// Counts what is left after a thread's metrics are retired, e.g. from
+// other thread local destructors. It is not reported.
+ThreadMetrics discard;
+
+
+void escape(std::ostream &os, const std::string &s)
+{
+  for (char c : s) {
+    if (c == '\\' || c == '"')
+      os << '\\' << c;
+    else if (c == '\n')
+      os << "\\n";
+    else
+      os << c;
+  }
+}
+
+
+void header(std::ostream &os, const char *name, const char *type, const char *help)
+{
+  os << "# HELP " << name << ' ' << help << '\n'
+     << "# TYPE " << name << ' ' << type << '\n';
+}
+
+}  // namespace
+
+
+const char *name(Counter c)
+{
+  return COUNTERS[c].key;
+}
+
+
+const char *name(Histogram h)
+{
+  return HISTOGRAMS[h].key;
+}
+
+
+const char *name(BreakEvent e)
+{
+  return BREAK_EVENTS[e];
+}
+
+
+ThreadMetrics::ThreadMetrics()
+  : id(next_thread_id.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+
+ThreadMetrics *attach_thread()
+{
+  if (ThreadHolder::exited)
+    return &discard;
+
+  thread_local ThreadHolder holder;
+
+  thread_metrics = &holder.metrics;
+  return thread_metrics;
+}
+
+
+void count_break(const char *trigger, BreakEvent e)
+{
+  ThreadMetrics &m = local();
+  auto it = m.breaks.find(trigger);
+
+  if (it == m.breaks.end()) {
+    // collect() may be iterating the map.
+    std::lock_guard<std::mutex> lock(registry().mutex);
+
+    it = m.breaks.emplace(std::piecewise_construct, std::forward_as_tuple(trigger),
+                          std::forward_as_tuple()).first;
+  }
+
+  add(it->second[e], 1);
+}
+
+
+ThreadMetrics::BreakCounters& break_counters(ThreadMetrics &m, const std::type_info &trigger)
+{
+  Registry &r = registry();
+  // collect() may be iterating the map.
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  auto name = r.trigger_names.find(trigger);
+  if (name == r.trigger_names.end())
+    name = r.trigger_names.emplace(trigger, demangle(trigger.name())).first;
+
+  return m.breaks[name->second.c_str()];
+}
+
+
+CoreCounter::CoreCounter(const gpsimObject *core)
+  : m_core(core)
+{
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  r.cores.push_back(this);
+}
+
+
+CoreCounter::~CoreCounter()
+{
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  r.retired.instructions[m_core->name()] += get();
+  r.cores.erase(std::remove(r.cores.begin(), r.cores.end(), this), r.cores.end());
+}
+
+
+Snapshot collect()
+{
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  Snapshot s = r.retired;
+
+  for (const ThreadMetrics *m : r.threads)
+    fold(*m, &s);
+
+  for (const CoreCounter *c : r.cores)
+    s.instructions[c->m_core->name()] += c->get();
+
+  return s;
+}
+
+
+std::string prometheus(const Snapshot &s)
+{
+  std::ostringstream os;
+
+  header(os, "gpsim_instructions_total", "counter", "Instructions executed, by core.");
+  for (const auto &c : s.instructions) {
+    os << "gpsim_instructions_total{cpu=\"";
+    escape(os, c.first);
+    os << "\"} " << c.second << '\n';
+  }
+
+  header(os, "gpsim_cycle_breaks_total", "counter",
+         "Cycle counter breaks set, cleared and fired, by TriggerObject class.");
+  for (const auto &b : s.breaks) {
+    for (unsigned int i = 0; i < NUM_BREAK_EVENTS; ++i) {
+      os << "gpsim_cycle_breaks_total{trigger=\"";
+      escape(os, b.first);
+      os << "\",event=\"" << BREAK_EVENTS[i] << "\"} " << b.second[i] << '\n';
+    }
+  }
+
+  for (unsigned int i = 0; i < NUM_COUNTERS; ++i) {
+    const CounterInfo &info = COUNTERS[i];
+
+    if (i == 0 || strcmp(COUNTERS[i - 1].name, info.name) != 0)
+      header(os, info.name, "counter", info.help);
+
+    os << info.name;
+    if (*info.labels)
+      os << '{' << info.labels << '}';
+    os << ' ' << s.counters[i] << '\n';
+  }
+
+  for (unsigned int h = 0; h < NUM_HISTOGRAMS; ++h) {
+    const CounterInfo &info = HISTOGRAMS[h];
+    uint64_t count = 0;
+
+    header(os, info.name, "histogram", info.help);
+
+    for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+      count += s.buckets[h][i];
+      os << info.name << "_bucket{le=\"";
+      if (i + 1 < HISTOGRAM_BUCKETS)
+        os << (uint64_t(1) << i);
+      else
+        os << "+Inf";
+      os << "\"} " << count << '\n';
+    }
+
+    os << info.name << "_sum " << s.sums[h] << '\n'
+       << info.name << "_count " << count << '\n';
+  }
+
+  return os.str();
+}
+
+
+void reset()
+{
+  Registry &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  r.retired = Snapshot();
+
+  for (ThreadMetrics *m : r.threads) {
+    for (auto &c : m->counters)
+      c.store(0, std::memory_order_relaxed);
+
+    for (unsigned int h = 0; h < NUM_HISTOGRAMS; ++h) {
+      for (auto &c : m->buckets[h])
+        c.store(0, std::memory_order_relaxed);
+
+      m->sums[h].store(0, std::memory_order_relaxed);
+    }
+
+    for (auto &b : m->breaks) {
+      for (auto &c : b.second)
+        c.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  for (CoreCounter *c : r.cores)
+    c->m_value.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace metrics
+}  // namespace util
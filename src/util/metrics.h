@@ -0,0 +1,216 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+#ifndef SRC_UTIL_METRICS_H_
+#define SRC_UTIL_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <typeinfo>
+
+class gpsimObject;
+
+namespace util {
+namespace metrics {
+
+// Counters of the whole simulator.
+enum Counter {
+  STIMULUS_UPDATES,    // Stimulus_Node::update()
+  STIMULUS_REFRESHES,  // Stimulus_Node::refresh()
+  PIN_UPDATES,         // PinModule::updatePinModule()
+  TRACE_ENTRIES,       // Entries written to trace buffers.
+  TRACE_DISCARDED,     // Entries dropped to make room.
+  WASM_CALLS_IN,       // Calls from JavaScript.
+  WASM_CALLS_OUT,      // Calls to JavaScript.
+  IDLE_INSTRUCTIONS,   // Instructions fast-forwarded in idle loops.
+
+  NUM_COUNTERS,
+};
+
+// Cycle_Counter break events, counted per TriggerObject class.
+enum BreakEvent {
+  BREAK_SET,
+  BREAK_CLEARED,
+  BREAK_FIRED,
+
+  NUM_BREAK_EVENTS,
+};
+
+// Histograms with power of two buckets.
+enum Histogram {
+  BREAK_DELAY,         // Cycles from setting a break to the break.
+  BATCH_INSTRUCTIONS,  // Instructions per execute phase advance().
+
+  NUM_HISTOGRAMS,
+};
+
+// Bucket i holds values up to 1 << i, and the last one the rest.
+const unsigned int HISTOGRAM_BUCKETS = 33;
+
+// The counters of one thread. Only the owning thread writes them, so
+// increments need no atomic read-modify-write, while readers on other
+// threads still see whole values.
+struct ThreadMetrics {
+  typedef std::array<std::atomic<uint64_t>, NUM_BREAK_EVENTS> BreakCounters;
+
+  ThreadMetrics();
+
+  // Unique per ThreadMetrics, unlike its address, which a thread
+  // started later may reuse.
+  const uint64_t id;
+
+  std::atomic<uint64_t> counters[NUM_COUNTERS] = {};
+  std::atomic<uint64_t> buckets[NUM_HISTOGRAMS][HISTOGRAM_BUCKETS] = {};
+  std::atomic<uint64_t> sums[NUM_HISTOGRAMS] = {};
+
+  // By trigger name. The names are interned, so pointers compare
+  // equal. Insertions take the registry lock.
+  std::map<const char *, BreakCounters> breaks;
+};
+
+// The break counters of a TriggerObject on the thread that last used
+// them, so counting its breaks needs no map lookup. The class is part
+// of the key, as it differs while a base class constructor runs.
+struct BreakSlot {
+  uint64_t thread = 0;
+  const std::type_info *trigger = nullptr;
+  ThreadMetrics::BreakCounters *counters = nullptr;
+};
+
+inline thread_local ThreadMetrics *thread_metrics = nullptr;
+
+// Registers the metrics of this thread. They are folded into the
+// totals when the thread exits.
+ThreadMetrics *attach_thread();
+
+inline ThreadMetrics& local()
+{
+  ThreadMetrics *m = thread_metrics;
+  return m ? *m : *attach_thread();
+}
+
+inline void add(std::atomic<uint64_t> &c, uint64_t n)
+{
+  c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void count(Counter c, uint64_t n = 1)
+{
+  add(local().counters[c], n);
+}
+
+inline unsigned int bucket(uint64_t value)
+{
+  if (value <= 1)
+    return 0;
+
+  unsigned int i = 64 - std::countl_zero(value - 1);
+  return i < HISTOGRAM_BUCKETS ? i : HISTOGRAM_BUCKETS - 1;
+}
+
+inline void observe(Histogram h, uint64_t value)
+{
+  ThreadMetrics &m = local();
+
+  add(m.buckets[h][bucket(value)], 1);
+  add(m.sums[h], value);
+}
+
+// The counters for a trigger class, by its demangled name.
+ThreadMetrics::BreakCounters& break_counters(ThreadMetrics &m, const std::type_info &trigger);
+
+// Counts a break without a TriggerObject. The name must be a string
+// literal.
+void count_break(const char *trigger, BreakEvent e);
+
+// Counts a break of a TriggerObject of the given class, caching the
+// counters in the object's slot.
+inline void count_break(BreakSlot &slot, const std::type_info &trigger, BreakEvent e)
+{
+  ThreadMetrics &m = local();
+
+  if (slot.thread != m.id || slot.trigger != &trigger) {
+    slot.counters = &break_counters(m, trigger);
+    slot.thread = m.id;
+    slot.trigger = &trigger;
+  }
+
+  add((*slot.counters)[e], 1);
+}
+
+struct Snapshot;
+
+// The instructions executed by a core, labelled with its name. Only
+// one thread at a time may add to it.
+class CoreCounter {
+public:
+  explicit CoreCounter(const gpsimObject *core);
+  ~CoreCounter();
+
+  CoreCounter(const CoreCounter&) = delete;
+  CoreCounter& operator =(const CoreCounter&) = delete;
+
+  void add(uint64_t n) { metrics::add(m_value, n); }
+  uint64_t get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+  friend Snapshot collect();
+  friend void reset();
+
+  const gpsimObject *m_core;
+  std::atomic<uint64_t> m_value{0};
+};
+
+// The sums over all threads, including those that have exited.
+struct Snapshot {
+  uint64_t counters[NUM_COUNTERS] = {};
+  uint64_t buckets[NUM_HISTOGRAMS][HISTOGRAM_BUCKETS] = {};
+  uint64_t sums[NUM_HISTOGRAMS] = {};
+
+  // Instructions by core name.
+  std::map<std::string, uint64_t> instructions;
+
+  // By TriggerObject class name.
+  std::map<std::string, std::array<uint64_t, NUM_BREAK_EVENTS>> breaks;
+};
+
+Snapshot collect();
+
+// Short names, e.g. "pin_updates" or "set", as used by the WASM API.
+const char *name(Counter c);
+const char *name(Histogram h);
+const char *name(BreakEvent e);
+
+// The snapshot in the Prometheus text exposition format.
+std::string prometheus(const Snapshot &snapshot);
+inline std::string prometheus() { return prometheus(collect()); }
+
+// Zeroes the metrics of all threads and objects. Must not race with
+// writers, e.g. call it while the simulation is stopped.
+void reset();
+
+}  // namespace metrics
+}  // namespace util
+
+#endif  // SRC_UTIL_METRICS_H_
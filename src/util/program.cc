@@ -87,6 +87,8 @@ int Program::build_indices()
   if (int err=  build_lines_index(); err)
     return err;
 
+  build_line_table();
+
   build_directives_index();
 
   return 0;
@@ -195,6 +197,66 @@ int Program::build_lines_index()
   return 0;
 }
 
+SourceLocation Program::find_location(uint64_t addr) const
+{
+  if (addr < m_line_table_lines.size())
+    return {m_line_table_files[addr], m_line_table_lines[addr]};
+
+  auto lines = find_lines(addr);
+
+  if (lines.empty())
+    return {-1, 0};
+
+  auto it = std::find(m_line_files.begin(), m_line_files.end(), lines.front()->file);
+  return {static_cast<int>(it - m_line_files.begin()), lines.front()->line};
+}
+
+void Program::build_line_table()
+{
+  m_line_files.clear();
+  m_line_table_files.clear();
+  m_line_table_lines.clear();
+
+  std::unordered_map<std::string_view, int32_t> file_index;
+  std::vector<int32_t> ref_files;
+
+  for (const auto &ref : m_line_refs) {
+    auto [it, inserted] = file_index.emplace(ref.file, m_line_files.size());
+    if (inserted)
+      m_line_files.push_back(ref.file);
+
+    ref_files.push_back(it->second);
+  }
+
+  if (m_line_refs.empty())
+    return;
+
+  // The table ends at the first large gap, so configuration words and
+  // EEPROM data far above the code do not blow it up. find_location()
+  // searches for addresses past the end.
+  uint64_t end = m_line_refs.front().addr + 1;
+
+  for (const auto &ref : m_line_refs) {
+    if (ref.addr - (end - 1) > MAX_LINE_TABLE_GAP)
+      break;
+
+    end = ref.addr + 1;
+  }
+
+  m_line_table_files.assign(end, -1);
+  m_line_table_lines.assign(end, 0);
+
+  // Among references to the same address, find_lines() returns the
+  // last one first.
+  for (std::size_t i = 0; i < m_line_refs.size() && m_line_refs[i].addr < end; ++i) {
+    const auto &ref = m_line_refs[i];
+    uint64_t next = i + 1 < m_line_refs.size() ? std::min(m_line_refs[i + 1].addr, end) : end;
+
+    std::fill(m_line_table_files.begin() + ref.addr, m_line_table_files.begin() + next, ref_files[i]);
+    std::fill(m_line_table_lines.begin() + ref.addr, m_line_table_lines.begin() + next, ref.line);
+  }
+}
+
 std::vector<const SourceDirective*> Program::find_directives_by_type(std::string_view type) const
 {
   auto it = m_directives_by_type.find(type);
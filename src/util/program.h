@@ -21,6 +21,7 @@ License along with this library; if not, see
 #ifndef SRC_UTIL_PROGRAM_
 #define SRC_UTIL_PROGRAM_
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -74,6 +75,12 @@ struct SourceLineRef {
   int line;
 };
 
+// A location in the dense line table.
+struct SourceLocation {
+  int file;  // Index into Program::line_files(), or -1 if unknown.
+  int line;
+};
+
 struct SourceDirective {
   uint64_t addr;
   std::string type;
@@ -107,13 +114,26 @@ public:
   std::vector<const SourceLineRef*> find_lines(std::string_view file, int line) const;
   std::vector<const SourceLineRef*> find_lines(uint64_t addr) const;
 
+  // The line table, built by build_indices(). It maps every address
+  // of the program code to the file and line find_lines() would return
+  // first, so bulk lookups are an array index each. The file index is -1
+  // before the first line reference.
+  SourceLocation find_location(uint64_t addr) const;
+  const std::vector<std::string_view>& line_files() const { return m_line_files; }
+  const std::vector<int32_t>& line_table_files() const { return m_line_table_files; }
+  const std::vector<int32_t>& line_table_lines() const { return m_line_table_lines; }
+
   std::vector<const SourceDirective*> find_directives_by_type(std::string_view type) const;
   std::vector<const SourceDirective*> find_directives(uint64_t addr) const;
 
+  // The largest gap between line references inside the line table.
+  static const uint64_t MAX_LINE_TABLE_GAP = 1 << 16;
+
 private:
   void intern_strings();
   void build_symbols_indices();
   int  build_lines_index();
+  void build_line_table();
   void build_directives_index();
 
 private:
@@ -130,6 +150,9 @@ private:
   std::unordered_multimap<std::pair<SourceSymbolType, int>, SourceSymbol*> m_symbols_by_value;
   std::multimap<std::pair<std::string_view, int>, SourceLineRef*> m_lines_by_loc;
   std::unordered_map<std::string_view, std::vector<SourceDirective*>> m_directives_by_type;
+  std::vector<std::string_view> m_line_files;
+  std::vector<int32_t> m_line_table_files;    // Indexed by addr.
+  std::vector<int32_t> m_line_table_lines;    // Indexed by addr.
 };
 
 int upload(::Processor *proc, const Program &prog);
@@ -22,6 +22,7 @@ License along with this library; if not, see
 #define SRC_VALUE_H_
 
 #include "gpsim_object.h"
+#include "util/memory.h"
 #include <cstddef>
 #include <cstring>
 #include <list>
@@ -45,6 +46,11 @@ public:
   Value() = default;
   Value(const char *name, const char *desc, Module *pM = nullptr);
 
+  // Heap Values are accounted for, see util/memory.h. The larger
+  // families of Values account for themselves.
+  static void *operator new(std::size_t size) { return util::memory::allocate(util::memory::VALUES, size); }
+  static void operator delete(void *p, std::size_t size) { util::memory::deallocate(util::memory::VALUES, p, size); }
+
   Module *get_module() const { return module; }
 
 private:
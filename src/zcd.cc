@@ -96,6 +96,11 @@ public:
     void set_nodeVoltage(double) override;
     void putState(char) override {}
     void setDirection() override {}
+    bool add_thresholds(std::vector<double> &thresholds) override
+    {
+        thresholds.push_back(0.75);
+        return true;
+    }
 
 private:
     enum State
@@ -0,0 +1,142 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of gpsim.
+
+gpsim is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2, or (at your option)
+any later version.
+
+gpsim is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with gpsim; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+// gpsim-cov - merges coverage files written by util::Coverage, and
+// writes LCOV and Cobertura reports for the program they came from.
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/util/cod.h"
+#include "../src/util/coverage.h"
+#include "../src/util/program.h"
+
+namespace {
+
+struct Options {
+  std::string program;
+  std::vector<std::string> inputs;
+  std::string lcov;
+  std::string cobertura;
+  std::string output;
+  std::string test_name;
+} opts;
+
+void usage()
+{
+  std::cerr << "usage: gpsim-cov [--lcov FILE] [--cobertura FILE] [--output FILE]\n"
+               "                 [--test-name NAME] PROGRAM.cod COVERAGE...\n";
+  std::exit(2);
+}
+
+// Opens the file for writing, or "-" for stdout, and calls fn.
+template<typename F>
+int write_file(const std::string &path, F fn)
+{
+  if (path == "-")
+    return fn(&std::cout);
+
+  std::ofstream os(path, std::ios::binary);
+  if (!os)
+    return errno;
+
+  int err = fn(&os);
+  os.close();
+
+  return err ? err : (os ? 0 : EIO);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+
+    if (arg == "--lcov" && i + 1 < argc) {
+      opts.lcov = argv[++i];
+    } else if (arg == "--cobertura" && i + 1 < argc) {
+      opts.cobertura = argv[++i];
+    } else if (arg == "--output" && i + 1 < argc) {
+      opts.output = argv[++i];
+    } else if (arg == "--test-name" && i + 1 < argc) {
+      opts.test_name = argv[++i];
+    } else if (arg[0] != '-' && opts.program.empty()) {
+      opts.program = arg;
+    } else if (arg[0] != '-') {
+      opts.inputs.push_back(arg);
+    } else {
+      usage();
+    }
+  }
+
+  if (opts.program.empty() || opts.inputs.empty())
+    usage();
+
+  util::Program prog;
+  std::ifstream cod(opts.program, std::ios::binary);
+
+  if (!cod) {
+    std::cerr << opts.program << ": " << std::strerror(errno) << '\n';
+    return 1;
+  }
+
+  int err = util::CODFileReader::read_program(&prog, &cod);
+  if (!err)
+    err = prog.build_indices();
+
+  if (err) {
+    std::cerr << opts.program << ": " << std::strerror(err) << '\n';
+    return 1;
+  }
+
+  util::Coverage cov;
+
+  for (const auto &path : opts.inputs) {
+    std::ifstream is(path, std::ios::binary);
+
+    err = is ? cov.read(&is) : errno;
+    if (err) {
+      std::cerr << path << ": " << std::strerror(err) << '\n';
+      return 1;
+    }
+  }
+
+  if (!opts.output.empty())
+    err = write_file(opts.output, [&cov](std::ostream *os) { return cov.write(os); });
+
+  if (!err && !opts.lcov.empty())
+    err = write_file(opts.lcov, [&](std::ostream *os) { return cov.write_lcov(os, prog, opts.test_name); });
+
+  if (!err && !opts.cobertura.empty())
+    err = write_file(opts.cobertura, [&](std::ostream *os) { return cov.write_cobertura(os, prog); });
+
+  if (err) {
+    std::cerr << "gpsim-cov: " << std::strerror(err) << '\n';
+    return 1;
+  }
+
+  return 0;
+}
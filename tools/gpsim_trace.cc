@@ -0,0 +1,144 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of gpsim.
+
+gpsim is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2, or (at your option)
+any later version.
+
+gpsim is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with gpsim; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+// gpsim-trace - prints trace files written by trace::TraceRecorder.
+//
+// Entries are printed one per line, starting at the last cycle stamp
+// at or before --from, and ending at the first stamp after --to.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <variant>
+
+#include "../src/trace_file.h"
+
+namespace {
+
+struct Options {
+  std::string file;
+  uint64_t from = 0;
+  uint64_t to = UINT64_MAX;
+  bool info = false;
+} opts;
+
+void usage()
+{
+  std::cerr << "usage: gpsim-trace [--from CYCLE] [--to CYCLE] [--info] FILE\n";
+  std::exit(2);
+}
+
+void print_info(const trace::TraceFileReader &reader)
+{
+  std::printf("cycles:  %llu - %llu\n",
+              static_cast<unsigned long long>(reader.first_cycle()),
+              static_cast<unsigned long long>(reader.last_cycle()));
+  std::printf("chunks:  %zu (%s)\n", reader.num_chunks(),
+              reader.indexed() ? "indexed" : "scanned, no trailer");
+}
+
+// Prints the entry. Returns false if it is a stamp after --to.
+bool print_entry(const trace::EntryRegistry::variant &entry)
+{
+  return std::visit([](const auto &e) -> bool {
+    using T = std::decay_t<decltype(e)>;
+
+    if constexpr (std::is_same_v<T, trace::CycleCounterEntry>) {
+      if (e.cycle() > opts.to) return false;
+      std::printf("cycle %llu\n", static_cast<unsigned long long>(e.cycle()));
+    } else if constexpr (std::is_same_v<T, trace::ReadRegisterEntry>) {
+      std::printf("  read  %04x %02x/%02x\n", e.address(), e.value(), e.mask());
+    } else if constexpr (std::is_same_v<T, trace::WriteRegisterEntry>) {
+      std::printf("  write %04x %02x/%02x\n", e.address(), e.value(), e.mask());
+    } else if constexpr (std::is_same_v<T, trace::SetPCEntry>) {
+      std::printf("  setpc %04x -> %04x\n", e.address(), e.target());
+    } else if constexpr (std::is_same_v<T, trace::IncrementPCEntry>) {
+      std::printf("  pc    %04x\n", e.address());
+    } else if constexpr (std::is_same_v<T, trace::SkipPCEntry>) {
+      std::printf("  skip  %04x\n", e.address());
+    } else if constexpr (std::is_same_v<T, trace::BranchPCEntry>) {
+      std::printf("  jump  %04x\n", e.address());
+    } else if constexpr (std::is_same_v<T, trace::InterruptEntry>) {
+      std::printf("  interrupt\n");
+    } else if constexpr (std::is_same_v<T, trace::ResetEntry>) {
+      std::printf("  reset %d\n", static_cast<int>(e.cause()));
+    } else if constexpr (std::is_same_v<T, trace::UnknownEntry>) {
+      std::printf("  unknown type %d\n", e.type());
+    }
+
+    return true;
+  }, entry);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+
+    if (arg == "--info") {
+      opts.info = true;
+    } else if (arg == "--from" && i + 1 < argc) {
+      opts.from = std::strtoull(argv[++i], nullptr, 0);
+    } else if (arg == "--to" && i + 1 < argc) {
+      opts.to = std::strtoull(argv[++i], nullptr, 0);
+    } else if (arg[0] != '-' && opts.file.empty()) {
+      opts.file = arg;
+    } else {
+      usage();
+    }
+  }
+
+  if (opts.file.empty())
+    usage();
+
+  trace::TraceFileReader reader;
+
+  int err = reader.open(opts.file);
+  if (err) {
+    std::cerr << opts.file << ": " << std::strerror(err) << '\n';
+    return 1;
+  }
+
+  if (opts.info) {
+    print_info(reader);
+    return 0;
+  }
+
+  err = reader.seek(opts.from);
+  if (err) {
+    std::cerr << opts.file << ": " << std::strerror(err) << '\n';
+    return 1;
+  }
+
+  trace::EntryRegistry::variant entry{trace::UnknownEntry(trace::BASE)};
+
+  while (reader.next(&entry) && print_entry(entry)) {}
+
+  if (reader.lost())
+    std::printf("lost %llu entries\n", static_cast<unsigned long long>(reader.lost()));
+
+  return 0;
+}
@@ -0,0 +1,77 @@
+/*
+   Copyright (C) 2023 Tommie Gannert
+
+This file is part of the libgpsim library of gpsim
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see
+<http://www.gnu.org/licenses/lgpl-2.1.html>.
+*/
+
+// A processor family as a side module of the split WASM library.
+//
+// It is built once per family, with GPSIM_PROCESSOR_FAMILY set to the
+// family name, and linked with the family source and the side modules
+// of the families it derives from. When the core module loads it, it
+// provides the constructors of its processors to the catalog.
+
+#include <config.h>
+
+#include "../src/p16x5x.h"
+#include "../src/p16f62x.h"
+#include "../src/p16f8x.h"
+#include "../src/p16f88x.h"
+#include "../src/p16x8x.h"
+#include "../src/p16f87x.h"
+#include "../src/p16x6x.h"
+#include "../src/p16x7x.h"
+#include "../src/p16f91x.h"
+#include "../src/p12x.h"
+#include "../src/p12f6xx.h"
+#include "../src/p1xf1xxx.h"
+#ifdef P17C7XX
+#include "../src/p17c75x.h"
+#endif
+#include "../src/p18x.h"
+#include "../src/p18fk.h"
+#include "../src/processor.h"
+
+#define FAMILY_STRING_(family) #family
+#define FAMILY_STRING(family) FAMILY_STRING_(family)
+
+namespace {
+
+  constexpr bool same(const char *a, const char *b) {
+    while (*a && *a == *b) {
+      ++a;
+      ++b;
+    }
+
+    return *a == *b;
+  }
+
+  struct FamilyProvider {
+    FamilyProvider() {
+      // Other families are discarded statements, so their constructors
+      // are not linked.
+#define PROCESSOR(family, variable, cls, name1, name2, name3, name4) \
+      if constexpr (same(#family, FAMILY_STRING(GPSIM_PROCESSOR_FAMILY))) \
+        ProcessorConstructor::provide(name1, cls::construct);
+#include "../src/processor_catalog.inc"
+#undef PROCESSOR
+    }
+  };
+
+  FamilyProvider provider;
+
+}  // namespace
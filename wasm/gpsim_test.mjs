@@ -31,6 +31,584 @@ function vectorToArray(v, mapper = (e) => e) {
   return a;
 }
 
+function assert(cond, msg) {
+  if (!cond) {
+    throw new Error('assertion failed: ' + msg);
+  }
+}
+
+function range(first, end) {
+  return Array.from({ length: end - first }, (_, i) => first + i);
+}
+
+// Loads one instruction word per program memory index, from index 0.
+function loadWords(proc, words) {
+  const bytes = new Uint8Array(2 * words.length);
+  words.forEach((w, i) => {
+    bytes[2 * i] = w & 0xff;
+    bytes[2 * i + 1] = w >> 8;
+  });
+  proc.init_program_memory_at_index(0, bytes);
+}
+
+// The PC, the values of the registers at the addresses and the cycles
+// used since start.
+function processorState(module, proc, addresses, start) {
+  return {
+    pc: proc.GetProgramCounter().get_PC(),
+    cycles: module.get_cycles() - start,
+    registers: addresses.map(addr => proc.get_register(addr).get_value()),
+  };
+}
+
+// Resets the processor and returns its state after ncycles.
+function runFromReset(module, proc, ncycles, addresses) {
+  proc.reset(module.RESET_TYPE.POR_RESET);
+  const start = module.get_cycles();
+  proc.step_cycles(ncycles);
+  return processorState(module, proc, addresses, start);
+}
+
+function assertSameState(a, b, msg) {
+  assert(JSON.stringify(a) === JSON.stringify(b), `${msg}: ${JSON.stringify(a)} != ${JSON.stringify(b)}`);
+}
+
+// Translated blocks end with the same registers and cycle count as
+// the interpreter.
+function testTranslation(module, ctx) {
+  const proc = ctx.add_processor_by_type('p18f452', 'translated');
+  loadWords(proc, [
+    0x6A10, 0x6A11, 0x0E03,  // clrf 0x10; clrf 0x11; movlw 3
+    0x2610, 0x2A11, 0x1811,  // loop: addwf 0x10, f; incf 0x11, f; xorwf 0x11, w
+    0x6E12, 0x1E12, 0xD7FA,  // movwf 0x12; comf 0x12, f; bra loop
+  ]);
+  const addresses = [...range(0x10, 0x13), 0xfe8];  // And WREG.
+
+  assert(proc.enable_translation(true), 'translation is supported');
+  const translated = runFromReset(module, proc, 5000, addresses);
+
+  proc.enable_translation(false);
+  const interpreted = runFromReset(module, proc, 5000, addresses);
+
+  assertSameState(translated, interpreted, 'translated run');
+}
+
+// Fast-forwarding through a polling loop ends in the same state, and
+// counts the same instructions, as running every iteration.
+function testFastForward(module, ctx) {
+  const proc = ctx.add_processor_by_type('p16f887', 'polling');
+  loadWords(proc, [
+    0x01A0, 0x1683, 0x300F,  // clrf 0x20; bsf STATUS, RP0; movlw 0x0F (TMR0 1:1)
+    0x0081, 0x1283, 0x1D0B,  // movwf OPTION_REG; bcf STATUS, RP0; loop: btfss INTCON, T0IF
+    0x2805, 0x110B, 0x0AA0,  // goto loop; bcf INTCON, T0IF; incf 0x20, f
+    0x2805,                  // goto loop
+  ]);
+  const addresses = [0x20, 0x01, 0x0b];  // And TMR0, INTCON.
+
+  const run = () => {
+    module.metrics_reset();
+    const state = runFromReset(module, proc, 300000, addresses);
+    const metrics = module.metrics_snapshot();
+    return {
+      state,
+      skipped: metrics.counters.idle_instructions,
+      instructions: metrics.instructions.polling,
+    };
+  };
+
+  const forwarded = run();
+
+  proc.set_fast_forward(false);
+  const stepped = run();
+
+  assert(stepped.state.registers[0] > 0, 'the loop saw TMR0 overflows');
+  assert(forwarded.skipped > 150000, `fast-forwarded ${forwarded.skipped} instructions`);
+  assert(stepped.skipped === 0, 'stepped without fast-forward');
+  assertSameState(forwarded.state, stepped.state, 'fast-forwarded run');
+  assert(forwarded.instructions === stepped.instructions,
+         `${forwarded.instructions} != ${stepped.instructions} instructions`);
+}
+
+// Rewriting a row where only the second word of a two-word
+// instruction changes ends in the same state as loading it fresh.
+function testRowRewrite(module, ctx) {
+  const program = (literal, dest) => [
+    0x0E00 | literal, 0x6E10,  // movlw literal; movwf 0x10
+    0xC010, 0xF000 | dest,     // movff 0x10, dest
+    0xD7FF,                    // bra $
+  ];
+  const addresses = [0x10, 0x12, 0xfe8];  // And WREG.
+
+  const proc = ctx.add_processor_by_type('p18f452', 'rewritten');
+  loadWords(proc, program(0x5A, 0x11));
+  const before = runFromReset(module, proc, 100, [0x11]);
+  assert(before.registers[0] === 0x5A, 'movff wrote 0x11');
+
+  loadWords(proc, program(0xA5, 0x12));
+  const rewritten = runFromReset(module, proc, 100, addresses);
+
+  const fresh = ctx.add_processor_by_type('p18f452', 'fresh');
+  loadWords(fresh, program(0xA5, 0x12));
+  const loaded = runFromReset(module, fresh, 100, addresses);
+
+  assert(rewritten.registers[1] === 0xA5, 'movff wrote 0x12');
+  assertSameState(rewritten, loaded, 'rewritten row');
+}
+
+// Stepping back to an earlier cycle restores the state there, and
+// running forward again reaches the same later state.
+function testReverse(module, ctx) {
+  const proc = ctx.add_processor_by_type('p16f887', 'reversed');
+  loadWords(proc, [
+    0x0AA2, 0x2006, 0x0822,  // loop: incf 0x22, f; call sub; movf 0x22, w
+    0x07A3, 0x06A4, 0x2800,  // addwf 0x23, f; xorwf 0x24, f; goto loop
+    0x00A4, 0x0AA4, 0x3405,  // sub: movwf 0x24; incf 0x24, f; retlw 5
+  ]);
+  const addresses = range(0x22, 0x25);
+
+  assert(proc.enable_reverse(true), 'reverse stepping is supported');
+  const before = runFromReset(module, proc, 2000, addresses);
+  const start = module.get_cycles() - before.cycles;
+
+  proc.step_cycles(1000);
+  const after = processorState(module, proc, addresses, start);
+
+  while (module.get_cycles() - start > before.cycles) {
+    assert(proc.step_back(1) === 1, 'stepped back one instruction');
+  }
+  assertSameState(processorState(module, proc, addresses, start), before, 'stepped back');
+
+  proc.step_cycles(after.cycles - before.cycles);
+  assertSameState(processorState(module, proc, addresses, start), after, 'stepped forward again');
+
+  proc.enable_reverse(false);
+}
+
+// Coverage marks the instructions that ran, and both outcomes of the
+// skip that ended the loop, but not the instruction after it.
+function testCoverage(module, ctx) {
+  const proc = ctx.add_processor_by_type('p16f887', 'covered');
+  loadWords(proc, [
+    0x01A0, 0x0AA0, 0x1D20,  // clrf 0x20; loop: incf 0x20, f; btfss 0x20, 2
+    0x2801, 0x2804, 0x3005,  // goto loop; done: goto done; movlw 5
+  ]);
+
+  // Coverage::Flags.
+  const INSTRUCTION = 1 << 0, CONDITIONAL = 1 << 1, HIT = 1 << 2, TAKEN = 1 << 3, NOT_TAKEN = 1 << 4;
+
+  const cov = new module.Coverage();
+  try {
+    cov.attach(proc);
+    runFromReset(module, proc, 200, []);
+    const flags = cov.flags();
+    cov.detach();
+
+    const hit = [];
+    flags.forEach((f, i) => {
+      if (f & HIT) {
+        hit.push(i);
+      }
+    });
+    assertSameState(hit, range(0, 5), 'executed instructions');
+    assert(flags[2] === (INSTRUCTION | CONDITIONAL | HIT | TAKEN | NOT_TAKEN), `skip flags ${flags[2]}`);
+    assert(flags[4] === (INSTRUCTION | HIT | TAKEN), `goto flags ${flags[4]}`);
+    assert(flags[5] === INSTRUCTION, `flags ${flags[5]} of the instruction never run`);
+  } finally {
+    cov.delete();
+  }
+}
+
+// A called routine returns its result in W, and restore() puts back
+// the registers, W and the PC of the caller.
+function testFunctionCall(module, ctx) {
+  const proc = ctx.add_processor_by_type('p16f887', 'called');
+  const words = new Array(0x14).fill(0);
+  words[0] = 0x2800;  // loop: goto loop
+  words.splice(0x10, 4, 0x0820, 0x0721, 0x00A2, 0x0008);  // add: movf 0x20, w; addwf 0x21, w; movwf 0x22; return
+  loadWords(proc, words);
+  const addresses = range(0x20, 0x23);
+
+  const before = runFromReset(module, proc, 10, addresses);
+  const start = module.get_cycles() - before.cycles;
+  const callerState = () => {
+    const { pc, registers } = processorState(module, proc, addresses, start);
+    return { pc, registers };
+  };
+  const caller = callerState();
+
+  const fc = new module.FunctionCall(proc);
+  try {
+    const w = fc.getW();
+    fc.setRegister(0x20, 3);
+    fc.setRegister(0x21, 4);
+    fc.call(0x10, 100);
+    assert(fc.getW() === 7 && fc.getRegister(0x22) === 7, `returned ${fc.getW()}, stored ${fc.getRegister(0x22)}`);
+    assert(fc.cycles > 0 && fc.cycles < 100, `the call took ${fc.cycles} cycles`);
+
+    fc.restore();
+    assertSameState(callerState(), caller, 'restored caller');
+    assert(fc.getW() === w, `restored W ${fc.getW()} != ${w}`);
+  } finally {
+    fc.delete();
+  }
+}
+
+// The fuzzer finds the input that gets past two byte comparisons into
+// unprogrammed memory, and reports nothing for an input that does not.
+function testFuzzer(module, ctx) {
+  const proc = ctx.add_processor_by_type('p16f887', 'fuzzed');
+  const words = new Array(0x1a).fill(0);
+  words[0] = 0x2800;  // loop: goto loop
+  words.splice(0x10, 10,
+    0x0064, 0x304F, 0x0620,  // check: clrwdt; movlw 'O'; xorwf 0x20, w
+    0x1D03, 0x0008, 0x304B,  // btfss STATUS, Z; return; movlw 'K'
+    0x0621, 0x1D03, 0x0008,  // xorwf 0x21, w; btfss STATUS, Z; return
+    0x2900,                  // goto 0x100
+  );
+  loadWords(proc, words);
+  runFromReset(module, proc, 10, []);
+
+  // Fuzzer::Finding.
+  const INVALID_INSTRUCTION = 1 << 1;
+
+  const fz = new module.Fuzzer(proc, { address: 0x20, routine: 0x10, maxCycles: 200, maxInput: 8 });
+  try {
+    for (let i = 0; i < 100 && fz.crashes.size() === 0; ++i) {
+      fz.fuzz(1000);
+    }
+    const crashes = fz.crashes;
+    assert(crashes.size() > 0, `found no crash in ${fz.executions} executions`);
+    const crash = crashes.get(0);
+    assert(crash.input.startsWith('OK'), `crashed on ${JSON.stringify(crash.input)}`);
+    assert(crash.findings & INVALID_INSTRUCTION, `findings ${crash.findings}`);
+    assert(fz.corpus.size() > 1 && fz.edges > 0, `${fz.corpus.size()} corpus entries, ${fz.edges} edges`);
+
+    assert(fz.runCase('OX') === 0, 'no findings for a rejected input');
+  } finally {
+    fz.delete();
+  }
+}
+
+// Every instruction is counted in one execute batch, and every cycle
+// break set in the delay histogram. TMR0 at 1:1 sets its overflow
+// break 256 cycles ahead.
+function testMetrics(module, ctx) {
+  const proc = ctx.add_processor_by_type('p16f887', 'metered');
+  loadWords(proc, [
+    0x1683, 0x3008, 0x0081,  // bsf STATUS, RP0; movlw 0x08 (TMR0 1:1); movwf OPTION_REG
+    0x1283, 0x0AA2, 0x2804,  // bcf STATUS, RP0; loop: incf 0x22, f; goto loop
+  ]);
+  proc.reset(module.RESET_TYPE.POR_RESET);
+
+  module.metrics_reset();
+  proc.step_cycles(10000);
+  const metrics = module.metrics_snapshot();
+
+  const instructions = metrics.instructions.metered;
+  const batches = metrics.histograms.batch_instructions;
+  assert(instructions > 6000, `executed ${instructions} instructions`);
+  assert(batches.sum === instructions, `${batches.sum} instructions in batches`);
+
+  const sum = (values) => values.reduce((a, b) => a + b, 0);
+  const delays = metrics.histograms.break_delay_cycles;
+  const set = sum(Object.values(metrics.breaks).map(events => events.set));
+  assert(sum(delays.buckets) === set, `${sum(delays.buckets)} delays for ${set} breaks`);
+
+  // Bucket 8 holds delays from 129 to 256 cycles.
+  const overflows = metrics.breaks.TMR0.set;
+  assert(overflows >= 39 && delays.buckets[8] >= overflows, `${overflows} TMR0 breaks, ${delays.buckets[8]} in bucket 8`);
+
+  assert(module.metrics_prometheus().includes(`gpsim_batch_instructions_sum ${instructions}`), 'exported the batch sum');
+}
+
+// A new processor adds registers and pins to the heap, its report
+// counts the instructions loaded into it, and the report of the whole
+// simulation includes it.
+function testMemoryReport(module, ctx) {
+  const before = module.memory_allocated();
+  const proc = ctx.add_processor_by_type('p16f84', 'accounted');
+  const allocated = module.memory_allocated();
+  for (const category of ['registers', 'pins']) {
+    assert(allocated[category].objects > before[category].objects, `allocated ${category}`);
+  }
+
+  const empty = proc.memory_report();
+  loadWords(proc, [0x0AA2, 0x2006, 0x0822]);
+  const report = proc.memory_report();
+  assert(report.instructions.objects === empty.instructions.objects + 3, 'accounted the loaded instructions');
+  assert(report.pins.objects >= 18, `accounted ${report.pins.objects} pins`);
+
+  const all = module.memory_report();
+  const categories = Object.keys(report).filter(category => category !== 'total');
+  for (const key of ['objects', 'bytes']) {
+    const total = categories.reduce((n, category) => n + report[category][key], 0);
+    assert(report.total[key] === total, `total ${key} ${report.total[key]} != ${total}`);
+
+    for (const category of categories) {
+      assert(all[category][key] >= report[category][key], `simulation ${category} ${key} include the processor`);
+    }
+  }
+}
+
+// The frame output mode ends with the segments the LCD has when it
+// drives its pins phase by phase, and hands them to the sink.
+function testLcdFrames(module, ctx) {
+  const words = [
+    0x1703, 0x30FF, 0x009C,  // bsf STATUS, RP1; movlw 0xFF; movwf LCDSE0
+    0x300F, 0x009D, 0x3093,  // movlw 0x0F; movwf LCDSE1; movlw 0x93 (LCDEN, VLCDEN, 1/4 mux)
+    0x0087, 0x3055, 0x0090,  // movwf LCDCON; movlw 0x55; movwf LCDDATA0
+    0x3003, 0x0094, 0x280B,  // movlw 0x03; movwf LCDDATA4; loop: goto loop
+  ];
+  const segments = (proc) => range(0, 4).map(com => proc.get_lcd_module().get_segments(com));
+
+  const phases = ctx.add_processor_by_type('p16f917', 'lcd_phases');
+  loadWords(phases, words);
+  runFromReset(module, phases, 20000, []);
+  const expected = segments(phases);
+  assertSameState(expected, [0x55, 0x300, 0, 0], 'segments driven phase by phase');
+
+  const FrameSink = module.LCDFrameSink.extend('FrameSink', {
+    __construct() {
+      this.__parent.__construct.call(this);
+      this.frames = [];
+    },
+
+    setFrame(segments) {
+      this.frames.push(segments);
+    },
+  });
+
+  const framed = ctx.add_processor_by_type('p16f917', 'lcd_frames');
+  loadWords(framed, words);
+  const lcd = framed.get_lcd_module();
+  const sink = new FrameSink();
+  try {
+    lcd.set_frame_sink(sink);
+    runFromReset(module, framed, 20000, []);
+    assertSameState(segments(framed), expected, 'segments in frame mode');
+    assertSameState(sink.frames[sink.frames.length - 1], expected, 'last frame');
+  } finally {
+    lcd.set_frame_sink(null);
+    sink.delete();
+  }
+}
+
+// Stepping back stops after the last change of a peripheral's cycle
+// break, here a TMR0 overflow, and running forward again from there
+// reaches the same state.
+function testReverseBreak(module, ctx) {
+  const proc = ctx.add_processor_by_type('p16f887', 'timed');
+  loadWords(proc, [
+    0x1683, 0x3008, 0x0081,  // bsf STATUS, RP0; movlw 0x08 (TMR0 1:1); movwf OPTION_REG
+    0x1283, 0x0AA2, 0x2804,  // bcf STATUS, RP0; loop: incf 0x22, f; goto loop
+  ]);
+  const addresses = [0x22, 0x01];  // And TMR0.
+
+  assert(proc.enable_reverse(true), 'reverse stepping is supported');
+  const after = runFromReset(module, proc, 1000, addresses);
+  const start = module.get_cycles() - after.cycles;
+
+  let steps = 0;
+  while (proc.step_back(1) === 1) {
+    ++steps;
+  }
+  const back = module.get_cycles() - start;
+  assert(steps > 0 && back > after.cycles - 256, `stepped back ${steps} instructions, to cycle ${back}`);
+
+  proc.step_cycles(after.cycles - back);
+  assertSameState(processorState(module, proc, addresses, start), after, 'stepped forward again');
+
+  proc.enable_reverse(false);
+}
+
+// The line table maps each address to the line findLinesByAddr()
+// returns first, and findLocation() agrees with both, also past the
+// end of the table.
+function testLineTable(prog) {
+  const table = prog.lineTable();
+  const refs = vectorToArray(prog.lineRefs);
+  assert(refs.length > 0 && table.line.length > 0, 'the program has a line table');
+
+  const end = Math.max(table.line.length, ...refs.map(ref => ref.address + 1)) + 1;
+  for (let addr = 0; addr < end; ++addr) {
+    const lines = vectorToArray(prog.findLinesByAddr(addr));
+    const expected = lines.length ? { file: lines[0].file, line: lines[0].line } : { file: undefined, line: 0 };
+
+    const loc = prog.findLocation(addr);
+    assertSameState({ file: table.files[loc.file], line: loc.line }, expected, `location of ${addr}`);
+
+    if (addr < table.line.length) {
+      const entry = { file: table.files[table.fileIndex[addr]], line: table.line[addr] };
+      assertSameState(entry, expected, `line table entry ${addr}`);
+    }
+  }
+}
+
+// A filtered sink receives exactly the entries of an unfiltered one
+// that match its types and address range.
+function testTraceSinks(module, ctx) {
+  const proc = ctx.add_processor_by_type('p16f887', 'filtered');
+  loadWords(proc, [
+    0x0AA2, 0x2006, 0x0822,  // loop: incf 0x22, f; call sub; movf 0x22, w
+    0x07A3, 0x06A4, 0x2800,  // addwf 0x23, f; xorwf 0x24, f; goto loop
+    0x00A4, 0x0AA4, 0x3405,  // sub: movwf 0x24; incf 0x24, f; retlw 5
+  ]);
+  proc.reset(module.RESET_TYPE.POR_RESET);
+
+  const EntrySink = module.TraceSink.extend('EntrySink', {
+    __construct() {
+      this.__parent.__construct.call(this);
+      this.entries = [];
+    },
+
+    consume(batch) {
+      for (; !batch.empty; batch.pop()) {
+        this.entries.push(batch.front());
+      }
+    },
+  });
+  const all = new EntrySink();
+  const filtered = new EntrySink();
+
+  try {
+    assert(module.add_trace_sink(all, {}), 'added the sink');
+    assert(module.add_trace_sink(filtered, {
+      types: [module.TRACE_ENTRY_TYPES.WRITE_REGISTER],
+      minAddress: 0x23,
+      maxAddress: 0x24,
+      batchSize: 7,
+    }), 'added the filtered sink');
+    try {
+      proc.step_cycles(5000);
+    } finally {
+      module.remove_trace_sink(filtered);
+      module.remove_trace_sink(all);
+    }
+
+    const expected = all.entries.filter(e => e.type === 'writeRegister' && e.address >= 0x23 && e.address <= 0x24);
+    assert(expected.length > 0, 'wrote the registers');
+    assertSameState(filtered.entries, expected, 'filtered entries');
+  } finally {
+    filtered.delete();
+    all.delete();
+  }
+}
+
+// A recorded trace file decodes to the entries written to the trace
+// buffer, from the start and after seeking to a cycle.
+function testTraceFile(module, ctx) {
+  const proc = ctx.add_processor_by_type('p16f887', 'recorded');
+  loadWords(proc, [
+    0x0AA2, 0x2006, 0x0822,  // loop: incf 0x22, f; call sub; movf 0x22, w
+    0x07A3, 0x06A4, 0x2800,  // addwf 0x23, f; xorwf 0x24, f; goto loop
+    0x00A4, 0x0AA4, 0x3405,  // sub: movwf 0x24; incf 0x24, f; retlw 5
+  ]);
+  proc.reset(module.RESET_TYPE.POR_RESET);
+
+  const written = [];
+  const CollectingSink = module.TraceSink.extend('CollectingSink', {
+    consume(batch) {
+      for (; !batch.empty; batch.pop()) {
+        written.push(batch.front());
+      }
+    },
+  });
+  const sink = new CollectingSink();
+  const path = '/recorded.gtr';
+
+  const rec = new module.TraceRecorder();
+  const reader = new module.TraceFileReader();
+  try {
+    rec.open(path, 1000);
+    const start = module.get_cycles();
+    assert(module.add_trace_sink(sink, {}), 'added the sink');
+    try {
+      proc.step_cycles(30000);
+      rec.close();
+    } finally {
+      module.remove_trace_sink(sink);
+    }
+
+    const readAll = () => {
+      const entries = [];
+      for (let e; (e = reader.next()) !== undefined;) {
+        entries.push(e);
+      }
+      return entries;
+    };
+
+    reader.open(path);
+    assert(reader.indexed, 'the file has an index');
+    assert(reader.numChunks > 1, `the file has ${reader.numChunks} chunks`);
+
+    // The recorder starts with a stamp of its own.
+    const all = readAll();
+    assertSameState(all[0], { type: 'cycleCounter', cycle: start }, 'first stamp');
+    assertSameState(all.slice(1), written, 'decoded file');
+
+    reader.seek(start + 20000);
+    const tail = readAll();
+    assert(tail[0].type === 'cycleCounter' && tail[0].cycle <= start + 20000 && tail[0].cycle > start + 18000,
+           `seeked to the stamp at ${tail[0].cycle}`);
+    const at = written.findIndex(e => e.type === 'cycleCounter' && e.cycle === tail[0].cycle);
+    assert(at >= 0, 'the stamp was written');
+    assertSameState(tail, written.slice(at), 'decoded file after seeking');
+  } finally {
+    reader.delete();
+    rec.delete();
+    sink.delete();
+  }
+}
+
+// Co-simulated processors end in the same state on one thread or
+// several, in one window per call or in lockstep, one cycle at a time.
+function testCoSimulation(module) {
+  const counter = [
+    0x1683, 0x0186, 0x1283,  // bsf STATUS, RP0; clrf TRISB; bcf STATUS, RP0
+    0x0A86, 0x2803,          // loop: incf PORTB, f; goto loop
+  ];
+  const summer = [
+    0x1683, 0x1703, 0x0189,  // bsf STATUS, RP0; bsf STATUS, RP1; clrf ANSELH
+    0x1283, 0x1303, 0x0806,  // bcf STATUS, RP0; bcf STATUS, RP1; loop: movf PORTB, w
+    0x07A1, 0x0DA1, 0x2805,  // addwf 0x21, f; rlf 0x21, f; goto loop
+  ];
+  const end = 20e9;       // 20 ms.
+  const cycle = 200000;   // At 20 MHz.
+  let runs = 0;
+
+  const run = (threads, steps) => {
+    const sim = new module.CoSimulation(threads);
+    try {
+      const a = sim.add_processor('p16f887', `counter${runs}`);
+      const b = sim.add_processor('p16f887', `summer${runs++}`);
+      loadWords(a, counter);
+      loadWords(b, summer);
+
+      assert(sim.connect(a, 33, b, 33, 2 * cycle) === null, 'latency of two cycles rejected');
+      for (const pin of range(33, 41)) {
+        assert(sim.connect(a, pin, b, pin, 5 * cycle), `connected pin ${pin}`);
+      }
+
+      for (let i = 1; i <= steps; ++i) {
+        sim.run_until(Math.floor(end * i / steps));
+      }
+      return {
+        time: sim.time_ps(),
+        cycles: [sim.cycles(a), sim.cycles(b)],
+        sum: b.get_register(0x21).get_value(),
+      };
+    } finally {
+      sim.delete();
+    }
+  };
+
+  const single = run(1, 1);
+  assert(single.sum !== 0, 'the summer saw the counter');
+  assertSameState(run(4, 1), single, 'four threads');
+  assertSameState(run(4, 7), single, 'four threads in seven calls');
+  assertSameState(run(1, end / cycle), single, 'lockstep');
+}
+
 gpsimLoad().then(async module => {
     const gpsim = {
         gpsimInterface: {
@@ -282,6 +860,10 @@ AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=`, 'base64');
             console.log('Line refs:', vectorToArray(prog.lineRefs).map(ref => ({ addr: ref.address, file: ref.file, line: ref.line })));
             console.log('Symbols:', vectorToArray(prog.symbols).map(sym => ({ type: sym.type, name: sym.name, value: sym.value })));
 
+            const lineTable = prog.lineTable();
+            console.log('Line table:', lineTable.files, lineTable.line.length, 'addresses');
+            testLineTable(prog);
+
             const proc = ctx.add_processor_by_type(prog.targetProcessorType, 'aproc');
 
             prog.upload(proc);
@@ -303,6 +885,29 @@ AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA=`, 'base64');
                 console.log('  ', trace.front());
                 trace.pop();
             }
+
+            // Global symbols with periods in their names resolve by
+            // their full name, not as a module scope.
+            const symbols = ctx.GetSymbolTable();
+            for (const name of ['sim.verbosity', 'stopwatch.rollover', 'stopwatch.enable']) {
+                const sym = symbols.find(name);
+                assert(sym && sym.name() === name, `symbol ${name} resolves`);
+            }
+
+            testTranslation(module, ctx);
+            testFastForward(module, ctx);
+            testRowRewrite(module, ctx);
+            testReverse(module, ctx);
+            testReverseBreak(module, ctx);
+            testCoverage(module, ctx);
+            testFunctionCall(module, ctx);
+            testFuzzer(module, ctx);
+            testMetrics(module, ctx);
+            testMemoryReport(module, ctx);
+            testLcdFrames(module, ctx);
+            testTraceSinks(module, ctx);
+            testTraceFile(module, ctx);
+            testCoSimulation(module);
         } finally {
             sim.remove_interface(iface.get_id());
         }
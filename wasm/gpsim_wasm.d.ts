@@ -7,14 +7,96 @@ export default function(opts: {
 interface GPSIMModule {
   RESET_TYPE: typeof RESET_TYPE;
   REGISTER_TYPES: REGISTER_TYPES;
+  TRACE_ENTRY_TYPES: typeof TRACE_ENTRY_TYPES;
 
   Interface: EmConstructor<Interface>;
   SignalSink: EmConstructor<SignalSink>;
+  LCDFrameSink: EmConstructor<LCDFrameSink>;
+  TraceSink: EmConstructor<TraceSink>;
   ProcessorConstructor: typeof ProcessorConstructor;
   Program: typeof Program;
+  Assertions: typeof Assertions;
+  Coverage: typeof Coverage;
+  FunctionCall: typeof FunctionCall;
+  Fuzzer: typeof Fuzzer;
+  FuzzerInjection: typeof FuzzerInjection;
 
   get_interface(): gpsimInterface;
   initialize_gpsim_core(): void;
+
+  // The current value of the cycle counter.
+  get_cycles(): number;
+
+  // Runtime metrics of the simulator, see src/util/metrics.h.
+  metrics_snapshot(): MetricsSnapshot;
+  metrics_prometheus(): string;
+  metrics_reset(): void;
+
+  // Subscribes to the entries written to the global trace buffer, see
+  // src/trace.h. set_trace_types() selects the types the buffer keeps.
+  add_trace_sink(sink: TraceSink, filter: TraceSinkFilter): boolean;
+  remove_trace_sink(sink: TraceSink): void;
+  flush_trace_sinks(): void;
+  set_trace_types(types: TRACE_ENTRY_TYPES[]): void;
+
+  // Memory of the simulation, see src/util/memory.h. The report walks
+  // all modules, while allocated counts the live heap objects of the
+  // process.
+  memory_report(): MemoryReport;
+  memory_allocated(): MemoryReport;
+}
+
+interface MetricsSnapshot {
+  // E.g. pin_updates, trace_entries and wasm_calls_in.
+  counters: Record<string, number>;
+
+  // Instructions executed, by core name.
+  instructions: Record<string, number>;
+
+  // Cycle counter breaks, by TriggerObject class name.
+  breaks: Record<string, { set: number, cleared: number, fired: number }>;
+
+  // Bucket i counts values up to 2**i, and the last one the rest.
+  histograms: Record<string, { buckets: number[], sum: number }>;
+}
+
+interface MemoryUsage {
+  objects: number;
+  bytes: number;
+}
+
+interface MemoryReport {
+  registers: MemoryUsage;
+  instructions: MemoryUsage;
+  pins: MemoryUsage;
+  stimulus_nodes: MemoryUsage;
+  symbols: MemoryUsage;
+  values: MemoryUsage;
+  trace: MemoryUsage;
+  total: MemoryUsage;
+}
+
+interface TraceSinkFilter {
+  // All types if not set.
+  types?: TRACE_ENTRY_TYPES[];
+
+  // Register and PC entries outside the range are dropped.
+  minAddress?: number;
+  maxAddress?: number;
+
+  batchSize?: number;
+}
+
+declare enum TRACE_ENTRY_TYPES {
+  CYCLE_COUNTER,
+  READ_REGISTER,
+  WRITE_REGISTER,
+  SET_PC,
+  INCREMENT_PC,
+  SKIP_PC,
+  BRANCH_PC,
+  INTERRUPT,
+  RESET,
 }
 
 declare enum RESET_TYPE {
@@ -46,6 +128,19 @@ declare abstract class SignalSink extends EmObject {
   release(): void;
 }
 
+// Bit s of segments[c] is set if segment s is on for common c. It is
+// called when the segments change at the end of a frame.
+declare abstract class LCDFrameSink extends EmObject {
+  setFrame(segments: number[]): void;
+}
+
+declare class LCD_MODULE extends EmObject {
+  // Frame output mode: the pins are only driven phase by phase while
+  // a node or an analog sink observes them. Null switches it off.
+  set_frame_sink(sink: LCDFrameSink | null): void;
+  get_segments(com: number): number;
+}
+
 declare class PinMonitor extends EmObject {
   addSignalSink(s: SignalSink): void;
 }
@@ -78,6 +173,9 @@ declare class Register extends Value {
 declare class Module extends gpsimObject {
   get_pin_count(): number;
   get_pin(num: number): IOPIN | null;
+
+  // The module, and for processors their registers and program memory.
+  memory_report(): MemoryReport;
 }
 
 declare class Processor extends Module {
@@ -88,29 +186,55 @@ declare class Processor extends Module {
   init_program_memory_at_index(addr: number, data: Uint8Array): void;
   reset(type: RESET_TYPE): void;
   step(cond: StepCondition): void;
+  step_cycles(ncycles: number): void;
+  set_fast_forward(enable: boolean): void;
+  enable_translation(enable: boolean): boolean;
+  enable_reverse(enable: boolean): boolean;
+  step_back(steps: number): number;
+  continue_back(address: number): number;
 }
 
 type StepCondition = ((step: number) => boolean) | number | { numSteps?: number };
 
 declare class pic_processor extends Processor {
   Wget(): number;
+  get_lcd_module(): LCD_MODULE | null;
 }
 
 declare class ProcessorConstructor extends EmObject {
   ConstructProcessor(name: string): Processor;
   names: EmVector<string>;
+
+  // The processor family, e.g. "p16f88x". With the split library, it
+  // is a side module, gpsim_<family>.so, and ConstructProcessor()
+  // only loads it synchronously under Node.js, or if it is already in
+  // the file system. In browsers, load() fetches it first.
+  family: string;
+  isLoaded: boolean;
+  load(onload: () => void, onerror: (err: Error) => void): void;
   static findByType(type: string): ProcessorConstructor | null;
   static GetList(): EmVector<ProcessorConstructor>;
 }
 
+interface SymbolExport {
+  generation: number;
+  names: string[];
+  addresses: Int32Array;  // Register address, or -1.
+  types: Uint8Array;  // 0 other, 1 register, 2 value, 3 module.
+}
+
 declare class SymbolTable_t extends EmObject {
   findSymbol(name: string): gpsimObject | null;
+  findPrefix(prefix: string, maxCount: number): EmVector<string>;
+  exportSymbols(): SymbolExport;
+  readonly generation: number;
   symbols: string[];
 }
 
 declare class SymbolTable extends EmObject {
   find(name: string): gpsimObject | null;
   findSymbolTable(name: string): SymbolTable_t | null;
+  readonly generation: number;
   modules: string[];
 }
 
@@ -137,6 +261,11 @@ declare class TraceReader extends EmObject {
   pop(): void;
 }
 
+// The batch is only valid during the call.
+declare abstract class TraceSink extends EmObject {
+  consume(batch: TraceReader): void;
+}
+
 interface EmptyEntry {
   type: 'empty';
 }
@@ -208,9 +337,105 @@ declare class Program extends EmObject {
   symbols: EmVector<SourceSymbol>;
 
   findLinesByAddr(addr: number): EmVector<SourceLineRef>;
+  lineTable(): LineTable;
   upload(p: Processor): void;
 }
 
+// Source lines by address. files[fileIndex[addr]] and line[addr] give
+// the location of the address, or fileIndex[addr] is -1. Addresses past
+// the end need findLinesByAddr.
+interface LineTable {
+  files: string[];
+  fileIndex: Int32Array;
+  line: Int32Array;
+}
+
+declare class AssertionFailure extends EmObject {
+  address: number;
+  cycle: number;
+  text: string;
+  message: string;
+  file: string;
+  line: number;
+}
+
+declare class Assertions extends EmObject {
+  constructor();
+  readonly size: number;
+  readonly halted: boolean;
+  readonly failures: EmVector<AssertionFailure>;
+
+  attach(p: Processor, prog: Program): void;
+  detach(): void;
+  setHaltOnFailure(halt: boolean): void;
+  resume(): void;
+  clearFailures(): void;
+}
+
+declare class Coverage extends EmObject {
+  constructor();
+
+  attach(p: Processor): void;
+  detach(): void;
+  clear(): void;
+  save(): Uint8Array;
+  merge(data: Uint8Array): void;
+  lcov(prog: Program, testName: string): string;
+  cobertura(prog: Program): string;
+}
+
+declare class FunctionCall extends EmObject {
+  constructor(p: pic_processor);
+
+  snapshot(): void;
+  restore(): void;
+  setRegister(address: number, value: number): void;
+  getRegister(address: number): number;
+  setW(value: number): void;
+  getW(): number;
+  call(address: number, maxCycles: number): void;
+  callSymbol(prog: Program, name: string, maxCycles: number): void;
+  readonly cycles: number;
+}
+
+declare enum FuzzerInjection {
+  INJECT_REGISTERS,
+  INJECT_UART,
+  INJECT_CALLBACK,
+}
+
+interface FuzzerOptions {
+  injection?: FuzzerInjection;
+  address?: number;
+  lengthAddress?: number;
+  routine?: number;
+  maxCycles?: number;
+  byteCycles?: number;
+  maxInput?: number;
+  seed?: number;
+  corpusDir?: string;
+}
+
+declare class FuzzerCrash extends EmObject {
+  readonly input: Uint8Array;
+  readonly findings: number;
+}
+
+declare class Fuzzer extends EmObject {
+  constructor(p: pic_processor, opts: FuzzerOptions);
+
+  setAssertions(asserts: Assertions): void;
+  addSeed(input: Uint8Array): void;
+  loadCorpus(): void;
+  runCase(input: Uint8Array): number;
+  readonly newCoverage: boolean;
+  fuzz(executions: number): void;
+  readonly executions: number;
+  readonly edges: number;
+  readonly corpus: EmVector<Uint8Array>;
+  readonly crashes: EmVector<FuzzerCrash>;
+}
+
 //
 // EmBind common types
 //
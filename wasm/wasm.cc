@@ -1,41 +1,72 @@
+#include <config.h>
+
 #include <emscripten/bind.h>
+#include <emscripten/emscripten.h>
+
+#include <dlfcn.h>
 
+#include <memory>
 #include <sstream>
 
+#include "../src/clock_phase.h"
+#include "../src/cosim.h"
 #include "../src/gpsim_interface.h"
+#include "../src/gpsim_time.h"
+#include "../src/lcd_module.h"
 #include "../src/pic-processor.h"
 #include "../src/processor.h"
 #include "../src/stimuli.h"
 #include "../src/trace.h"
+#include "../src/trace_file.h"
 #include "../src/trace_registry.h"
+#include "../src/util/assertions.h"
 #include "../src/util/cod.h"
+#include "../src/util/coverage.h"
+#include "../src/util/function_call.h"
+#include "../src/util/fuzzer.h"
+#include "../src/util/memory.h"
+#include "../src/util/metrics.h"
 #include "../src/util/program.h"
 
 using namespace emscripten;
 
 namespace {
 
+  // Counts calls across the boundary, see util/metrics.h. Calls in are
+  // counted at the entry points JavaScript calls in loops.
+  inline void count_call_in() {
+    util::metrics::count(util::metrics::WASM_CALLS_IN);
+  }
+
+  inline void count_call_out() {
+    util::metrics::count(util::metrics::WASM_CALLS_OUT);
+  }
+
   class InterfaceWrapper : public wrapper<Interface> {
   public:
     EMSCRIPTEN_WRAPPER(InterfaceWrapper);
 
     void SimulationHasStopped(void *obj) override {
+      count_call_out();
       call<void>("SimulationHasStopped");
     }
 
     void NewProcessor(Processor *p) override {
       // Passing a raw pointer makes embind use val::take_ownership,
       // deleting the object when returning.
+      count_call_out();
       call<void>("NewProcessor", val(p));
     }
 
     void NewModule(Module *m) override {
       // Passing a raw pointer makes embind use val::take_ownership,
       // deleting the object when returning.
+      count_call_out();
       call<void>("NewModule", val(m));
     }
 
     void Update(void *obj) override {
+      count_call_out();
       call<void>("Update");
     }
   };
@@ -45,14 +76,43 @@ namespace {
     EMSCRIPTEN_WRAPPER(SignalSinkWrapper);
 
     void setSinkState(char v) {
+      count_call_out();
       call<void>("setSinkState", v);
     }
 
     void release() {
+      count_call_out();
       call<void>("release");
     }
   };
 
+  class TraceSinkWrapper : public wrapper<trace::TraceSink> {
+  public:
+    EMSCRIPTEN_WRAPPER(TraceSinkWrapper);
+
+    // The batch is only valid during the call. As above, it is passed
+    // as a val, so it is not deleted.
+    void consume(trace::TraceReader &batch) override {
+      count_call_out();
+      call<void>("consume", val(&batch));
+    }
+  };
+
+  class LCDFrameSinkWrapper : public wrapper<LCDFrameSink> {
+  public:
+    EMSCRIPTEN_WRAPPER(LCDFrameSinkWrapper);
+
+    void setFrame(unsigned int num_commons, const uint32_t *segments) {
+      val a = val::array();
+
+      for (unsigned int i = 0; i < num_commons; ++i)
+        a.call<void>("push", segments[i]);
+
+      count_call_out();
+      call<void>("setFrame", a);
+    }
+  };
+
   std::string Processor_disasm(const Processor &p, unsigned int address) {
     if (!p.pma) return "";
 
@@ -68,11 +128,18 @@ namespace {
     return p.pc;
   }
 
+  // Null unless the processor is a PIC with an LCD module.
+  LCD_MODULE* Processor_get_lcd_module(Processor &p) {
+    auto *pic = dynamic_cast<pic_processor*>(&p);
+    return pic ? pic->get_lcd_module() : nullptr;
+  }
+
   unsigned int Processor_get_register_count(Processor &p) {
     return p.rma.get_size();
   }
 
   Register* Processor_get_register(Processor &p, unsigned int addr) {
+    count_call_in();
     return p.rma.get_register(addr);
   }
 
@@ -81,8 +148,13 @@ namespace {
   }
 
   void Processor_step(Processor &p, val cond) {
+    count_call_in();
+
     if (cond.instanceof(val::global("Function"))) {
-      p.step([&cond](unsigned int step) { return cond(step).as<bool>(); });
+      p.step([&cond](unsigned int step) {
+        count_call_out();
+        return cond(step).as<bool>();
+      });
       return;
     }
 
@@ -95,6 +167,15 @@ namespace {
     p.step([nsteps](unsigned int step) { return step < nsteps; });
   }
 
+  void Processor_step_cycles(Processor &p, double ncycles) {
+    count_call_in();
+    p.step_cycles(static_cast<uint64_t>(ncycles));
+  }
+
+  void Processor_set_fast_forward(Processor &p, bool enable) {
+    p.mExecute1Cycle->setFastForward(enable);
+  }
+
   std::vector<std::string> ProcessorConstructor_names(const ProcessorConstructor &self) {
     std::vector<std::string> names;
 
@@ -119,12 +200,136 @@ namespace {
     return cons->ConstructProcessor(name.c_str());
   }
 
+  std::string ProcessorConstructor_family(const ProcessorConstructor &self) {
+    return self.family ? self.family : "";
+  }
+
+  bool ProcessorConstructor_isLoaded(const ProcessorConstructor &self) {
+    return self.isLoaded();
+  }
+
+#ifdef GPSIM_LAZY_PROCESSORS
+  // The side module of a family, see family.cc.
+  std::string family_module(const char *family) {
+    return std::string("gpsim_") + family + ".so";
+  }
+
+  // Synchronous loading only works if the side module is already in
+  // the file system, or under Node.js. Browsers use
+  // ProcessorConstructor.load() first.
+  bool load_family(const char *family) {
+    return dlopen(family_module(family).c_str(), RTLD_NOW | RTLD_GLOBAL) != nullptr;
+  }
+
+  struct FamilyLoaderInit {
+    FamilyLoaderInit() {
+      ProcessorConstructor::set_family_loader(load_family);
+    }
+  } family_loader_init;
+
+  struct LoadCallbacks {
+    val onload;
+    val onerror;
+    std::string module;
+  };
+#endif
+
+  void ProcessorConstructor_load(ProcessorConstructor &self, val onload, val onerror) {
+    if (self.isLoaded()) {
+      onload();
+      return;
+    }
+
+#ifdef GPSIM_LAZY_PROCESSORS
+    if (self.family) {
+      // Dependencies of the side module are fetched along with it.
+      auto *cbs = new LoadCallbacks{ onload, onerror, family_module(self.family) };
+
+      emscripten_dlopen(
+        cbs->module.c_str(), RTLD_NOW | RTLD_GLOBAL, cbs,
+        [](void *arg, void *handle) {
+          std::unique_ptr<LoadCallbacks> cbs(static_cast<LoadCallbacks *>(arg));
+          cbs->onload();
+        },
+        [](void *arg) {
+          std::unique_ptr<LoadCallbacks> cbs(static_cast<LoadCallbacks *>(arg));
+          cbs->onerror(val::global("Error").new_("unable to load " + cbs->module));
+        });
+      return;
+    }
+#endif
+
+    onerror(val::global("Error").new_(std::string("no processor family to load")));
+  }
+
   std::vector<std::string> SymbolTable_t_symbols(const SymbolTable_t &t) {
     std::vector<std::string> names;
     const_cast<SymbolTable_t&>(t).ForEachSymbol([&names](const SymbolEntry_t &entry) { names.push_back(entry.first); });
     return names;
   }
 
+  std::vector<std::string> SymbolTable_t_find_prefix(const SymbolTable_t &t, const std::string &prefix, unsigned int max_count) {
+    std::vector<std::string> names;
+    for (const auto &sym : t.findPrefix(prefix, max_count)) {
+      names.emplace_back(sym.first);
+    }
+    return names;
+  }
+
+  enum SymbolType : uint8_t {
+    SYMBOL_OTHER,
+    SYMBOL_REGISTER,
+    SYMBOL_VALUE,
+    SYMBOL_MODULE,
+  };
+
+  // Copies all symbols into one array of names and typed arrays of
+  // register addresses (or -1) and SymbolTypes. The UI caches the
+  // result until the generation changes.
+  val SymbolTable_t_export_symbols(const SymbolTable_t &t) {
+    auto syms = t.findPrefix({});
+    val names = val::array();
+    std::vector<int32_t> addresses;
+    std::vector<uint8_t> types;
+
+    addresses.reserve(syms.size());
+    types.reserve(syms.size());
+
+    for (const auto &sym : syms) {
+      names.call<void>("push", std::string(sym.first));
+
+      if (auto *reg = dynamic_cast<Register*>(sym.second)) {
+        addresses.push_back(reg->getAddress());
+        types.push_back(SYMBOL_REGISTER);
+      } else {
+        addresses.push_back(-1);
+
+        if (dynamic_cast<Module*>(sym.second))
+          types.push_back(SYMBOL_MODULE);
+        else if (dynamic_cast<Value*>(sym.second))
+          types.push_back(SYMBOL_VALUE);
+        else
+          types.push_back(SYMBOL_OTHER);
+      }
+    }
+
+    val o = val::object();
+    o.set("generation", static_cast<double>(t.generation()));
+    o.set("names", names);
+    o.set("addresses", val(typed_memory_view(addresses.size(), addresses.data())).call<val>("slice"));
+    o.set("types", val(typed_memory_view(types.size(), types.data())).call<val>("slice"));
+
+    return o;
+  }
+
+  double SymbolTable_t_generation(const SymbolTable_t &t) {
+    return t.generation();
+  }
+
+  double SymbolTable_generation(const SymbolTable &t) {
+    return t.generation();
+  }
+
   std::vector<std::string> SymbolTable_modules(const SymbolTable &t) {
     std::vector<std::string> names;
     const_cast<SymbolTable&>(t).ForEachModule([&names](const SymbolTableEntry_t &entry) { names.push_back(entry.first); });
@@ -136,8 +341,13 @@ namespace {
   }
 
   void gpsimInterface_step_simulation(gpsimInterface &iface, val cond) {
+    count_call_in();
+
     if (cond.instanceof(val::global("Function"))) {
-      iface.step_simulation([&cond](unsigned int step) { return cond(step).as<bool>(); });
+      iface.step_simulation([&cond](unsigned int step) {
+        count_call_out();
+        return cond(step).as<bool>();
+      });
       return;
     }
 
@@ -158,12 +368,11 @@ namespace {
     return &get_interface();
   }
 
-  val TraceReader_front(const trace::TraceReader &reader) {
-    if (reader.empty()) return val::undefined();
-
-    auto ref = reader.front();
-    auto e = trace::EntryRegistry::parse(ref);
+  double get_cycles_wrapper() {
+    return static_cast<double>(get_cycles().get());
+  }
 
+  val TraceEntry_to_val(const trace::EntryRegistry::variant &e) {
     val o = val::object();
 
     std::visit([&o](auto &&e) {
@@ -218,6 +427,40 @@ namespace {
     return o;
   }
 
+  val TraceReader_front(const trace::TraceReader &reader) {
+    count_call_in();
+
+    if (reader.empty()) return val::undefined();
+
+    return TraceEntry_to_val(trace::EntryRegistry::parse(reader.front()));
+  }
+
+  bool add_trace_sink(trace::TraceSink *sink, val opts) {
+    trace::SinkFilter f;
+
+    if (opts.hasOwnProperty("types")) {
+      val types = opts["types"];
+
+      f.types = 0;
+      for (unsigned int i = 0, n = types["length"].as<unsigned int>(); i < n; ++i)
+        f.types |= trace::type_mask(types[i].as<trace::EntryTypes>());
+    }
+    if (opts.hasOwnProperty("minAddress")) f.min_address = opts["minAddress"].as<unsigned int>();
+    if (opts.hasOwnProperty("maxAddress")) f.max_address = opts["maxAddress"].as<unsigned int>();
+    if (opts.hasOwnProperty("batchSize")) f.batch_size = opts["batchSize"].as<unsigned int>();
+
+    return trace::add_sink(sink, f);
+  }
+
+  void set_trace_types(val types) {
+    uint32_t mask = 0;
+
+    for (unsigned int i = 0, n = types["length"].as<unsigned int>(); i < n; ++i)
+      mask |= trace::type_mask(types[i].as<trace::EntryTypes>());
+
+    trace::set_global_types(mask);
+  }
+
   std::unique_ptr<util::Program> Program_constructor(const std::string &data) {
     auto prog = std::make_unique<util::Program>();
     std::istringstream is(data);
@@ -260,6 +503,269 @@ namespace {
     return refs;
   }
 
+  // Copies the line table into typed arrays, so JS can map addresses
+  // to source lines without a call per address.
+  val Program_line_table(const util::Program &prog) {
+    val files = val::array();
+    for (const auto &file : prog.line_files()) {
+      files.call<void>("push", std::string(file));
+    }
+
+    const auto &file_index = prog.line_table_files();
+    const auto &lines = prog.line_table_lines();
+
+    val o = val::object();
+    o.set("files", files);
+    o.set("fileIndex", val(typed_memory_view(file_index.size(), file_index.data())).call<val>("slice"));
+    o.set("line", val(typed_memory_view(lines.size(), lines.data())).call<val>("slice"));
+
+    return o;
+  }
+
+  // The file is an index into lineTable().files, or -1.
+  val Program_find_location(const util::Program &prog, unsigned int addr) {
+    util::SourceLocation loc = prog.find_location(addr);
+
+    val o = val::object();
+    o.set("file", loc.file);
+    o.set("line", loc.line);
+
+    return o;
+  }
+
+  void Assertions_attach(util::Assertions &asserts, Processor *p, const util::Program &prog) {
+    if (int err = asserts.attach(p, prog); err) {
+      std::ostringstream os;
+      os << "Attaching assertions failed: " << err;
+      val::global("Error").new_(os.str()).throw_();
+      return;
+    }
+  }
+
+  void Coverage_attach(util::Coverage &cov, Processor *p) {
+    if (int err = cov.attach(p); err) {
+      std::ostringstream os;
+      os << "Attaching coverage failed: " << err;
+      val::global("Error").new_(os.str()).throw_();
+    }
+  }
+
+  val Coverage_flags(const util::Coverage &cov) {
+    const auto &flags = cov.flags();
+    return val(typed_memory_view(flags.size(), flags.data())).call<val>("slice");
+  }
+
+  util::u8string Coverage_save(const util::Coverage &cov) {
+    std::ostringstream os;
+    cov.write(&os);
+    auto s = os.str();
+    return util::u8string(s.begin(), s.end());
+  }
+
+  void Coverage_merge(util::Coverage &cov, const util::u8string &data) {
+    std::istringstream is(std::string(data.begin(), data.end()));
+
+    if (int err = cov.read(&is); err) {
+      std::ostringstream os;
+      os << "Merging coverage failed: " << err;
+      val::global("Error").new_(os.str()).throw_();
+    }
+  }
+
+  std::string Coverage_lcov(const util::Coverage &cov, const util::Program &prog, const std::string &test_name) {
+    std::ostringstream os;
+    cov.write_lcov(&os, prog, test_name);
+    return os.str();
+  }
+
+  std::string Coverage_cobertura(const util::Coverage &cov, const util::Program &prog) {
+    std::ostringstream os;
+    cov.write_cobertura(&os, prog);
+    return os.str();
+  }
+
+  // Processors of types without bindings reach JS as Processor, so
+  // functions for PICs take one and check it.
+  pic_processor* Processor_as_pic(Processor *p) {
+    auto *pic = dynamic_cast<pic_processor*>(p);
+
+    if (!pic) {
+      val::global("Error").new_(std::string("Not a PIC processor")).throw_();
+      return nullptr;
+    }
+
+    return pic;
+  }
+
+  util::FunctionCall* FunctionCall_constructor(Processor *p) {
+    return new util::FunctionCall(Processor_as_pic(p));
+  }
+
+  void FunctionCall_check(int err, const char *what) {
+    if (err) {
+      std::ostringstream os;
+      os << what << " failed: " << err;
+      val::global("Error").new_(os.str()).throw_();
+    }
+  }
+
+  void FunctionCall_call(util::FunctionCall &fc, unsigned int address, double max_cycles) {
+    FunctionCall_check(fc.call(address, static_cast<uint64_t>(max_cycles)), "Calling routine");
+  }
+
+  void FunctionCall_call_symbol(util::FunctionCall &fc, const util::Program &prog, const std::string &name, double max_cycles) {
+    FunctionCall_check(fc.call(prog, name, static_cast<uint64_t>(max_cycles)), "Calling routine");
+  }
+
+  util::Fuzzer* Fuzzer_constructor(Processor *p, val opts) {
+    util::Fuzzer::Options o;
+
+    if (opts.hasOwnProperty("injection")) o.injection = opts["injection"].as<util::Fuzzer::Injection>();
+    if (opts.hasOwnProperty("address")) o.address = opts["address"].as<unsigned int>();
+    if (opts.hasOwnProperty("lengthAddress")) o.length_address = opts["lengthAddress"].as<unsigned int>();
+    if (opts.hasOwnProperty("routine")) o.routine = opts["routine"].as<unsigned int>();
+    if (opts.hasOwnProperty("maxCycles")) o.max_cycles = static_cast<uint64_t>(opts["maxCycles"].as<double>());
+    if (opts.hasOwnProperty("byteCycles")) o.byte_cycles = static_cast<uint64_t>(opts["byteCycles"].as<double>());
+    if (opts.hasOwnProperty("maxInput")) o.max_input = opts["maxInput"].as<unsigned int>();
+    if (opts.hasOwnProperty("seed")) o.seed = opts["seed"].as<unsigned int>();
+    if (opts.hasOwnProperty("corpusDir")) o.corpus_dir = opts["corpusDir"].as<std::string>();
+
+    return new util::Fuzzer(Processor_as_pic(p), o);
+  }
+
+  void Fuzzer_load_corpus(util::Fuzzer &fz) {
+    FunctionCall_check(fz.load_corpus(), "Loading corpus");
+  }
+
+  void Fuzzer_fuzz(util::Fuzzer &fz, double executions) {
+    FunctionCall_check(fz.fuzz(static_cast<uint64_t>(executions)), "Fuzzing");
+  }
+
+  Processor* CoSimulation_add_processor(CoSimulation &sim, const std::string &type, const std::string &name) {
+    return sim.add_processor(type.c_str(), name.c_str());
+  }
+
+  CoSimChannel* CoSimulation_connect(CoSimulation &sim, Processor *from, unsigned int from_pin,
+                                     Processor *to, unsigned int to_pin, double latency_ps) {
+    return sim.connect(from, from_pin, to, to_pin, static_cast<uint64_t>(latency_ps));
+  }
+
+  void CoSimulation_run_until(CoSimulation &sim, double time_ps) {
+    count_call_in();
+    sim.run_until(static_cast<uint64_t>(time_ps));
+  }
+
+  double CoSimulation_cycles(CoSimulation &sim, Processor *cpu) {
+    Cycle_Counter *cycles = sim.cycles(cpu);
+    return cycles ? static_cast<double>(cycles->get()) : -1;
+  }
+
+  void TraceRecorder_open(trace::TraceRecorder &rec, const std::string &path, double stamp_interval) {
+    FunctionCall_check(rec.open(path, static_cast<uint64_t>(stamp_interval)), "Opening trace file");
+  }
+
+  void TraceRecorder_close(trace::TraceRecorder &rec) {
+    FunctionCall_check(rec.close(), "Writing trace file");
+  }
+
+  void TraceFileReader_open(trace::TraceFileReader &reader, const std::string &path) {
+    FunctionCall_check(reader.open(path), "Opening trace file");
+  }
+
+  void TraceFileReader_seek(trace::TraceFileReader &reader, double cycle) {
+    FunctionCall_check(reader.seek(static_cast<uint64_t>(cycle)), "Seeking in trace file");
+  }
+
+  val TraceFileReader_next(trace::TraceFileReader &reader) {
+    count_call_in();
+
+    trace::EntryRegistry::variant entry{trace::UnknownEntry(trace::BASE)};
+    if (!reader.next(&entry)) return val::undefined();
+
+    return TraceEntry_to_val(entry);
+  }
+
+  val metrics_snapshot() {
+    using namespace util::metrics;
+
+    Snapshot s = collect();
+    val o = val::object();
+    val counters = val::object();
+    val instructions = val::object();
+    val breaks = val::object();
+    val histograms = val::object();
+
+    for (unsigned int i = 0; i < NUM_COUNTERS; ++i)
+      counters.set(name(Counter(i)), double(s.counters[i]));
+
+    for (const auto &c : s.instructions)
+      instructions.set(c.first, double(c.second));
+
+    for (const auto &b : s.breaks) {
+      val events = val::object();
+
+      for (unsigned int i = 0; i < NUM_BREAK_EVENTS; ++i)
+        events.set(name(BreakEvent(i)), double(b.second[i]));
+
+      breaks.set(b.first, events);
+    }
+
+    for (unsigned int h = 0; h < NUM_HISTOGRAMS; ++h) {
+      val hist = val::object();
+      val buckets = val::array();
+
+      for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; ++i)
+        buckets.call<void>("push", double(s.buckets[h][i]));
+
+      hist.set("buckets", buckets);
+      hist.set("sum", double(s.sums[h]));
+      histograms.set(name(Histogram(h)), hist);
+    }
+
+    o.set("counters", counters);
+    o.set("instructions", instructions);
+    o.set("breaks", breaks);
+    o.set("histograms", histograms);
+
+    return o;
+  }
+
+  std::string metrics_prometheus() {
+    return util::metrics::prometheus();
+  }
+
+  val memory_report_object(const util::memory::Report &r) {
+    using namespace util::memory;
+
+    val o = val::object();
+    auto usage = [](const Usage &u) {
+      val v = val::object();
+
+      v.set("objects", double(u.objects));
+      v.set("bytes", double(u.bytes));
+      return v;
+    };
+
+    for (unsigned int i = 0; i < NUM_CATEGORIES; ++i)
+      o.set(name(Category(i)), usage(r.usage[i]));
+
+    o.set("total", usage(r.total()));
+
+    return o;
+  }
+
+  val Module_memory_report(Module &m) {
+    return memory_report_object(util::memory::account(&m));
+  }
+
+  val memory_report() {
+    return memory_report_object(util::memory::account_all());
+  }
+
+  val memory_allocated() {
+    return memory_report_object(util::memory::allocated());
+  }
+
   EMSCRIPTEN_BINDINGS(libgpsim) {
     enum_<RESET_TYPE>("RESET_TYPE")
       .value("EXIT_RESET", RESET_TYPE::EXIT_RESET)
@@ -267,6 +773,17 @@ namespace {
       .value("POR_RESET", RESET_TYPE::POR_RESET)
       .value("SIM_RESET", RESET_TYPE::SIM_RESET);
 
+    enum_<trace::EntryTypes>("TRACE_ENTRY_TYPES")
+      .value("CYCLE_COUNTER", trace::CYCLE_COUNTER)
+      .value("READ_REGISTER", trace::READ_REGISTER)
+      .value("WRITE_REGISTER", trace::WRITE_REGISTER)
+      .value("SET_PC", trace::SET_PC)
+      .value("INCREMENT_PC", trace::INCREMENT_PC)
+      .value("SKIP_PC", trace::SKIP_PC)
+      .value("BRANCH_PC", trace::BRANCH_PC)
+      .value("INTERRUPT", trace::INTERRUPT)
+      .value("RESET", trace::RESET);
+
     enum_<Register::REGISTER_TYPES>("REGISTER_TYPES")
       .value("INVALID_REGISTER", Register::INVALID_REGISTER)
       .value("GENERIC_REGISTER", Register::GENERIC_REGISTER)
@@ -312,7 +829,8 @@ namespace {
 
     class_<Module, base<gpsimObject>>("Module")
       .function("get_pin_count", &Module::get_pin_count)
-      .function("get_pin", &Module::get_pin, allow_raw_pointers());
+      .function("get_pin", &Module::get_pin, allow_raw_pointers())
+      .function("memory_report", &Module_memory_report);
 
     class_<Processor, base<Module>>("Processor")
       .function("GetProgramCounter", &Processor_GetProgramCounter, allow_raw_pointers())
@@ -321,24 +839,48 @@ namespace {
       .function("get_register", &Processor_get_register, allow_raw_pointers())
       .function("init_program_memory_at_index", Processor_init_program_memory_at_index)
       .function("reset", &Processor::reset)
-      .function("step", &Processor_step);
+      .function("step", &Processor_step)
+      .function("step_cycles", &Processor_step_cycles)
+      .function("set_fast_forward", &Processor_set_fast_forward)
+      .function("enable_translation", &Processor::enable_translation)
+      .function("enable_reverse", &Processor::enable_reverse)
+      .function("step_back", &Processor::step_back)
+      .function("continue_back", &Processor::continue_back)
+      .function("get_lcd_module", &Processor_get_lcd_module, allow_raw_pointers());
 
     class_<pic_processor, base<Processor>>("pic_processor")
       .function("Wget", &pic_processor::Wget);
 
+    class_<trace::TraceSink>("TraceSink")
+      .allow_subclass<TraceSinkWrapper>("TraceSinkWrapper", constructor<>());
+
+    class_<LCDFrameSink>("LCDFrameSink")
+      .allow_subclass<LCDFrameSinkWrapper>("LCDFrameSinkWrapper", constructor<>());
+
+    class_<LCD_MODULE>("LCD_MODULE")
+      .function("set_frame_sink", &LCD_MODULE::set_frame_sink, allow_raw_pointers())
+      .function("get_segments", &LCD_MODULE::get_segments);
+
     class_<ProcessorConstructor>("ProcessorConstructor")
       .function("ConstructProcessor", &ProcessorConstructor_ConstructProcessor, allow_raw_pointers())
+      .function("load", &ProcessorConstructor_load)
       .property("names", &ProcessorConstructor_names)
+      .property("family", &ProcessorConstructor_family)
+      .property("isLoaded", &ProcessorConstructor_isLoaded)
       .class_function("findByType", &ProcessorConstructor_findByType, allow_raw_pointers())
       .class_function("GetList", ProcessorConstructor_GetList);
 
     class_<SymbolTable_t>("SymbolTable_t")
       .function("findSymbol", &SymbolTable_t::findSymbol, allow_raw_pointers())
+      .function("findPrefix", &SymbolTable_t_find_prefix)
+      .function("exportSymbols", &SymbolTable_t_export_symbols)
+      .property("generation", &SymbolTable_t_generation)
       .property("symbols", &SymbolTable_t_symbols);
 
     class_<SymbolTable>("SymbolTable")
       .function("find", &SymbolTable::find, allow_raw_pointers())
       .function("findSymbolTable", &SymbolTable::findSymbolTable, allow_raw_pointers())
+      .property("generation", &SymbolTable_generation)
       .property("modules", &SymbolTable_modules);
 
     class_<CSimulationContext>("CSimulationContext")
@@ -363,6 +905,42 @@ namespace {
       .function("front", &TraceReader_front)
       .function("pop", &trace::TraceReader::pop);
 
+    class_<trace::TraceRecorder>("TraceRecorder")
+      .constructor()
+      .function("open", &TraceRecorder_open)
+      .function("close", &TraceRecorder_close)
+      .function("flush", &trace::TraceRecorder::flush)
+      .property("isOpen", &trace::TraceRecorder::is_open)
+      .property("entries", std::function([](const trace::TraceRecorder &rec) {
+        return static_cast<double>(rec.entries());
+      }))
+      .property("bytes", std::function([](const trace::TraceRecorder &rec) {
+        return static_cast<double>(rec.bytes());
+      }));
+
+    class_<trace::TraceFileReader>("TraceFileReader")
+      .constructor()
+      .function("open", &TraceFileReader_open)
+      .function("close", &trace::TraceFileReader::close)
+      .function("seek", &TraceFileReader_seek)
+      .function("next", &TraceFileReader_next)
+      .property("cycle", std::function([](const trace::TraceFileReader &reader) {
+        return static_cast<double>(reader.cycle());
+      }))
+      .property("firstCycle", std::function([](const trace::TraceFileReader &reader) {
+        return static_cast<double>(reader.first_cycle());
+      }))
+      .property("lastCycle", std::function([](const trace::TraceFileReader &reader) {
+        return static_cast<double>(reader.last_cycle());
+      }))
+      .property("numChunks", std::function([](const trace::TraceFileReader &reader) {
+        return static_cast<unsigned int>(reader.num_chunks());
+      }))
+      .property("indexed", &trace::TraceFileReader::indexed)
+      .property("lost", std::function([](const trace::TraceFileReader &reader) {
+        return static_cast<double>(reader.lost());
+      }));
+
     class_<util::CodeRange>("CodeRange")
       .property("address", std::function([](const util::CodeRange &r) {
         return static_cast<unsigned int>(r.addr);
@@ -409,19 +987,130 @@ namespace {
       .property("symbols", &util::Program::symbols)
       .function("upload", &Program_upload, allow_raw_pointers())
       .function("findLinesByAddr", &Program_find_lines_by_addr)
+      .function("lineTable", &Program_line_table)
+      .function("findLocation", &Program_find_location)
       .property("targetProcessorType", std::function([](const util::Program &p) {
         return std::string(p.target_processor_type());
       }));
 
+    class_<util::AssertionFailure>("AssertionFailure")
+      .property("address", std::function([](const util::AssertionFailure &f) {
+        return static_cast<unsigned int>(f.addr);
+      }))
+      .property("cycle", std::function([](const util::AssertionFailure &f) {
+        return static_cast<double>(f.cycle);
+      }))
+      .property("text", &util::AssertionFailure::text)
+      .property("message", &util::AssertionFailure::message)
+      .property("file", std::function([](const util::AssertionFailure &f) {
+        return f.line ? std::string(f.line->file) : std::string();
+      }))
+      .property("line", std::function([](const util::AssertionFailure &f) {
+        return f.line ? f.line->line : 0;
+      }));
+
+    class_<util::Assertions>("Assertions")
+      .constructor()
+      .function("attach", &Assertions_attach, allow_raw_pointers())
+      .function("detach", &util::Assertions::detach)
+      .property("size", &util::Assertions::size)
+      .function("setHaltOnFailure", &util::Assertions::set_halt_on_failure)
+      .property("halted", &util::Assertions::halted)
+      .function("resume", &util::Assertions::resume)
+      .property("failures", &util::Assertions::failures)
+      .function("clearFailures", &util::Assertions::clear_failures);
+
+    class_<util::Coverage>("Coverage")
+      .constructor()
+      .function("attach", &Coverage_attach, allow_raw_pointers())
+      .function("detach", &util::Coverage::detach)
+      .function("clear", &util::Coverage::clear)
+      .function("flags", &Coverage_flags)
+      .function("save", &Coverage_save)
+      .function("merge", &Coverage_merge)
+      .function("lcov", &Coverage_lcov)
+      .function("cobertura", &Coverage_cobertura);
+
+    class_<util::FunctionCall>("FunctionCall")
+      .constructor(&FunctionCall_constructor, allow_raw_pointers())
+      .function("snapshot", &util::FunctionCall::snapshot)
+      .function("restore", &util::FunctionCall::restore)
+      .function("setRegister", &util::FunctionCall::set_register)
+      .function("getRegister", &util::FunctionCall::get_register)
+      .function("setW", &util::FunctionCall::set_w)
+      .function("getW", &util::FunctionCall::get_w)
+      .function("call", &FunctionCall_call)
+      .function("callSymbol", &FunctionCall_call_symbol)
+      .property("cycles", std::function([](const util::FunctionCall &fc) {
+        return static_cast<double>(fc.cycles());
+      }));
+
+    enum_<util::Fuzzer::Injection>("FuzzerInjection")
+      .value("INJECT_REGISTERS", util::Fuzzer::INJECT_REGISTERS)
+      .value("INJECT_UART", util::Fuzzer::INJECT_UART)
+      .value("INJECT_CALLBACK", util::Fuzzer::INJECT_CALLBACK);
+
+    class_<util::Fuzzer::Crash>("FuzzerCrash")
+      .property("input", &util::Fuzzer::Crash::input)
+      .property("findings", &util::Fuzzer::Crash::findings);
+
+    class_<util::Fuzzer>("Fuzzer")
+      .constructor(&Fuzzer_constructor, allow_raw_pointers())
+      .function("setAssertions", &util::Fuzzer::set_assertions, allow_raw_pointers())
+      .function("addSeed", &util::Fuzzer::add_seed)
+      .function("loadCorpus", &Fuzzer_load_corpus)
+      .function("runCase", &util::Fuzzer::run_case)
+      .property("newCoverage", &util::Fuzzer::new_coverage)
+      .function("fuzz", &Fuzzer_fuzz)
+      .property("executions", std::function([](const util::Fuzzer &fz) {
+        return static_cast<double>(fz.executions());
+      }))
+      .property("edges", std::function([](const util::Fuzzer &fz) {
+        return static_cast<unsigned int>(fz.edges());
+      }))
+      .property("corpus", &util::Fuzzer::corpus)
+      .property("crashes", &util::Fuzzer::crashes);
+
+    class_<CoSimChannel>("CoSimChannel")
+      .property("latency", std::function([](const CoSimChannel &ch) {
+        return static_cast<double>(ch.latency());
+      }));
+
+    class_<CoSimulation>("CoSimulation")
+      .constructor<unsigned int>()
+      .function("add_processor", &CoSimulation_add_processor, allow_raw_pointers())
+      .function("connect", &CoSimulation_connect, allow_raw_pointers())
+      .function("run_until", &CoSimulation_run_until)
+      .function("time_ps", optional_override([](CoSimulation &sim) {
+        return static_cast<double>(sim.time_ps());
+      }))
+      .function("cycles", &CoSimulation_cycles, allow_raw_pointers())
+      .class_function("uart_latency", optional_override([](unsigned int baud) {
+        return static_cast<double>(CoSimulation::uart_latency(baud));
+      }));
+
     register_vector<ProcessorConstructor *>("ProcessorConstructorList");
     register_vector<std::string>("StringVector");
     register_vector<util::CodeRange>("CodeRangeVector");
     register_vector<util::SourceDirective>("SourceDirectiveVector");
     register_vector<util::SourceLineRef>("SourceLineRefVector");
     register_vector<util::SourceSymbol>("SourceSymbolVector");
+    register_vector<util::AssertionFailure>("AssertionFailureVector");
+    register_vector<util::Fuzzer::Crash>("FuzzerCrashVector");
+    register_vector<util::u8string>("U8StringVector");
 
     function("initialize_gpsim_core", initialize_gpsim_core);
     function("get_interface", get_interface_wrapper, allow_raw_pointers());
+    function("get_cycles", get_cycles_wrapper);
+    function("metrics_snapshot", metrics_snapshot);
+    function("metrics_prometheus", metrics_prometheus);
+    function("metrics_reset", util::metrics::reset);
+    function("add_trace_sink", add_trace_sink, allow_raw_pointers());
+    function("remove_trace_sink", trace::remove_sink, allow_raw_pointers());
+    function("flush_trace_sinks", trace::flush_sinks);
+    function("set_trace_types", set_trace_types);
+    function("memory_report", memory_report);
+    function("memory_allocated", memory_allocated);
   }
 
 }